@@ -2,12 +2,18 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <limits>
 #include <stdexcept>
 #include <vector>
 
 namespace deep_compositor {
 
+/**
+ * Object / material id of a sample whose source is unknown (or that hit nothing)
+ */
+constexpr uint32_t kNoId = std::numeric_limits<uint32_t>::max();
+
 /**
  * A single deep sample containing depth and premultiplied RGBA values
  */
@@ -19,6 +25,11 @@ struct DeepSample {
     float blue;        // Premultiplied blue
     float alpha;       // Coverage/opacity
 
+    // Optional metadata, stored in the objectId / materialId / sampleCount channels when set
+    uint32_t object_id = kNoId;    // Object the sample came from
+    uint32_t material_id = kNoId;  // Material the sample came from
+    uint32_t sample_count = 0;     // Camera samples merged into this one, 0 if unknown
+
     DeepSample() : depth(0.0f), depth_back(0.0f), red(0.0f), green(0.0f), blue(0.0f), alpha(0.0f) {}
 
     // Zero-thickness convenience constructor (depth_back = depth)
@@ -104,7 +115,7 @@ class DeepPixel {
     void sortByDepth();
 
     /**
-     * Merge samples that are within epsilon depth of each other
+     * Merge samples that are within epsilon depth of each other and come from the same object
      */
     void mergeSamplesWithinEpsilon(float epsilon = 0.001f);
 
@@ -198,6 +209,14 @@ class DeepImage {
      */
     void clear();
 
+    /**
+     * Move a smaller image's pixels into this one with its top-left corner at (x, y),
+     * replacing what was there. Samples are moved as they are, not re-sorted or merged.
+     *
+     * @throws std::out_of_range if the region does not fit inside this image
+     */
+    void placeRegion(DeepImage&& region, int x, int y);
+
   private:
     int width_;
     int height_;
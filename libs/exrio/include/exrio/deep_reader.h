@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "deep_image.h"
 
@@ -42,4 +43,36 @@ bool isDeepEXR(const std::string& filename);
  */
 bool getDeepEXRInfo(const std::string& filename, int& width, int& height, bool& isDeep);
 
+/**
+ * Where a deep EXR's pixels sit in its frame: the data window within the display window.
+ * A full-frame render has min_x = min_y = 0 and the same size as its display window.
+ */
+struct DeepEXRWindow {
+    int display_width = 0;
+    int display_height = 0;
+    int min_x = 0;  // Data window origin, relative to the display window's
+    int min_y = 0;
+    int width = 0;  // Data window size
+    int height = 0;
+};
+
+/**
+ * Get the display and data windows of an EXR file without loading its pixels
+ *
+ * @param filename Path to the EXR file
+ * @param window Output: the file's windows
+ * @return true if the header was read successfully
+ */
+bool getDeepEXRWindow(const std::string& filename, DeepEXRWindow& window);
+
+/**
+ * Stitch deep EXRs that each hold one region of the same frame into a full-frame DeepImage.
+ * Each region's samples are copied into place unchanged; pixels no region covers stay empty.
+ *
+ * @param filenames Region files; all must share one display window
+ * @return DeepImage the size of the display window
+ * @throws DeepReaderException on file errors, mismatched frames or overlapping regions
+ */
+DeepImage loadDeepEXRRegions(const std::vector<std::string>& filenames);
+
 }  // namespace deep_compositor
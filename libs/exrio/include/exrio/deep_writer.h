@@ -16,7 +16,8 @@ class DeepWriterException : public std::runtime_error {
 };
 
 /**
- * Write a deep image to an OpenEXR file
+ * Write a deep image to an OpenEXR file. The objectId / materialId and sampleCount UINT
+ * channels are only written when some sample sets them.
  *
  * @param img The deep image to write
  * @param filename Output path
@@ -1,6 +1,7 @@
 #include <exrio/deep_image.h>
 
 #include <sstream>
+#include <utility>
 
 namespace deep_compositor {
 
@@ -44,11 +45,14 @@ void DeepPixel::mergeSamplesWithinEpsilon(float epsilon) {
         float avgDepthBack = current.depth_back;
         int count = 1;
 
-        // Merge with subsequent samples within epsilon
+        // Merge with subsequent samples within epsilon. Samples of different objects stay
+        // apart so ids survive for holdouts.
         while (i + 1 < samples_.size() && samples_[i + 1].depth - current.depth < epsilon &&
-               std::abs(samples_[i + 1].depth_back - current.depth_back) < epsilon) {
+               std::abs(samples_[i + 1].depth_back - current.depth_back) < epsilon &&
+               samples_[i + 1].object_id == current.object_id) {
             i++;
             const DeepSample& next = samples_[i];
+            current.sample_count += next.sample_count;
 
             // Accumulate for averaging
             totalAlpha += next.alpha;
@@ -219,4 +223,17 @@ void DeepImage::clear() {
     }
 }
 
+void DeepImage::placeRegion(DeepImage&& region, int x, int y) {
+    if (x < 0 || y < 0 || x + region.width_ > width_ || y + region.height_ > height_) {
+        throw std::out_of_range("Region does not fit inside the image");
+    }
+
+    for (int ry = 0; ry < region.height_; ++ry) {
+        for (int rx = 0; rx < region.width_; ++rx) {
+            pixels_[index(x + rx, y + ry)] = std::move(region.pixels_[region.index(rx, ry)]);
+        }
+    }
+    region.clear();
+}
+
 }  // namespace deep_compositor
@@ -47,6 +47,29 @@ bool getDeepEXRInfo(const std::string& filename, int& width, int& height, bool&
     }
 }
 
+bool getDeepEXRWindow(const std::string& filename, DeepEXRWindow& window) {
+    try {
+        Imf::MultiPartInputFile file(filename.c_str());
+        if (file.parts() < 1) {
+            return false;
+        }
+
+        const Imf::Header& header = file.header(0);
+        const Imath::Box2i& display = header.displayWindow();
+        const Imath::Box2i& data = header.dataWindow();
+        window.display_width = display.max.x - display.min.x + 1;
+        window.display_height = display.max.y - display.min.y + 1;
+        window.min_x = data.min.x - display.min.x;
+        window.min_y = data.min.y - display.min.y;
+        window.width = data.max.x - data.min.x + 1;
+        window.height = data.max.y - data.min.y + 1;
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 DeepImage loadDeepEXR(const std::string& filename) {
     logVerbose("  Opening: " + filename);
 
@@ -87,6 +110,9 @@ DeepImage loadDeepEXR(const std::string& filename) {
     bool hasA = channels.findChannel("A") != nullptr;
     bool hasZ = channels.findChannel("Z") != nullptr;
     bool hasZBack = channels.findChannel("ZBack") != nullptr;
+    bool hasObjectId = channels.findChannel("objectId") != nullptr;
+    bool hasMaterialId = channels.findChannel("materialId") != nullptr;
+    bool hasWeight = channels.findChannel("sampleCount") != nullptr;
 
     if (!hasR || !hasG || !hasB || !hasA || !hasZ) {
         std::string missing;
@@ -112,6 +138,9 @@ DeepImage loadDeepEXR(const std::string& filename) {
     std::vector<float*> aPtrs(sampleCounts.size(), nullptr);
     std::vector<float*> zPtrs(sampleCounts.size(), nullptr);
     std::vector<float*> zBackPtrs(sampleCounts.size(), nullptr);
+    std::vector<unsigned int*> objectIdPtrs(sampleCounts.size(), nullptr);
+    std::vector<unsigned int*> materialIdPtrs(sampleCounts.size(), nullptr);
+    std::vector<unsigned int*> weightPtrs(sampleCounts.size(), nullptr);
 
     // Use one persistent frame buffer lifecycle: set once, then read sample
     // counts and deep samples. This avoids version-specific state resets.
@@ -160,6 +189,17 @@ DeepImage loadDeepEXR(const std::string& filename) {
                                           sizeof(float*), sizeof(float*) * width, sizeof(float)));
     }
 
+    // Optional metadata channels, read as UINT whatever their stored type
+    auto insertUintSlice = [&](const char* name, std::vector<unsigned int*>& ptrs) {
+        char* base = reinterpret_cast<char*>(ptrs.data() - minX - static_cast<long>(minY) * width);
+        frameBuffer.insert(name, Imf::DeepSlice(Imf::UINT, base, sizeof(unsigned int*),
+                                                sizeof(unsigned int*) * width,
+                                                sizeof(unsigned int)));
+    };
+    if (hasObjectId) insertUintSlice("objectId", objectIdPtrs);
+    if (hasMaterialId) insertUintSlice("materialId", materialIdPtrs);
+    if (hasWeight) insertUintSlice("sampleCount", weightPtrs);
+
     file->setFrameBuffer(frameBuffer);
 
     // Read sample counts
@@ -180,6 +220,9 @@ DeepImage loadDeepEXR(const std::string& filename) {
     std::vector<float> aData(totalSamples);
     std::vector<float> zData(totalSamples);
     std::vector<float> zBackData(hasZBack ? totalSamples : 0);
+    std::vector<unsigned int> objectIdData(hasObjectId ? totalSamples : 0);
+    std::vector<unsigned int> materialIdData(hasMaterialId ? totalSamples : 0);
+    std::vector<unsigned int> weightData(hasWeight ? totalSamples : 0);
 
     // Set up pointers into the contiguous arrays
     size_t offset = 0;
@@ -191,6 +234,9 @@ DeepImage loadDeepEXR(const std::string& filename) {
             aPtrs[i] = aData.data() + offset;
             zPtrs[i] = zData.data() + offset;
             if (hasZBack) zBackPtrs[i] = zBackData.data() + offset;
+            if (hasObjectId) objectIdPtrs[i] = objectIdData.data() + offset;
+            if (hasMaterialId) materialIdPtrs[i] = materialIdData.data() + offset;
+            if (hasWeight) weightPtrs[i] = weightData.data() + offset;
             offset += sampleCounts[i];
         } else {
             rPtrs[i] = nullptr;
@@ -199,6 +245,9 @@ DeepImage loadDeepEXR(const std::string& filename) {
             aPtrs[i] = nullptr;
             zPtrs[i] = nullptr;
             if (hasZBack) zBackPtrs[i] = nullptr;
+            objectIdPtrs[i] = nullptr;
+            materialIdPtrs[i] = nullptr;
+            weightPtrs[i] = nullptr;
         }
     }
 
@@ -222,6 +271,9 @@ DeepImage loadDeepEXR(const std::string& filename) {
                     sample.green = gPtrs[pixelIndex][s];
                     sample.blue = bPtrs[pixelIndex][s];
                     sample.alpha = aPtrs[pixelIndex][s];
+                    if (hasObjectId) sample.object_id = objectIdPtrs[pixelIndex][s];
+                    if (hasMaterialId) sample.material_id = materialIdPtrs[pixelIndex][s];
+                    if (hasWeight) sample.sample_count = weightPtrs[pixelIndex][s];
 
                     pixel.addSample(sample);
                 }
@@ -238,4 +290,52 @@ DeepImage loadDeepEXR(const std::string& filename) {
     return result;
 }
 
+DeepImage loadDeepEXRRegions(const std::vector<std::string>& filenames) {
+    if (filenames.empty()) {
+        throw DeepReaderException("No region files to stitch");
+    }
+
+    DeepImage frame;
+    std::vector<bool> covered;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        const std::string& filename = filenames[i];
+
+        DeepEXRWindow window;
+        if (!getDeepEXRWindow(filename, window)) {
+            throw DeepReaderException("Failed to read EXR header: " + filename);
+        }
+        if (i == 0) {
+            frame.resize(window.display_width, window.display_height);
+            covered.assign(static_cast<size_t>(frame.width()) * frame.height(), false);
+        } else if (window.display_width != frame.width() ||
+                   window.display_height != frame.height()) {
+            throw DeepReaderException("Region is from a different frame size: " + filename);
+        }
+        if (window.min_x < 0 || window.min_y < 0 ||
+            window.min_x + window.width > frame.width() ||
+            window.min_y + window.height > frame.height()) {
+            throw DeepReaderException("Region lies outside its frame: " + filename);
+        }
+
+        for (int y = window.min_y; y < window.min_y + window.height; ++y) {
+            for (int x = window.min_x; x < window.min_x + window.width; ++x) {
+                const size_t index = static_cast<size_t>(y) * frame.width() + x;
+                if (covered[index]) {
+                    throw DeepReaderException("Region overlaps an earlier one at (" +
+                                              std::to_string(x) + ", " + std::to_string(y) +
+                                              "): " + filename);
+                }
+                covered[index] = true;
+            }
+        }
+
+        logVerbose("  Region " + std::to_string(window.width) + "x" +
+                   std::to_string(window.height) + " at (" + std::to_string(window.min_x) + ", " +
+                   std::to_string(window.min_y) + "): " + filename);
+        frame.placeRegion(loadDeepEXR(filename), window.min_x, window.min_y);
+    }
+
+    return frame;
+}
+
 }  // namespace deep_compositor
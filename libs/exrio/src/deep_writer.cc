@@ -102,16 +102,31 @@ void writeDeepEXR(const DeepImage& img, const std::string& filename) {
     // Prepare sample count array
     std::vector<unsigned int> sampleCounts(static_cast<size_t>(width) * height);
 
-    // Count total samples
+    // Count total samples, and find out which metadata channels carry anything
     size_t totalSamples = 0;
+    bool hasIds = false;
+    bool hasWeights = false;
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
             size_t idx = static_cast<size_t>(y) * width + x;
-            sampleCounts[idx] = static_cast<unsigned int>(img.pixel(x, y).sampleCount());
+            const DeepPixel& pixel = img.pixel(x, y);
+            sampleCounts[idx] = static_cast<unsigned int>(pixel.sampleCount());
             totalSamples += sampleCounts[idx];
+            for (const DeepSample& sample : pixel.samples()) {
+                hasIds |= sample.object_id != kNoId || sample.material_id != kNoId;
+                hasWeights |= sample.sample_count != 0;
+            }
         }
     }
 
+    if (hasIds) {
+        header.channels().insert("objectId", Imf::Channel(Imf::UINT));
+        header.channels().insert("materialId", Imf::Channel(Imf::UINT));
+    }
+    if (hasWeights) {
+        header.channels().insert("sampleCount", Imf::Channel(Imf::UINT));
+    }
+
     // Allocate sample data arrays
     std::vector<float> rData(totalSamples);
     std::vector<float> gData(totalSamples);
@@ -119,6 +134,9 @@ void writeDeepEXR(const DeepImage& img, const std::string& filename) {
     std::vector<float> aData(totalSamples);
     std::vector<float> zData(totalSamples);
     std::vector<float> zBackData(totalSamples);
+    std::vector<unsigned int> objectIdData(hasIds ? totalSamples : 0);
+    std::vector<unsigned int> materialIdData(hasIds ? totalSamples : 0);
+    std::vector<unsigned int> weightData(hasWeights ? totalSamples : 0);
 
     // Allocate pointer arrays
     std::vector<float*> rPtrs(sampleCounts.size());
@@ -127,6 +145,9 @@ void writeDeepEXR(const DeepImage& img, const std::string& filename) {
     std::vector<float*> aPtrs(sampleCounts.size());
     std::vector<float*> zPtrs(sampleCounts.size());
     std::vector<float*> zBackPtrs(sampleCounts.size());
+    std::vector<unsigned int*> objectIdPtrs(sampleCounts.size(), nullptr);
+    std::vector<unsigned int*> materialIdPtrs(sampleCounts.size(), nullptr);
+    std::vector<unsigned int*> weightPtrs(sampleCounts.size(), nullptr);
 
     // Fill data and set up pointers
     size_t offset = 0;
@@ -142,6 +163,11 @@ void writeDeepEXR(const DeepImage& img, const std::string& filename) {
                 aPtrs[idx] = aData.data() + offset;
                 zPtrs[idx] = zData.data() + offset;
                 zBackPtrs[idx] = zBackData.data() + offset;
+                if (hasIds) {
+                    objectIdPtrs[idx] = objectIdData.data() + offset;
+                    materialIdPtrs[idx] = materialIdData.data() + offset;
+                }
+                if (hasWeights) weightPtrs[idx] = weightData.data() + offset;
 
                 for (size_t s = 0; s < pixel.sampleCount(); ++s) {
                     const DeepSample& sample = pixel[s];
@@ -151,6 +177,11 @@ void writeDeepEXR(const DeepImage& img, const std::string& filename) {
                     aData[offset + s] = sample.alpha;
                     zData[offset + s] = sample.depth;
                     zBackData[offset + s] = sample.depth_back;
+                    if (hasIds) {
+                        objectIdData[offset + s] = sample.object_id;
+                        materialIdData[offset + s] = sample.material_id;
+                    }
+                    if (hasWeights) weightData[offset + s] = sample.sample_count;
                 }
 
                 offset += sampleCounts[idx];
@@ -200,6 +231,26 @@ void writeDeepEXR(const DeepImage& img, const std::string& filename) {
                            Imf::DeepSlice(Imf::FLOAT, reinterpret_cast<char*>(zBackPtrs.data()),
                                           sizeof(float*), sizeof(float*) * width, sizeof(float)));
 
+        if (hasIds) {
+            frameBuffer.insert(
+                "objectId",
+                Imf::DeepSlice(Imf::UINT, reinterpret_cast<char*>(objectIdPtrs.data()),
+                               sizeof(unsigned int*), sizeof(unsigned int*) * width,
+                               sizeof(unsigned int)));
+            frameBuffer.insert(
+                "materialId",
+                Imf::DeepSlice(Imf::UINT, reinterpret_cast<char*>(materialIdPtrs.data()),
+                               sizeof(unsigned int*), sizeof(unsigned int*) * width,
+                               sizeof(unsigned int)));
+        }
+        if (hasWeights) {
+            frameBuffer.insert(
+                "sampleCount",
+                Imf::DeepSlice(Imf::UINT, reinterpret_cast<char*>(weightPtrs.data()),
+                               sizeof(unsigned int*), sizeof(unsigned int*) * width,
+                               sizeof(unsigned int)));
+        }
+
         outFile.setFrameBuffer(frameBuffer);
         outFile.writePixels(height);
 
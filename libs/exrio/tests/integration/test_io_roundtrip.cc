@@ -119,6 +119,32 @@ TEST_F(IORoundtripTest, WriteAndReadPreservesDepthSortOrder) {
     EXPECT_TRUE(loaded.isValid());
 }
 
+TEST_F(IORoundtripTest, WriteAndReadPreservesIdAndSampleCountChannels) {
+    DeepImage img(2, 1);
+    DeepSample front = makePoint(1.0f, 0.5f, 0.5f, 0.5f, 0.5f);
+    front.object_id = 7;
+    front.material_id = 2;
+    front.sample_count = 12;
+    img.pixel(0, 0).addSample(front);
+    img.pixel(0, 0).addSample(makePoint(2.0f, 0.5f, 0.5f, 0.5f, 0.5f));  // No metadata
+    std::string path = tempPath("ids.exr");
+    DeepImage loaded = roundtrip(img, path);
+    ASSERT_EQ(loaded.pixel(0, 0).sampleCount(), 2u);
+    EXPECT_EQ(loaded.pixel(0, 0)[0].object_id, 7u);
+    EXPECT_EQ(loaded.pixel(0, 0)[0].material_id, 2u);
+    EXPECT_EQ(loaded.pixel(0, 0)[0].sample_count, 12u);
+    EXPECT_EQ(loaded.pixel(0, 0)[1].object_id, kNoId);
+    EXPECT_EQ(loaded.pixel(0, 0)[1].sample_count, 0u);
+}
+
+TEST_F(IORoundtripTest, FilesWithoutIdChannelsLoadWithNoId) {
+    DeepImage img = makeImage1x1(1.0f, 0.5f, 0.5f, 0.5f, 0.8f);
+    DeepImage loaded = roundtrip(img, tempPath("no_ids.exr"));
+    ASSERT_EQ(loaded.pixel(0, 0).sampleCount(), 1u);
+    EXPECT_EQ(loaded.pixel(0, 0)[0].object_id, kNoId);
+    EXPECT_EQ(loaded.pixel(0, 0)[0].material_id, kNoId);
+}
+
 // ============================================================================
 // Error handling tests
 // ============================================================================
@@ -171,3 +171,31 @@ TEST_F(DeepImageTest, MemoryUsageIncreasesWithMoreSamples) {
     size_t after = img.estimatedMemoryUsage();
     EXPECT_GT(after, before);
 }
+
+TEST_F(DeepImageTest, PlaceRegionMovesPixelsToOffset) {
+    DeepImage frame(4, 4);
+    frame.pixel(0, 0).addSample(makeSample(9.0f));
+    frame.pixel(2, 1).addSample(makeSample(9.0f));
+
+    DeepImage region(2, 3);
+    region.pixel(0, 0).addSample(makeSample(1.0f));
+    region.pixel(0, 0).addSample(makeSample(2.0f));
+    region.pixel(1, 2).addSample(makeSample(3.0f));
+
+    frame.placeRegion(std::move(region), 2, 1);
+
+    EXPECT_EQ(frame.pixel(0, 0).sampleCount(), 1u);  // Outside the region: untouched
+    ASSERT_EQ(frame.pixel(2, 1).sampleCount(), 2u);  // Inside: replaced
+    EXPECT_FLOAT_EQ(frame.pixel(2, 1)[0].depth, 1.0f);
+    EXPECT_FLOAT_EQ(frame.pixel(2, 1)[1].depth, 2.0f);
+    ASSERT_EQ(frame.pixel(3, 3).sampleCount(), 1u);
+    EXPECT_FLOAT_EQ(frame.pixel(3, 3)[0].depth, 3.0f);
+    EXPECT_EQ(frame.totalSampleCount(), 4u);
+}
+
+TEST_F(DeepImageTest, PlaceRegionOutsideImageThrows) {
+    DeepImage frame(4, 4);
+    EXPECT_THROW(frame.placeRegion(DeepImage(2, 2), 3, 0), std::out_of_range);
+    EXPECT_THROW(frame.placeRegion(DeepImage(2, 2), 0, -1), std::out_of_range);
+    EXPECT_NO_THROW(frame.placeRegion(DeepImage(4, 4), 0, 0));
+}
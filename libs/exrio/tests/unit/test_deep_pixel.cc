@@ -137,6 +137,27 @@ TEST_F(DeepPixelTest, MergeSamplesDoesNotMergeFarApartSamples) {
     EXPECT_EQ(p.sampleCount(), 2u);
 }
 
+TEST_F(DeepPixelTest, MergeSamplesKeepsObjectsApartAndSumsSampleCounts) {
+    DeepPixel p;
+    DeepSample a1 = makePoint(1.0f, 0.5f, 0.5f, 0.5f, 0.5f);
+    DeepSample a2 = makePoint(1.0002f, 0.5f, 0.5f, 0.5f, 0.5f);
+    DeepSample b = makePoint(1.0004f, 0.5f, 0.5f, 0.5f, 0.5f);
+    a1.object_id = a2.object_id = 3;
+    b.object_id = 4;
+    a1.sample_count = 2;
+    a2.sample_count = 5;
+    b.sample_count = 1;
+    p.addSample(a1);
+    p.addSample(a2);
+    p.addSample(b);
+    p.mergeSamplesWithinEpsilon(0.001f);
+    ASSERT_EQ(p.sampleCount(), 2u);
+    EXPECT_EQ(p[0].object_id, 3u);
+    EXPECT_EQ(p[0].sample_count, 7u);
+    EXPECT_EQ(p[1].object_id, 4u);
+    EXPECT_EQ(p[1].sample_count, 1u);
+}
+
 TEST_F(DeepPixelTest, MergeOnSingleSampleIsNoOp) {
     DeepPixel p;
     p.addSample(makeSample(1.0f, 0.3f, 0.4f, 0.5f, 0.7f));
@@ -47,7 +47,8 @@ std::pair<DeepSample, DeepSample> splitSample(const DeepSample& sample, float z_
     float ratioFront = (alpha > 0.0f) ? alphaFront / alpha : 0.0f;
     float ratioBack = (alpha > 0.0f) ? alphaBack / alpha : 0.0f;
 
-    DeepSample front;
+    // Both halves keep the sample's object / material ids
+    DeepSample front = sample;
     front.depth = sample.depth;
     front.depth_back = z_split;
     front.red = sample.red * ratioFront;
@@ -55,7 +56,7 @@ std::pair<DeepSample, DeepSample> splitSample(const DeepSample& sample, float z_
     front.blue = sample.blue * ratioFront;
     front.alpha = alphaFront;
 
-    DeepSample back;
+    DeepSample back = sample;
     back.depth = z_split;
     back.depth_back = sample.depth_back;
     back.red = sample.red * ratioBack;
@@ -85,6 +86,12 @@ DeepSample blendCoincidentSamples(const DeepSample& a, const DeepSample& b) {
     result.blue = (a.blue + b.blue) * scale;
     result.alpha = alphaCombined;
 
+    // The blend is labelled with whichever input covers more of it
+    const DeepSample& dominant = (b.alpha > a.alpha) ? b : a;
+    result.object_id = dominant.object_id;
+    result.material_id = dominant.material_id;
+    result.sample_count = a.sample_count + b.sample_count;
+
     return result;
 }
 
@@ -22,6 +22,7 @@ struct Options {
     bool pngOutput = true;
     bool verbose = false;
     float mergeThreshold = 0.001f;
+    bool stitch = false;
     bool showHelp = false;
 };
 
@@ -37,6 +38,8 @@ void printUsage(const char* programName) {
               << "  --no-png-output      Don't write PNG preview\n"
               << "  --verbose, -v        Detailed logging\n"
               << "  --merge-threshold N  Depth epsilon for merging samples (default: 0.001)\n"
+              << "  --stitch             Inputs are regions of one frame (skewer-render --crop):\n"
+              << "                       place them side by side instead of merging\n"
               << "  --help, -h           Show this help message\n\n"
               << "Example:\n"
               << "  " << programName << " --deep-output --verbose \\\n"
@@ -69,6 +72,8 @@ bool parseArgs(int argc, char* argv[], Options& opts) {
             opts.flatOutput = true;
         } else if (arg == "--no-flat-output") {
             opts.flatOutput = false;
+        } else if (arg == "--stitch") {
+            opts.stitch = true;
         } else if (arg == "--png-output") {
             opts.pngOutput = true;
         } else if (arg == "--no-png-output") {
@@ -131,75 +136,97 @@ int main(int argc, char* argv[]) {
     Timer totalTimer;
 
     // ========================================================================
-    // Load Phase
+    // Stitch Phase (region inputs)
     // ========================================================================
-    log("Loading inputs...");
-    Timer loadTimer;
+    DeepImage merged;
 
-    std::vector<DeepImage> images;
-    images.reserve(opts.inputFiles.size());
+    if (opts.stitch) {
+        log("Stitching regions...");
+        Timer stitchTimer;
 
-    for (size_t i = 0; i < opts.inputFiles.size(); ++i) {
-        const std::string& filename = opts.inputFiles[i];
+        try {
+            merged = loadDeepEXRRegions(opts.inputFiles);
+        } catch (const DeepReaderException& e) {
+            logError("Failed to stitch regions: " + std::string(e.what()));
+            return 1;
+        }
 
-        logVerbose("  [" + std::to_string(i + 1) + "/" + std::to_string(opts.inputFiles.size()) +
-                   "] " + filename);
+        log("  Frame: " + std::to_string(merged.width()) + "x" + std::to_string(merged.height()) +
+            ", " + formatNumber(merged.totalSampleCount()) + " total samples from " +
+            std::to_string(opts.inputFiles.size()) + " regions");
+        logVerbose("  Stitch time: " + stitchTimer.elapsedString());
+    } else {
+        // ========================================================================
+        // Load Phase
+        // ========================================================================
+        log("Loading inputs...");
+        Timer loadTimer;
 
-        try {
-            // Check if it's a deep EXR
-            if (!isDeepEXR(filename)) {
-                logError("File is not a deep EXR: " + filename);
-                return 1;
-            }
+        std::vector<DeepImage> images;
+        images.reserve(opts.inputFiles.size());
+
+        for (size_t i = 0; i < opts.inputFiles.size(); ++i) {
+            const std::string& filename = opts.inputFiles[i];
+
+            logVerbose("  [" + std::to_string(i + 1) + "/" +
+                       std::to_string(opts.inputFiles.size()) + "] " + filename);
 
-            DeepImage img = loadDeepEXR(filename);
-
-            // Log statistics
-            std::string stats =
-                "    " + std::to_string(img.width()) + "x" + std::to_string(img.height()) + ", " +
-                formatNumber(img.totalSampleCount()) + " total samples (avg " +
-                std::to_string(img.averageSamplesPerPixel()).substr(0, 4) + " samples/pixel)";
-            logVerbose(stats);
-
-            // Validate dimensions match
-            if (!images.empty()) {
-                if (img.width() != images[0].width() || img.height() != images[0].height()) {
-                    logError("Image dimensions mismatch: " + filename);
-                    logError("  Expected: " + std::to_string(images[0].width()) + "x" +
-                             std::to_string(images[0].height()));
-                    logError("  Got: " + std::to_string(img.width()) + "x" +
-                             std::to_string(img.height()));
+            try {
+                // Check if it's a deep EXR
+                if (!isDeepEXR(filename)) {
+                    logError("File is not a deep EXR: " + filename);
                     return 1;
                 }
-            }
 
-            images.push_back(std::move(img));
+                DeepImage img = loadDeepEXR(filename);
+
+                // Log statistics
+                std::string stats =
+                    "    " + std::to_string(img.width()) + "x" + std::to_string(img.height()) +
+                    ", " + formatNumber(img.totalSampleCount()) + " total samples (avg " +
+                    std::to_string(img.averageSamplesPerPixel()).substr(0, 4) + " samples/pixel)";
+                logVerbose(stats);
+
+                // Validate dimensions match
+                if (!images.empty()) {
+                    if (img.width() != images[0].width() || img.height() != images[0].height()) {
+                        logError("Image dimensions mismatch: " + filename);
+                        logError("  Expected: " + std::to_string(images[0].width()) + "x" +
+                                 std::to_string(images[0].height()));
+                        logError("  Got: " + std::to_string(img.width()) + "x" +
+                                 std::to_string(img.height()));
+                        return 1;
+                    }
+                }
 
-        } catch (const DeepReaderException& e) {
-            logError("Failed to load " + filename + ": " + e.what());
-            return 1;
+                images.push_back(std::move(img));
+
+            } catch (const DeepReaderException& e) {
+                logError("Failed to load " + filename + ": " + e.what());
+                return 1;
+            }
         }
-    }
 
-    logVerbose("  Load time: " + loadTimer.elapsedString());
+        logVerbose("  Load time: " + loadTimer.elapsedString());
 
-    // ========================================================================
-    // Merge Phase
-    // ========================================================================
-    log("\nMerging...");
+        // ========================================================================
+        // Merge Phase
+        // ========================================================================
+        log("\nMerging...");
 
-    CompositorOptions compOpts;
-    compOpts.mergeThreshold = opts.mergeThreshold;
-    compOpts.enableMerging = (opts.mergeThreshold > 0.0f);
+        CompositorOptions compOpts;
+        compOpts.mergeThreshold = opts.mergeThreshold;
+        compOpts.enableMerging = (opts.mergeThreshold > 0.0f);
 
-    CompositorStats stats;
+        CompositorStats stats;
 
-    DeepImage merged = deepMerge(images, compOpts, &stats);
+        merged = deepMerge(images, compOpts, &stats);
 
-    log("  Combined: " + formatNumber(stats.totalOutputSamples) + " total samples");
-    log("  Depth range: " + std::to_string(stats.minDepth) + " to " +
-        std::to_string(stats.maxDepth));
-    log("  Merge time: " + std::to_string(static_cast<int>(stats.mergeTimeMs)) + " ms");
+        log("  Combined: " + formatNumber(stats.totalOutputSamples) + " total samples");
+        log("  Depth range: " + std::to_string(stats.minDepth) + " to " +
+            std::to_string(stats.maxDepth));
+        log("  Merge time: " + std::to_string(static_cast<int>(stats.mergeTimeMs)) + " ms");
+    }
 
     // ========================================================================
     // Flatten Phase
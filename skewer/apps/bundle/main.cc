@@ -0,0 +1,72 @@
+#include <io/asset_bundle.h>
+#include <io/obj_loader.h>
+#include <scene/scene.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+void print_usage(const char* program_name) {
+    std::cerr << "Usage:\n";
+    std::cerr << "  " << program_name << " <input.obj> <output.skb> [options]\n";
+    std::cerr << "\n";
+    std::cerr << "Converts an OBJ file, its materials and its textures into a binary bundle that\n";
+    std::cerr << "skewer-render maps directly (use it as an \"obj\" object's \"file\").\n";
+    std::cerr << "\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  --no-auto-fit         Keep raw OBJ coordinates (scene \"auto_fit\": false)\n";
+    std::cerr << "  --spectral-textures   Store albedo textures as rgb2spec coefficients\n";
+    std::cerr << "\n";
+    std::cerr << "Help:\n";
+    std::cerr << "  " << program_name << " --help\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0)) {
+        print_usage(argv[0]);
+        return 0;
+    }
+    if (argc < 3) {
+        std::cerr << "Error: missing input or output file argument\n\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    bool auto_fit = true;
+    bool spectral_textures = false;
+
+    for (int i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "--no-auto-fit") == 0) {
+            auto_fit = false;
+        } else if (strcmp(argv[i], "--spectral-textures") == 0) {
+            spectral_textures = true;
+        } else {
+            std::cerr << "Error: unknown option '" << argv[i] << "'\n\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!skwr::IsBundlePath(output)) {
+        std::cerr << "Error: output file must end in " << skwr::kBundleExtension << "\n";
+        return 1;
+    }
+
+    // Textures stay resident (no cache budget) so their tiles can be copied into the bundle
+    skwr::Scene scene;
+    scene.SetSpectralAlbedoTextures(spectral_textures);
+    if (!skwr::LoadOBJ(input, scene, skwr::Vec3(1.0f, 1.0f, 1.0f), auto_fit)) {
+        std::cerr << "[Error] Failed to load OBJ: " << input << "\n";
+        return 1;
+    }
+    scene.FinishTextureLoads();
+
+    if (!skwr::WriteBundle(output, scene)) {
+        std::cerr << "[Error] Failed to write bundle: " << output << "\n";
+        return 1;
+    }
+
+    return 0;
+}
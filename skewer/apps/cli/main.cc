@@ -1,22 +1,70 @@
+#include <session/chunk_merge.h>
+#include <session/render_options.h>
 #include <session/render_session.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
 
 void print_usage(const char* program_name) {
     std::cerr << "Usage:\n";
-    std::cerr << "  " << program_name << " <scene.json> [num_threads]\n";
+    std::cerr << "  " << program_name << " <scene.json> [num_threads] [--crop X0 Y0 X1 Y1]\n";
+    std::cerr << "      [--chunk START END OUT.exr]\n";
+    std::cerr << "  " << program_name << " --merge OUT.exr CHUNK.exr...\n";
     std::cerr << "\n";
     std::cerr << "Arguments:\n";
     std::cerr << "  scene.json    Path to a JSON scene configuration file (required)\n";
     std::cerr << "  num_threads   Override thread count from scene file (optional)\n";
     std::cerr << "\n";
+    std::cerr << "Scenes with a \"cameras\" list render every camera, each to outputs with its\n";
+    std::cerr << "name before the extension (output.left.ppm, ...). Scenes with an \"animation\"\n";
+    std::cerr << "block render every frame the same way (output.0001.ppm, ...). --crop and\n";
+    std::cerr << "--chunk apply to each of them, and chunks are named the same way\n";
+    std::cerr << "(OUT.left.0001.exr and OUT.left.0001.flat.exr, ...).\n";
+    std::cerr << "\n";
+    std::cerr << "Regions:\n";
+    std::cerr << "  --crop X0 Y0 X1 Y1\n";
+    std::cerr << "                Render only pixels [X0, X1) x [Y0, Y1) of the frame; EXRs get\n";
+    std::cerr << "                it as data window, so loom --stitch can join the regions\n";
+    std::cerr << "\n";
+    std::cerr << "Chunks:\n";
+    std::cerr << "  --chunk START END OUT.exr\n";
+    std::cerr << "                Render only samples [START, END) of the scene's samples per\n";
+    std::cerr << "                pixel and write the un-normalised sums: OUT.flat.exr, plus\n";
+    std::cerr << "                the deep OUT.exr if the scene enables deep output\n";
+    std::cerr << "  --merge OUT.exr CHUNK.exr...\n";
+    std::cerr << "                Sum chunk renders of one frame into OUT.ppm (and the deep\n";
+    std::cerr << "                OUT.exr); identical to rendering all their samples at once\n";
+    std::cerr << "\n";
+    std::cerr << "Environment:\n";
+    std::cerr << "  SKEWER_ISA    Force kernel ISA level: baseline, sse4.2, avx2, avx512\n";
+    std::cerr << "\n";
     std::cerr << "Help:\n";
     std::cerr << "  " << program_name << " --help\n";
 }
 
+static int MergeMain(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Error: --merge needs an output and at least one chunk\n\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    const std::string exr_path = argv[2];
+    const std::string ppm_path = std::filesystem::path(exr_path).replace_extension(".ppm").string();
+    const std::vector<std::string> chunks(argv + 3, argv + argc);
+    try {
+        skwr::MergeChunks(chunks, ppm_path, exr_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[Error] Merge failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     // Parse positional args: <scene.json> [num_threads]
     if (argc < 2) {
@@ -29,27 +77,79 @@ int main(int argc, char* argv[]) {
         print_usage(argv[0]);
         return 0;
     }
+    if (strcmp(argv[1], "--merge") == 0) return MergeMain(argc, argv);
 
     std::string scene_file = argv[1];
     int thread_override = 0;
+    bool chunk = false;
+    int chunk_start = 0;
+    int chunk_end = 0;
+    std::string chunk_file;
 
-    if (argc >= 3) {
-        thread_override = std::atoi(argv[2]);
+    bool crop = false;
+    skwr::CropWindow crop_window;
+
+    int arg = 2;
+    if (arg < argc && strncmp(argv[arg], "--", 2) != 0) {
+        thread_override = std::atoi(argv[arg++]);
         if (thread_override < 0) {
             std::cerr << "Error: thread count must be non-negative\n";
             return 1;
         }
     }
+    for (; arg < argc; ++arg) {
+        if (strcmp(argv[arg], "--chunk") == 0 && arg + 3 < argc) {
+            chunk = true;
+            chunk_start = std::atoi(argv[++arg]);
+            chunk_end = std::atoi(argv[++arg]);
+            chunk_file = argv[++arg];
+            if (chunk_start < 0 || chunk_end <= chunk_start) {
+                std::cerr << "Error: chunk sample range must satisfy 0 <= START < END\n";
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--crop") == 0 && arg + 4 < argc) {
+            crop = true;
+            crop_window.x0 = std::atoi(argv[++arg]);
+            crop_window.y0 = std::atoi(argv[++arg]);
+            crop_window.x1 = std::atoi(argv[++arg]);
+            crop_window.y1 = std::atoi(argv[++arg]);
+            if (crop_window.IsEmpty()) {
+                std::cerr << "Error: crop window must satisfy X0 < X1 and Y0 < Y1\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Error: unknown or incomplete option '" << argv[arg] << "'\n\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
 
     skwr::RenderSession session;
 
     try {
-        session.LoadSceneFromFile(scene_file, thread_override);
+        // Regions and chunks apply to every view and frame of a sequence alike
+        session.LoadSceneFromFile(scene_file, thread_override, [&](skwr::RenderOptions& options) {
+            skwr::IntegratorConfig& ic = options.integrator_config;
+            if (crop) options.image_config.crop = crop_window;
+            if (chunk) {
+                ic.total_samples = std::max(ic.samples_per_pixel, chunk_end);
+                ic.start_sample = chunk_start;
+                ic.samples_per_pixel = chunk_end - chunk_start;
+                options.chunk = true;
+                options.image_config.exrfile = chunk_file;
+                options.image_config.chunkfile = skwr::ChunkFlatPath(chunk_file);
+            }
+        });
     } catch (const std::exception& e) {
         std::cerr << "[Error] Failed to load scene: " << e.what() << "\n";
         return 1;
     }
 
+    if (session.HasSequence()) {
+        session.RenderSequence();
+        return 0;
+    }
+
     session.Render();
 
     session.Save();
@@ -0,0 +1,233 @@
+#include <io/scene_loader.h>
+#include <session/chunk_merge.h>
+#include <session/render_options.h>
+#include <session/render_session.h>
+#include <session/scene_cache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+
+using json = nlohmann::json;
+
+void print_usage(const char* program_name) {
+    std::cerr << "Usage:\n";
+    std::cerr << "  " << program_name << " [options]\n";
+    std::cerr << "\n";
+    std::cerr << "Renders work items one after another, keeping built scenes in memory so the\n";
+    std::cerr << "sample ranges of one frame only pay for loading and BVH building once.\n";
+    std::cerr << "Each input line is a coordinator WorkPackage in proto3 JSON form, e.g.\n";
+    std::cerr << "  {\"job_id\": \"j\", \"task_id\": \"t0\", \"render_task\": {\"scene_uri\": "
+                 "\"scene.json\",\n";
+    std::cerr << "   \"width\": 640, \"height\": 480, \"sample_start\": 0, \"sample_end\": 64,\n";
+    std::cerr << "   \"output_uri\": \"frame-0001-chunk-0.exr\"}}\n";
+    std::cerr << "Each task writes a chunk: the deep sums to output_uri and the flat sums to\n";
+    std::cerr << "its .flat.exr sibling, for `skewer-render --merge`.\n";
+    std::cerr << "One ReportTaskResultRequest per task is written as a JSON line to stdout (or\n";
+    std::cerr << "the report file); render logs go to stderr.\n";
+    std::cerr << "\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  --queue FILE      Read work items from FILE instead of stdin\n";
+    std::cerr << "  --report FILE     Append task results to FILE instead of stdout\n";
+    std::cerr << "  --cache N         Number of built scenes kept in memory (default 2)\n";
+    std::cerr << "  --threads N       Override thread count from scene files\n";
+    std::cerr << "  --worker-id ID    Worker id to put in the results (default \"local\")\n";
+    std::cerr << "\n";
+    std::cerr << "Help:\n";
+    std::cerr << "  " << program_name << " --help\n";
+}
+
+namespace {
+
+// The fields of a coordinator WorkPackage the worker acts on (api/proto/coordinator/v1)
+struct WorkItem {
+    std::string job_id;
+    std::string task_id;
+    std::string frame_id;
+    bool is_render_task = false;
+
+    // RenderTask
+    std::string scene_uri;
+    int width = 0;
+    int height = 0;
+    int sample_start = 0;
+    int sample_end = 0;
+    std::string output_uri;
+};
+
+WorkItem ParseWorkPackage(const std::string& line) {
+    json j;
+    try {
+        j = json::parse(line);
+    } catch (const json::parse_error& e) {
+        throw std::runtime_error("Malformed work item: " + std::string(e.what()));
+    }
+
+    WorkItem item;
+    item.job_id = j.value("job_id", "");
+    item.task_id = j.value("task_id", "");
+    item.frame_id = j.value("frame_id", "");
+    if (!j.contains("render_task")) return item;
+
+    const json& t = j["render_task"];
+    item.is_render_task = true;
+    item.scene_uri = t.value("scene_uri", "");
+    item.width = t.value("width", 0);
+    item.height = t.value("height", 0);
+    item.sample_start = t.value("sample_start", 0);
+    item.sample_end = t.value("sample_end", 0);
+    item.output_uri = t.value("output_uri", "");
+    return item;
+}
+
+// Only local files are supported: a plain path or a file:// URI
+std::string LocalPath(const std::string& uri) {
+    constexpr const char* kFileScheme = "file://";
+    if (uri.rfind(kFileScheme, 0) == 0) return uri.substr(std::strlen(kFileScheme));
+    if (uri.find("://") != std::string::npos) {
+        throw std::runtime_error("Unsupported URI (only local paths): " + uri);
+    }
+    return uri;
+}
+
+// Renders one RenderTask's sample range against the cached scene and writes it as a chunk
+void RunRenderTask(const WorkItem& item, skwr::SceneCache& cache, skwr::RenderSession& session,
+                   int thread_override) {
+    if (item.scene_uri.empty()) throw std::runtime_error("render_task has no scene_uri");
+    if (item.output_uri.empty()) throw std::runtime_error("render_task has no output_uri");
+    if (item.sample_start < 0 || item.sample_end <= item.sample_start) {
+        throw std::runtime_error("Empty sample range [" + std::to_string(item.sample_start) +
+                                 ", " + std::to_string(item.sample_end) + ")");
+    }
+
+    std::shared_ptr<const skwr::PreparedScene> prepared = cache.Get(LocalPath(item.scene_uri));
+
+    // The task decides resolution, samples and output. Partial renders are merged downstream,
+    // so they are written as chunks: un-normalised, not denoised. The task does not say how many
+    // samples the frame has, so the scene file's count is taken as the frame's.
+    skwr::RenderOptions options = prepared->config.render_options;
+    skwr::IntegratorConfig& ic = options.integrator_config;
+    if (thread_override > 0) ic.num_threads = thread_override;
+    if (item.width > 0) options.image_config.width = item.width;
+    if (item.height > 0) options.image_config.height = item.height;
+    ic.total_samples = std::max(ic.samples_per_pixel, item.sample_end);
+    ic.start_sample = item.sample_start;
+    ic.samples_per_pixel = item.sample_end - item.sample_start;
+    ic.enable_deep = true;
+    options.chunk = true;
+    options.image_config.exrfile = LocalPath(item.output_uri);
+    options.image_config.chunkfile = skwr::ChunkFlatPath(options.image_config.exrfile);
+
+    session.SetScene(std::move(prepared), options);
+    session.Render();
+    session.Save();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string queue_file;
+    std::string report_file;
+    std::string worker_id = "local";
+    int cache_size = 2;
+    int thread_override = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--queue") == 0 && has_value) {
+            queue_file = argv[++i];
+        } else if (strcmp(argv[i], "--report") == 0 && has_value) {
+            report_file = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0 && has_value) {
+            cache_size = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            thread_override = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--worker-id") == 0 && has_value) {
+            worker_id = argv[++i];
+        } else {
+            std::cerr << "Error: unknown or incomplete option '" << argv[i] << "'\n\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (cache_size < 1) {
+        std::cerr << "Error: cache size must be at least 1\n";
+        return 1;
+    }
+    if (thread_override < 0) {
+        std::cerr << "Error: thread count must be non-negative\n";
+        return 1;
+    }
+
+    std::ifstream queue;
+    if (!queue_file.empty()) {
+        queue.open(queue_file);
+        if (!queue.is_open()) {
+            std::cerr << "Error: cannot open queue file: " << queue_file << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = queue_file.empty() ? std::cin : queue;
+
+    // Results get stdout to themselves: the session's own progress output moves to stderr
+    std::ofstream report_stream;
+    if (!report_file.empty()) {
+        report_stream.open(report_file, std::ios::app);
+        if (!report_stream.is_open()) {
+            std::cerr << "Error: cannot open report file: " << report_file << "\n";
+            return 1;
+        }
+    }
+    std::ostream stdout_stream(std::cout.rdbuf());
+    std::ostream& report = report_file.empty() ? stdout_stream : report_stream;
+    std::cout.rdbuf(std::clog.rdbuf());
+
+    skwr::SceneCache cache(static_cast<size_t>(cache_size), [&](const std::string& path) {
+        return skwr::PrepareSceneFile(path, thread_override);
+    });
+    skwr::RenderSession session;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        const auto start = std::chrono::steady_clock::now();
+        json result = {{"worker_id", worker_id}, {"success", false}, {"error_message", ""}};
+        try {
+            const WorkItem item = ParseWorkPackage(line);
+            result["job_id"] = item.job_id;
+            result["task_id"] = item.task_id;
+            if (!item.is_render_task) {
+                throw std::runtime_error(
+                    "Not a render_task; merge and composite tasks run in loom");
+            }
+            std::clog << "[Worker] Task " << item.task_id << ": " << item.scene_uri << " samples ["
+                      << item.sample_start << ", " << item.sample_end << ")\n";
+            RunRenderTask(item, cache, session, thread_override);
+            result["success"] = true;
+            result["output_uri"] = item.output_uri;
+        } catch (const std::exception& e) {
+            std::cerr << "[Error] " << e.what() << "\n";
+            result["error_message"] = e.what();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        result["execution_time_ms"] =
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        report << result.dump() << std::endl;
+    }
+
+    std::clog << "[Worker] Queue drained: " << cache.Hits() << " scene cache hits, "
+              << cache.Misses() << " loads\n";
+    std::cout.rdbuf(stdout_stream.rdbuf());
+    return 0;
+}
@@ -0,0 +1,21 @@
+# Fails if a kernel ISA object defines a weak symbol. The linker keeps one copy of a weak symbol
+# for the whole binary, so a variant could end up running another variant's instructions (see
+# src/core/kernel_inline.h). The one exception is DW.ref.__gxx_personality_v0, a pointer the
+# compiler emits for exception handling that holds no code and is the same in every object.
+# Unique ("u") objects are inline variables, which must be shared and hold no code either.
+# Usage: cmake -DNM=<nm> -DOBJECTS=<a.o,b.o,...> -P check_kernel_symbols.cmake
+string(REPLACE "," ";" objects "${OBJECTS}")
+foreach(object IN LISTS objects)
+    execute_process(COMMAND ${NM} -C ${object}
+                    OUTPUT_VARIABLE symbols
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${NM} failed on ${object}")
+    endif()
+    string(REGEX MATCHALL "[^\n]* [WV] [^\n]*" weak "${symbols}")
+    list(FILTER weak EXCLUDE REGEX " V DW\\.ref\\.__gxx_personality_v0$")
+    if(weak)
+        string(REPLACE ";" "\n" weak "${weak}")
+        message(FATAL_ERROR "Weak symbols in kernel object ${object}:\n${weak}")
+    endif()
+endforeach()
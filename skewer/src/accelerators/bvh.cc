@@ -51,11 +51,7 @@ void BVH::Build(std::vector<Triangle>& triangles) {
         primitive_info[i].centroid = GetCentroid(triangles[i]);
     }
 
-    BVHNode& root = nodes_.emplace_back();
-    root.left_first = 0;
-    root.tri_count = (uint32_t)triangles.size();
-
-    Subdivide(0, 0, (uint32_t)triangles.size(), primitive_info);
+    BuildNodes(primitive_info);
 
     // Reorder triangles to match the BVH-ordered primitive_info
     std::vector<Triangle> ordered;
@@ -66,6 +62,35 @@ void BVH::Build(std::vector<Triangle>& triangles) {
     triangles = std::move(ordered);
 }
 
+std::vector<uint32_t> BVH::Build(const std::vector<BoundBox>& bounds) {
+    nodes_.clear();
+    if (bounds.empty()) return {};
+    nodes_.reserve(bounds.size() * 2);
+
+    std::vector<BVHPrimitiveInfo> primitive_info(bounds.size());
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        primitive_info[i].original_index = (uint32_t)i;
+        primitive_info[i].bounds = bounds[i];
+        primitive_info[i].bounds.PadToMinimums();
+        primitive_info[i].centroid = bounds[i].Centroid();
+    }
+
+    BuildNodes(primitive_info);
+
+    std::vector<uint32_t> order;
+    order.reserve(primitive_info.size());
+    for (const auto& info : primitive_info) order.push_back(info.original_index);
+    return order;
+}
+
+void BVH::BuildNodes(std::vector<BVHPrimitiveInfo>& primitive_info) {
+    BVHNode& root = nodes_.emplace_back();
+    root.left_first = 0;
+    root.tri_count = (uint32_t)primitive_info.size();
+
+    Subdivide(0, 0, (uint32_t)primitive_info.size(), primitive_info);
+}
+
 // ---------------------------------------------------------------------------
 // Subdivide — SAH binning over all 3 axes
 // ---------------------------------------------------------------------------
@@ -38,6 +38,10 @@ class BVH {
     // Triangles must already have their vertex data pre-baked (see Scene::AddMesh).
     void Build(std::vector<Triangle>& triangles);
 
+    // Build over arbitrary primitives (e.g. instances for a top-level BVH) from their bounds.
+    // Returns the order leaves refer to: leaf primitive k is bounds[order[k]].
+    std::vector<uint32_t> Build(const std::vector<BoundBox>& bounds);
+
     const std::vector<BVHNode>& GetNodes() const { return nodes_; }
 
     bool IsEmpty() const { return nodes_.empty(); }
@@ -45,6 +49,9 @@ class BVH {
   private:
     std::vector<BVHNode> nodes_;
 
+    // Shared by both builds; leaves primitive_info in leaf order
+    void BuildNodes(std::vector<BVHPrimitiveInfo>& primitive_info);
+
     // Recursive helper
     void Subdivide(uint32_t node_idx, uint32_t first_tri, uint32_t tri_count,
                    std::vector<BVHPrimitiveInfo>& primitive_info);
@@ -0,0 +1,54 @@
+#ifndef SKWR_CORE_HALF_H_
+#define SKWR_CORE_HALF_H_
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace skwr {
+
+// IEEE 754 binary16 <-> binary32 conversion in plain integer code, so compact texel storage
+// does not depend on F16C or on OpenEXR's lookup tables.
+
+inline float HalfToFloat(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    const uint32_t exp = (h >> 10) & 0x1Fu;
+    const uint32_t mant = h & 0x3FFu;
+
+    uint32_t bits;
+    if (exp == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mant << 13);  // Inf / NaN
+    } else if (exp != 0) {
+        bits = sign | ((exp + 112u) << 23) | (mant << 13);  // Normal: rebias 15 -> 127
+    } else if (mant != 0) {
+        // Subnormal half is a normal float: scale by 2^-24 exactly
+        return std::bit_cast<float>(sign | 0x3F800000u) * static_cast<float>(mant) * 0x1p-24f;
+    } else {
+        bits = sign;  // +-0
+    }
+    return std::bit_cast<float>(bits);
+}
+
+// Round-to-nearest-even; out-of-range values become infinity
+inline uint16_t FloatToHalf(float f) {
+    const uint32_t bits = std::bit_cast<uint32_t>(f);
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    const uint32_t abs = bits & 0x7FFFFFFFu;
+
+    if (abs >= 0x7F800000u) {  // Inf / NaN (keep NaN quiet and non-zero)
+        return sign | 0x7C00u | (abs > 0x7F800000u ? 0x200u : 0u);
+    }
+    if (abs >= 0x477FF000u) return sign | 0x7C00u;  // Rounds past 65504
+    if (abs < 0x38800000u) {
+        // Subnormal or zero half: count 2^-24 steps, rounding half to even
+        const float steps = std::bit_cast<float>(abs) * 0x1p24f;
+        return sign | static_cast<uint16_t>(std::lrint(steps));
+    }
+    const uint32_t mant_odd = (abs >> 13) & 1u;
+    const uint32_t rounded = abs + 0xFFFu + mant_odd;  // Round to nearest even on bit 13
+    return sign | static_cast<uint16_t>((rounded - 0x38000000u) >> 13);
+}
+
+}  // namespace skwr
+
+#endif  // SKWR_CORE_HALF_H_
@@ -0,0 +1,14 @@
+#ifndef SKWR_CORE_KERNEL_INLINE_H_
+#define SKWR_CORE_KERNEL_INLINE_H_
+
+// Marks header functions on the render hot path. Plain inline functions are weak symbols, and
+// when one is emitted out of line in several kernel ISA variants (kernels/render_kernel.cc) the
+// linker keeps a single copy for all of them, so a variant could run another's instructions.
+// Inside a variant build they get internal linkage instead, giving each variant its own copy.
+#ifdef SKWR_KERNEL_ISA
+#define SKWR_KERNEL_INLINE static inline
+#else
+#define SKWR_KERNEL_INLINE inline
+#endif
+
+#endif  // SKWR_CORE_KERNEL_INLINE_H_
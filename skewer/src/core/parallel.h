@@ -0,0 +1,42 @@
+#ifndef SKWR_CORE_PARALLEL_H_
+#define SKWR_CORE_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace skwr {
+
+// Thread count for a config value where 0 (or less) means "use every hardware thread"
+inline int ResolveThreadCount(int requested) {
+    if (requested > 0) return requested;
+    int n = static_cast<int>(std::thread::hardware_concurrency());
+    return n > 0 ? n : 4;  // Fallback
+}
+
+// Calls body(i) for every i in [0, count) across up to num_threads threads. Indices are handed
+// out one at a time from a shared counter, so uneven work items balance themselves. Blocks until
+// all calls have returned; body must be safe to run concurrently for different i.
+template <typename Body>
+void ParallelFor(int count, int num_threads, const Body& body) {
+    const int thread_count = std::min(ResolveThreadCount(num_threads), count);
+    if (thread_count <= 1) {
+        for (int i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) body(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (int t = 0; t < thread_count; ++t) threads.emplace_back(worker);
+    for (auto& thread : threads) thread.join();
+}
+
+}  // namespace skwr
+
+#endif  // SKWR_CORE_PARALLEL_H_
@@ -34,6 +34,24 @@ class Ray {
     // double tm_;
 };
 
+// The rays through the neighbouring pixels (one step in x and in y), carried alongside a path's
+// main ray to estimate how large a pixel is where it lands. Only used for texture filtering, so
+// it is dropped (valid = false) once a diffuse bounce makes the footprint meaningless.
+struct RayDifferential {
+    Point3 rx_origin, ry_origin;
+    Vec3 rx_direction, ry_direction;
+    bool valid = false;
+
+    // Shrinks the offsets towards the main ray; with N samples per pixel each sample only has to
+    // cover about 1/sqrt(N) of a pixel
+    void Scale(const Ray& base, float s) {
+        rx_origin = base.origin() + (rx_origin - base.origin()) * s;
+        ry_origin = base.origin() + (ry_origin - base.origin()) * s;
+        rx_direction = base.direction() + (rx_direction - base.direction()) * s;
+        ry_direction = base.direction() + (ry_direction - base.direction()) * s;
+    }
+};
+
 }  // namespace skwr
 
 #endif  // SKWR_CORE_Ray_H_
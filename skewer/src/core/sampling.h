@@ -2,37 +2,38 @@
 #define SKWR_CORE_SAMPLER_H_
 
 #include "core/constants.h"
+#include "core/kernel_inline.h"
 #include "core/rng.h"
 #include "core/vec3.h"
 
 namespace skwr {
 
 // Helper func. Generates random float in [min, max) using explicit RNG
-inline float RandomFloat(RNG& rng, float min, float max) {
+SKWR_KERNEL_INLINE float RandomFloat(RNG& rng, float min, float max) {
     return min + (max - min) * rng.UniformFloat();
 }
 
 // Generating arbitrary random vectors
-inline Vec3 RandomVec3(RNG& rng) {
+SKWR_KERNEL_INLINE Vec3 RandomVec3(RNG& rng) {
     return Vec3(rng.UniformFloat(), rng.UniformFloat(), rng.UniformFloat());
 }
 
-inline Vec3 RandomVec3(RNG& rng, float min, float max) {
+SKWR_KERNEL_INLINE Vec3 RandomVec3(RNG& rng, float min, float max) {
     return Vec3(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
 }
 
 // Rejection method for generating random vector on surface of a unit sphere
-inline Vec3 RandomInUnitSphere(RNG& rng) {
+SKWR_KERNEL_INLINE Vec3 RandomInUnitSphere(RNG& rng) {
     while (true) {
         // Generate vector between -1 and 1
         auto p = RandomVec3(rng, -1, 1);
         if (p.LengthSquared() < 1) return p;
     }
 }
-inline Vec3 RandomUnitVector(RNG& rng) { return Normalize(RandomInUnitSphere(rng)); }
+SKWR_KERNEL_INLINE Vec3 RandomUnitVector(RNG& rng) { return Normalize(RandomInUnitSphere(rng)); }
 
 // Check if unit vector is on the same hemisphere as normal (want it pointing away from surface)
-inline Vec3 RandomOnHemisphere(RNG& rng, const Vec3& normal) {
+SKWR_KERNEL_INLINE Vec3 RandomOnHemisphere(RNG& rng, const Vec3& normal) {
     Vec3 on_unit_sphere = RandomUnitVector(rng);
     if (Dot(on_unit_sphere, normal) > 0.0)  // aligned with normal
         return on_unit_sphere;
@@ -41,7 +42,7 @@ inline Vec3 RandomOnHemisphere(RNG& rng, const Vec3& normal) {
 }
 
 // Defocus disk
-inline Vec3 RandomInUnitDisk(RNG& rng) {
+SKWR_KERNEL_INLINE Vec3 RandomInUnitDisk(RNG& rng) {
     while (true) {
         auto p = Vec3(RandomFloat(rng, -1, 1), RandomFloat(rng, -1, 1), 0);
         if (p.LengthSquared() < 1) return p;
@@ -50,7 +51,7 @@ inline Vec3 RandomInUnitDisk(RNG& rng) {
 
 // Returns a random direction in the Local Frame (Z is up)
 // The probability of picking a direction is proportional to Cosine(theta)
-inline Vec3 RandomCosineDirection(RNG& rng) {
+SKWR_KERNEL_INLINE Vec3 RandomCosineDirection(RNG& rng) {
     float r1 = rng.UniformFloat();
     float r2 = rng.UniformFloat();
 
@@ -65,7 +66,7 @@ inline Vec3 RandomCosineDirection(RNG& rng) {
 }
 
 // 64-bit mixing function for RNG seeding
-inline uint64_t SplitMix64(uint64_t z) {
+SKWR_KERNEL_INLINE uint64_t SplitMix64(uint64_t z) {
     z += 0x9e3779b97f4a7c15ULL;
     z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9ULL;
     z = (z ^ (z >> 27u)) * 0x94d049bb133111ebULL;
@@ -73,7 +74,8 @@ inline uint64_t SplitMix64(uint64_t z) {
 }
 
 // Fully deterministic per-pixel RNG, thread-order independent
-inline RNG MakeDeterministicPixelRNG(uint32_t x, uint32_t y, int width, uint32_t sample_index) {
+SKWR_KERNEL_INLINE RNG MakeDeterministicPixelRNG(uint32_t x, uint32_t y, int width,
+                                                 uint32_t sample_index) {
     // Get linear pixel ID
     uint64_t pixel_id = (uint64_t)y * width + x;
 
@@ -88,7 +90,7 @@ inline RNG MakeDeterministicPixelRNG(uint32_t x, uint32_t y, int width, uint32_t
 
 // Power Heuristic for MIS (beta = 2 is standard)
 // Calculates the weight for technique 'f' given the probability of 'f' and 'g'
-inline float PowerHeuristic(float pdf_f, float pdf_g) {
+SKWR_KERNEL_INLINE float PowerHeuristic(float pdf_f, float pdf_g) {
     float f2 = pdf_f * pdf_f;
     float g2 = pdf_g * pdf_g;
     return f2 / (f2 + g2);
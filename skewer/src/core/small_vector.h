@@ -0,0 +1,75 @@
+#ifndef SKWR_CORE_SMALL_VECTOR_H_
+#define SKWR_CORE_SMALL_VECTOR_H_
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace skwr {
+
+// Vector with N elements of inline storage. Nothing touches the heap until the N+1th push_back,
+// at which point the contents move to a heap buffer that doubles as needed. Meant for small,
+// short-lived per-sample lists on the hot path, so only trivially copyable types are allowed.
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(N > 0);
+    static_assert(std::is_trivially_copyable_v<T>);
+
+  public:
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other) { *this = other; }
+    SmallVector& operator=(const SmallVector& other) {
+        if (this == &other) return *this;
+        clear();
+        Reserve(other.size_);
+        std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+        size_ = other.size_;
+        return *this;
+    }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) Reserve(capacity_ * 2);
+        new (data() + size_) T(value);
+        ++size_;
+    }
+
+    void clear() { size_ = 0; }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    bool spilled() const { return heap_ != nullptr; }  // true once N was exceeded
+
+    T* data() { return heap_ ? heap_.get() : reinterpret_cast<T*>(inline_); }
+    const T* data() const { return heap_ ? heap_.get() : reinterpret_cast<const T*>(inline_); }
+
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+
+  private:
+    void Reserve(size_t count) {
+        if (count <= capacity_) return;
+        std::unique_ptr<T[]> grown(new T[count]);
+        std::memcpy(grown.get(), data(), size_ * sizeof(T));
+        heap_ = std::move(grown);
+        capacity_ = count;
+    }
+
+    // Raw storage so constructing an empty vector doesn't initialise N elements
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+    std::unique_ptr<T[]> heap_;
+    size_t size_ = 0;
+    size_t capacity_ = N;
+};
+
+}  // namespace skwr
+
+#endif  // SKWR_CORE_SMALL_VECTOR_H_
@@ -2,10 +2,13 @@
 #define SKWR_CORE_SPECTRAL_SPECTRAL_UTILS_H_
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 
 #include "core/color.h"
+#include "core/kernel_inline.h"
+#include "core/spectral/cie_data.h"
 #include "core/spectral/rgb2spec.h"
 #include "core/spectral/spectral_curve.h"
 #include "core/spectrum.h"
@@ -29,7 +32,7 @@ inline void InitSpectralModel() {
 }
 
 // rgb2spec wrappers
-inline SpectralCurve RGBToCurve(const RGB& color) {
+SKWR_KERNEL_INLINE SpectralCurve RGBToCurve(const RGB& color) {
     if (!g_rgb2spec_model) return SpectralCurve();
 
     RGB linear = ToLinear(color);
@@ -60,55 +63,94 @@ inline SpectralCurve RGBToCurve(const RGB& color) {
     return curve;
 }
 
-inline Spectrum CurveToSpectrum(const SpectralCurve& curve, const SampledWavelengths& wl) {
+SKWR_KERNEL_INLINE Spectrum CurveToSpectrum(const SpectralCurve& curve,
+                                            const SampledWavelengths& wl) {
     Spectrum result(0.0f);
     if (curve.scale <= 0.0f) return result;
+    // Sigmoid polynomial from rgb2spec_eval_precise, evaluated inline across the whole packet
+    // rather than through one C call per wavelength
     for (int i = 0; i < kNSamples; ++i) {
-        result[i] = rgb2spec_eval_fast(const_cast<float*>(curve.coeff), wl.lambda[i]) * curve.scale;
+        const float lambda = wl.lambda[i];
+        const float x = (curve.coeff[0] * lambda + curve.coeff[1]) * lambda + curve.coeff[2];
+        const float y = 1.0f / std::sqrt(x * x + 1.0f);
+        result[i] = (0.5f * x * y + 0.5f) * curve.scale;
     }
     return result;
 }
 
-// TODO: Refactor with tabulated data. This is only a temporary approximation
-// Wyman approximation
-inline float CIE_X(float lambda) {
-    float x1 = (lambda - 442.0f) * ((lambda < 442.0f) ? 0.0624f : 0.0374f);
-    float x2 = (lambda - 599.8f) * ((lambda < 599.8f) ? 0.0264f : 0.0323f);
-    float x3 = (lambda - 501.1f) * ((lambda < 501.1f) ? 0.0490f : 0.0382f);
-    return 0.362f * std::exp(-0.5f * x1 * x1) + 1.056f * std::exp(-0.5f * x2 * x2) -
-           0.065f * std::exp(-0.5f * x3 * x3);
+// Reflectance curve to linear sRGB, integrated over the whole CIE table rather than a sampled
+// wavelength packet. Far too slow for the path kernel; meant for AOVs and tools.
+SKWR_KERNEL_INLINE RGB CurveToRGB(const SpectralCurve& curve) {
+    if (curve.scale <= 0.0f) return RGB(0.0f);
+    float X = 0.0f, Y = 0.0f, Z = 0.0f;
+    for (int i = 0; i < kCIESampleCount; ++i) {
+        const float lambda = kCIELambdaMin + kCIELambdaStep * static_cast<float>(i);
+        const float x = (curve.coeff[0] * lambda + curve.coeff[1]) * lambda + curve.coeff[2];
+        const float s = (0.5f * x / std::sqrt(x * x + 1.0f) + 0.5f) * curve.scale;
+        X += s * kCIE_X[i];
+        Y += s * kCIE_Y[i];
+        Z += s * kCIE_Z[i];
+    }
+    const float norm = kCIELambdaStep / kCIE_Y_Integral;
+    X *= norm;
+    Y *= norm;
+    Z *= norm;
+    return RGB(3.2404542f * X - 1.5371385f * Y - 0.4985314f * Z,
+               -0.9692660f * X + 1.8760108f * Y + 0.0415560f * Z,
+               0.0556434f * X - 0.2040259f * Y + 1.0572252f * Z);
 }
 
-inline float CIE_Y(float lambda) {
-    float y1 = (lambda - 568.8f) * ((lambda < 568.8f) ? 0.0213f : 0.0247f);
-    float y2 = (lambda - 530.9f) * ((lambda < 530.9f) ? 0.0613f : 0.0322f);
-    return 0.821f * std::exp(-0.5f * y1 * y1) + 0.286f * std::exp(-0.5f * y2 * y2);
+// Tabulated CIE 1931 matching functions, linearly interpolated. Wavelengths outside the table
+// clamp to its end points, which are effectively zero.
+struct CIETableCoord {
+    int index;
+    float t;
+};
+
+SKWR_KERNEL_INLINE CIETableCoord CIECoord(float lambda) {
+    float f = (lambda - kCIELambdaMin) * (1.0f / kCIELambdaStep);
+    f = std::clamp(f, 0.0f, static_cast<float>(kCIESampleCount - 1));
+    int index = std::min(static_cast<int>(f), kCIESampleCount - 2);
+    return {index, f - static_cast<float>(index)};
 }
 
-inline float CIE_Z(float lambda) {
-    float z1 = (lambda - 437.0f) * ((lambda < 437.0f) ? 0.0845f : 0.0278f);
-    float z2 = (lambda - 459.0f) * ((lambda < 459.0f) ? 0.0385f : 0.0725f);
-    return 1.217f * std::exp(-0.5f * z1 * z1) + 0.681f * std::exp(-0.5f * z2 * z2);
+SKWR_KERNEL_INLINE float CIELookup(const float* table, const CIETableCoord& c) {
+    return table[c.index] + c.t * (table[c.index + 1] - table[c.index]);
 }
 
+SKWR_KERNEL_INLINE float CIE_X(float lambda) { return CIELookup(kCIE_X, CIECoord(lambda)); }
+SKWR_KERNEL_INLINE float CIE_Y(float lambda) { return CIELookup(kCIE_Y, CIECoord(lambda)); }
+SKWR_KERNEL_INLINE float CIE_Z(float lambda) { return CIELookup(kCIE_Z, CIECoord(lambda)); }
+
 // TODO: Refactor to RGB file, preferably alongside the spectrum architecture refactor
-inline RGB SpectrumToRGB(const Spectrum& spec, const SampledWavelengths& wl) {
-    float X = 0.0f, Y = 0.0f, Z = 0.0f;
+SKWR_KERNEL_INLINE RGB SpectrumToRGB(const Spectrum& spec, const SampledWavelengths& wl) {
+    // Resolve table coordinates and estimator weights for the whole packet up front so the
+    // accumulation below is a straight-line loop over kNSamples lanes with no branches
+    alignas(16) int index[kNSamples];
+    alignas(16) float t[kNSamples];
+    alignas(16) float weight[kNSamples];
+    for (int i = 0; i < kNSamples; ++i) {
+        CIETableCoord c = CIECoord(wl.lambda[i]);
+        index[i] = c.index;
+        t[i] = c.t;
+        weight[i] = spec[i] / (wl.pdf[i] * kNSamples);
+    }
 
     // Monte Carlo Estimator: Integrate spectrum against the eye's XYZ response
+    float X = 0.0f, Y = 0.0f, Z = 0.0f;
     for (int i = 0; i < kNSamples; ++i) {
-        float weight = 1.0f / (wl.pdf[i] * kNSamples);
-        X += spec[i] * CIE_X(wl.lambda[i]) * weight;
-        Y += spec[i] * CIE_Y(wl.lambda[i]) * weight;
-        Z += spec[i] * CIE_Z(wl.lambda[i]) * weight;
+        const int j = index[i];
+        X += weight[i] * (kCIE_X[j] + t[i] * (kCIE_X[j + 1] - kCIE_X[j]));
+        Y += weight[i] * (kCIE_Y[j] + t[i] * (kCIE_Y[j + 1] - kCIE_Y[j]));
+        Z += weight[i] * (kCIE_Z[j] + t[i] * (kCIE_Z[j + 1] - kCIE_Z[j]));
     }
 
-    // Normalize by the integral of the CIE Y curve (~106.8568)
+    // Normalize by the integral of the CIE Y curve
     // Makes sure a pure white material (1.0 across the spectrum) stays 1.0 in RGB
-    const float kCIE_Y_Integral = 106.8568f;
-    X /= kCIE_Y_Integral;
-    Y /= kCIE_Y_Integral;
-    Z /= kCIE_Y_Integral;
+    constexpr float kInvYIntegral = 1.0f / kCIE_Y_Integral;
+    X *= kInvYIntegral;
+    Y *= kInvYIntegral;
+    Z *= kInvYIntegral;
 
     // Standard CIE XYZ to Linear sRGB Matrix
     float r = 3.2404542f * X - 1.5371385f * Y - 0.4985314f * Z;
@@ -0,0 +1,97 @@
+#ifndef SKWR_CORE_THREAD_POOL_H_
+#define SKWR_CORE_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "core/parallel.h"
+
+namespace skwr {
+
+// Fixed set of worker threads draining a FIFO of tasks. Unlike ParallelFor, tasks can be added
+// while earlier ones are still running, so a producer (e.g. the scene loader queueing texture
+// decodes) never waits for the work it hands off until it actually needs the results.
+class ThreadPool {
+  public:
+    // num_threads <= 0 means one per hardware thread
+    explicit ThreadPool(int num_threads) {
+        const int n = ResolveThreadCount(num_threads);
+        workers_.reserve(n);
+        for (int i = 0; i < n; ++i) workers_.emplace_back([this] { WorkerLoop(); });
+    }
+
+    // Runs everything still queued, then joins
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(task));
+        }
+        work_cv_.notify_one();
+    }
+
+    // Blocks until every submitted task has finished. Rethrows the first exception a task threw
+    // since the last Wait.
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this] { return queue_.empty() && active_ == 0; });
+        if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    int size() const { return static_cast<int>(workers_.size()); }
+
+  private:
+    void WorkerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;  // Stopping and drained
+
+            std::function<void()> task = std::move(queue_.front());
+            queue_.pop_front();
+            active_++;
+            lock.unlock();
+            std::exception_ptr task_error;
+            try {
+                task();
+            } catch (...) {
+                task_error = std::current_exception();
+            }
+            lock.lock();
+            if (task_error && !error_) error_ = task_error;
+            active_--;
+            if (queue_.empty() && active_ == 0) idle_cv_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<std::function<void()>> queue_;
+    int active_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;  // First task failure since the last Wait
+
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace skwr
+
+#endif  // SKWR_CORE_THREAD_POOL_H_
@@ -62,6 +62,84 @@ inline void ApplyRotationToNormals(std::vector<Vec3>& normals, const Vec3& rotat
     }
 }
 
+// Affine transform stored as the top three rows of a 4x4 matrix (linear part plus translation
+// in the last column), applied to column vectors.
+struct Affine3 {
+    float m[3][4] = {{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}};
+
+    // The transform ApplyTransform performs: Scale -> Rotate (degrees, Y-X-Z) -> Translate
+    static Affine3 FromSRT(const Vec3& translate, const Vec3& rotate_deg, const Vec3& scale) {
+        const float rx = DegreesToRadians(rotate_deg.x());
+        const float ry = DegreesToRadians(rotate_deg.y());
+        const float rz = DegreesToRadians(rotate_deg.z());
+        Affine3 a;
+        for (int c = 0; c < 3; ++c) {
+            Vec3 axis(0.0f, 0.0f, 0.0f);
+            axis[c] = scale[c];
+            const Vec3 col = RotateEulerYXZ(axis, rx, ry, rz);
+            for (int r = 0; r < 3; ++r) a.m[r][c] = col[r];
+        }
+        for (int r = 0; r < 3; ++r) a.m[r][3] = translate[r];
+        return a;
+    }
+
+    Vec3 Point(const Vec3& p) const {
+        return Vec3(m[0][0] * p.x() + m[0][1] * p.y() + m[0][2] * p.z() + m[0][3],
+                    m[1][0] * p.x() + m[1][1] * p.y() + m[1][2] * p.z() + m[1][3],
+                    m[2][0] * p.x() + m[2][1] * p.y() + m[2][2] * p.z() + m[2][3]);
+    }
+
+    Vec3 Vector(const Vec3& v) const {
+        return Vec3(m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+                    m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+                    m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z());
+    }
+
+    // Transposed linear part times v. Called on the inverse transform, this maps normals.
+    Vec3 TransposedVector(const Vec3& v) const {
+        return Vec3(m[0][0] * v.x() + m[1][0] * v.y() + m[2][0] * v.z(),
+                    m[0][1] * v.x() + m[1][1] * v.y() + m[2][1] * v.z(),
+                    m[0][2] * v.x() + m[1][2] * v.y() + m[2][2] * v.z());
+    }
+
+    // this * o: applies o first
+    Affine3 operator*(const Affine3& o) const {
+        Affine3 a;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                a.m[r][c] = m[r][0] * o.m[0][c] + m[r][1] * o.m[1][c] + m[r][2] * o.m[2][c] +
+                            (c == 3 ? m[r][3] : 0.0f);
+            }
+        }
+        return a;
+    }
+
+    float Determinant() const {
+        return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    }
+
+    // Only meaningful when Determinant() != 0
+    Affine3 Inverse() const {
+        const float inv_det = 1.0f / Determinant();
+        Affine3 a;
+        a.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv_det;
+        a.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+        a.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+        a.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv_det;
+        a.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+        a.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+        a.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv_det;
+        a.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+        a.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+        for (int r = 0; r < 3; ++r) {
+            a.m[r][3] = -(a.m[r][0] * m[0][3] + a.m[r][1] * m[1][3] + a.m[r][2] * m[2][3]);
+        }
+        return a;
+    }
+};
+
 }  // namespace skwr
 
 #endif  // SKWR_CORE_TRANSFORM_H_
@@ -0,0 +1,120 @@
+#include "film/deep_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace skwr {
+
+namespace {
+
+constexpr uint32_t kBlocksPerChunk = DeepSegmentPool::kChunkSize / DeepSegmentPool::kBlockSize;
+constexpr size_t kChunkBytes = size_t(DeepSegmentPool::kChunkSize) * sizeof(DeepSegmentNode);
+
+std::atomic<uint64_t> g_next_pool_id{1};
+
+// The block the calling thread is filling. A pool id of 0 never matches, so a fresh thread (or
+// one that last allocated from another pool) starts a new block.
+struct BlockCursor {
+    uint64_t pool_id = 0;
+    int band = 0;
+    uint32_t next = 0;
+    uint32_t end = 0;
+};
+thread_local BlockCursor t_cursor;
+
+}  // namespace
+
+DeepSegmentPool::DeepSegmentPool(size_t max_bytes)
+    : slots_(new ChunkSlot[kMaxChunks]),
+      // The last block is never handed out, so no node index collides with kNoNode
+      max_blocks_(kMaxChunks * kBlocksPerChunk - 1),
+      max_live_chunks_(kMaxChunks),
+      id_(g_next_pool_id.fetch_add(1, std::memory_order_relaxed)) {
+    if (max_bytes > 0) {
+        max_live_chunks_ = static_cast<uint32_t>(
+            std::clamp<size_t>(max_bytes / kChunkBytes, 1, static_cast<size_t>(kMaxChunks)));
+    }
+}
+
+DeepSegmentPool::~DeepSegmentPool() {
+    for (uint32_t i = 0; i < kMaxChunks; ++i) {
+        delete[] slots_[i].nodes.load(std::memory_order_relaxed);
+    }
+}
+
+uint32_t DeepSegmentPool::Allocate(int band) {
+    BlockCursor& c = t_cursor;
+    if (c.pool_id != id_ || c.band != band || c.next == c.end) {
+        // Checked first so threads past the cap stop bumping the counter. Over the memory cap,
+        // only the rest of an already allocated chunk may still be handed out.
+        const uint32_t hint = next_block_.load(std::memory_order_relaxed);
+        if (hint >= max_blocks_) return kNoNode;
+        if (live_chunks_.load(std::memory_order_relaxed) >= max_live_chunks_ &&
+            slots_[hint / kBlocksPerChunk].nodes.load(std::memory_order_relaxed) == nullptr) {
+            return kNoNode;
+        }
+
+        const uint32_t block = next_block_.fetch_add(1, std::memory_order_relaxed);
+        if (block >= max_blocks_) return kNoNode;
+        const uint32_t chunk = block / kBlocksPerChunk;  // Blocks never straddle chunks
+        EnsureChunk(chunk);
+
+        // The band is recorded before the block is counted, so a chunk with every block counted
+        // already knows its final band
+        ChunkSlot& slot = slots_[chunk];
+        int last = slot.last_band.load(std::memory_order_relaxed);
+        while (band > last &&
+               !slot.last_band.compare_exchange_weak(last, band, std::memory_order_relaxed)) {
+        }
+        slot.blocks.fetch_add(1, std::memory_order_release);
+
+        c.pool_id = id_;
+        c.band = band;
+        c.next = block * kBlockSize;
+        c.end = c.next + kBlockSize;
+    }
+    return c.next++;
+}
+
+void DeepSegmentPool::EnsureChunk(uint32_t chunk) {
+    std::atomic<DeepSegmentNode*>& nodes = slots_[chunk].nodes;
+    if (nodes.load(std::memory_order_acquire) != nullptr) return;
+    DeepSegmentNode* fresh = new DeepSegmentNode[kChunkSize];
+    DeepSegmentNode* expected = nullptr;
+    if (nodes.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+        live_chunks_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        delete[] fresh;  // Another thread's block in the same chunk got there first
+    }
+}
+
+void DeepSegmentPool::ReleaseBands(int band) {
+    // Only chunks with every block handed out are candidates: a partly used chunk can still
+    // receive blocks for later bands
+    const uint32_t handed = std::min(next_block_.load(std::memory_order_acquire), max_blocks_);
+    const uint32_t full_chunks = handed / kBlocksPerChunk;
+
+    bool contiguous = true;
+    for (uint32_t c = release_from_; c < full_chunks; ++c) {
+        ChunkSlot& slot = slots_[c];
+        const bool counted = slot.blocks.load(std::memory_order_acquire) == kBlocksPerChunk;
+        if (counted && slot.last_band.load(std::memory_order_relaxed) <= band) {
+            DeepSegmentNode* nodes = slot.nodes.exchange(nullptr, std::memory_order_acq_rel);
+            if (nodes != nullptr) {
+                delete[] nodes;
+                live_chunks_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        } else {
+            contiguous = false;
+        }
+        if (contiguous) release_from_ = c + 1;
+    }
+}
+
+size_t DeepSegmentPool::ReservedBytes() const {
+    return size_t(live_chunks_.load(std::memory_order_relaxed)) * kChunkBytes;
+}
+
+}  // namespace skwr
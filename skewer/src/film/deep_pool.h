@@ -0,0 +1,87 @@
+#ifndef SKWR_FILM_DEEP_POOL_H_
+#define SKWR_FILM_DEEP_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "core/color.h"
+
+namespace skwr {
+
+// One per-pixel depth bin: the summed radiance and coverage of every segment of one object that
+// landed on it
+struct DeepSegmentNode {
+    float z_front;
+    float z_back;
+    RGB L;
+    float alpha;
+    uint32_t object_id;
+    uint32_t material_id;
+    uint32_t sample_count;  // Segments summed into the bin
+    uint32_t next;
+};
+
+// Growable store for the film's deep segment lists. Nodes are addressed by a 32-bit index into a
+// table of fixed-size chunks; a chunk is only allocated once a node in it is handed out, and the
+// table entries are published with a CAS so growth never takes a lock or moves a node. Each
+// thread carves nodes out of its own kBlockSize block, so Allocate() is a thread-local increment
+// and, once per block, one atomic add.
+//
+// Every node belongs to a band of scanlines, and a block only ever holds nodes of one band. Each
+// chunk remembers the last band it served, so once the bands up to b are finished and exported,
+// ReleaseBands(b) can free every chunk that holds nothing newer.
+class DeepSegmentPool {
+  public:
+    static constexpr uint32_t kNoNode = UINT32_MAX;
+    static constexpr uint32_t kBlockSize = 256;
+    static constexpr int kChunkShift = 16;
+    static constexpr uint32_t kChunkSize = 1u << kChunkShift;
+    static constexpr uint32_t kMaxChunks = 1u << (32 - kChunkShift);
+
+    // max_bytes caps the memory held by live chunks (rounded down to whole chunks, at least one);
+    // 0 means only the 32-bit index space limits it
+    explicit DeepSegmentPool(size_t max_bytes = 0);
+    ~DeepSegmentPool();
+    DeepSegmentPool(const DeepSegmentPool&) = delete;
+    DeepSegmentPool& operator=(const DeepSegmentPool&) = delete;
+
+    // Index of a fresh node for the given band, or kNoNode once the cap is reached
+    uint32_t Allocate(int band = 0);
+
+    DeepSegmentNode& operator[](uint32_t i) {
+        return slots_[i >> kChunkShift].nodes.load(std::memory_order_acquire)[i & (kChunkSize - 1)];
+    }
+    const DeepSegmentNode& operator[](uint32_t i) const {
+        return slots_[i >> kChunkShift].nodes.load(std::memory_order_acquire)[i & (kChunkSize - 1)];
+    }
+
+    // Frees the chunks whose nodes all belong to bands <= band. No thread may touch those bands'
+    // nodes afterwards; calls must not overlap each other.
+    void ReleaseBands(int band);
+
+    // Bytes held by live chunks
+    size_t ReservedBytes() const;
+
+  private:
+    struct ChunkSlot {
+        std::atomic<DeepSegmentNode*> nodes{nullptr};
+        std::atomic<int> last_band{0};
+        std::atomic<uint32_t> blocks{0};  // Blocks handed out whose band is in last_band
+    };
+
+    void EnsureChunk(uint32_t chunk);
+
+    std::unique_ptr<ChunkSlot[]> slots_;
+    std::atomic<uint32_t> next_block_{0};
+    std::atomic<uint32_t> live_chunks_{0};
+    uint32_t max_blocks_;
+    uint32_t max_live_chunks_;
+    uint32_t release_from_ = 0;  // Every chunk below this has been freed
+    const uint64_t id_;          // Tells this pool's thread-local blocks apart from other pools'
+};
+
+}  // namespace skwr
+
+#endif  // SKWR_FILM_DEEP_POOL_H_
@@ -0,0 +1,177 @@
+#include "film/denoiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "core/color.h"
+#include "core/parallel.h"
+#include "core/vec3.h"
+#include "film/film.h"
+#include "film/film_tile.h"
+#include "integrators/path_sample.h"
+
+namespace skwr {
+
+namespace {
+
+struct DenoiseParams {
+    int radius;           // Filter footprint is (2 * radius + 1)^2 pixels
+    float sigma_spatial;  // Gaussian falloff with pixel distance
+    float k_luminance;    // How many variances apart two pixels may be and still blend
+};
+
+DenoiseParams ParamsFor(DenoiseStrength strength) {
+    switch (strength) {
+        case DenoiseStrength::Low:
+            return {2, 1.0f, 2.0f};
+        case DenoiseStrength::Medium:
+            return {4, 2.0f, 4.0f};
+        case DenoiseStrength::High:
+        default:
+            return {6, 3.0f, 8.0f};
+    }
+}
+
+constexpr float kSigmaAlbedo = 0.1f;      // Albedo difference (per channel, RMS-ish) tolerated
+constexpr float kNormalPower = 64.0f;     // Sharpness of the normal term (cos^k)
+constexpr float kSigmaDepth = 0.1f;       // Relative depth difference
+constexpr float kAlbedoEpsilon = 1e-3f;   // Below this the pixel is not demodulated
+constexpr float kLuminanceFloor = 1e-4f;  // Keeps the colour term finite at zero variance
+
+// Albedo used for (de)modulation; black or missing albedo passes the colour through unchanged
+RGB GuideAlbedo(const ResolvedAOV& a) {
+    float max_albedo = std::max({a.albedo.r(), a.albedo.g(), a.albedo.b()});
+    if (a.object_id == kNoHitId || max_albedo < kAlbedoEpsilon) return RGB(1.0f);
+    return RGB(std::max(a.albedo.r(), kAlbedoEpsilon), std::max(a.albedo.g(), kAlbedoEpsilon),
+               std::max(a.albedo.b(), kAlbedoEpsilon));
+}
+
+}  // namespace
+
+const char* DenoiseStrengthName(DenoiseStrength strength) {
+    switch (strength) {
+        case DenoiseStrength::Off:
+            return "off";
+        case DenoiseStrength::Low:
+            return "low";
+        case DenoiseStrength::Medium:
+            return "medium";
+        case DenoiseStrength::High:
+            return "high";
+    }
+    return "unknown";
+}
+
+void Denoise(Film* film, DenoiseStrength strength, int num_threads) {
+    if (strength == DenoiseStrength::Off || !film->HasAOVs()) return;
+
+    const DenoiseParams params = ParamsFor(strength);
+    const int width = film->width();
+    const int height = film->height();
+    const size_t n = static_cast<size_t>(width) * height;
+
+    const std::vector<RGB> colors = film->ResolveColors();
+    const std::vector<ResolvedAOV> aovs = film->ResolveAOVs();
+
+    // Prepass: demodulate, normalise the averaged normals and scale the variance to irradiance
+    std::vector<RGB> albedo(n);
+    std::vector<RGB> irradiance(n);
+    std::vector<Vec3> normals(n);
+    std::vector<float> raw_variance(n);
+    for (size_t i = 0; i < n; ++i) {
+        albedo[i] = GuideAlbedo(aovs[i]);
+        irradiance[i] = RGB(colors[i].r() / albedo[i].r(), colors[i].g() / albedo[i].g(),
+                            colors[i].b() / albedo[i].b());
+        float len = aovs[i].normal.Length();
+        normals[i] = len > 0 ? aovs[i].normal / len : Vec3();
+        float a_lum = albedo[i].Luminance();
+        raw_variance[i] = aovs[i].variance / (a_lum * a_lum);
+    }
+
+    // Per-pixel variance is itself noisy at low sample counts; a 3x3 box takes the edge off
+    std::vector<float> variance(n);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float sum = 0.0f;
+            int count = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int qx = x + dx, qy = y + dy;
+                    if (qx < 0 || qx >= width || qy < 0 || qy >= height) continue;
+                    sum += raw_variance[qy * width + qx];
+                    count++;
+                }
+            }
+            variance[y * width + x] = sum / count;
+        }
+    }
+
+    // Spatial weights depend only on the offset
+    const int r = params.radius;
+    const int span = 2 * r + 1;
+    std::vector<float> spatial(span * span);
+    for (int dy = -r; dy <= r; ++dy) {
+        for (int dx = -r; dx <= r; ++dx) {
+            float d2 = float(dx * dx + dy * dy);
+            spatial[(dy + r) * span + (dx + r)] =
+                std::exp(-d2 / (2.0f * params.sigma_spatial * params.sigma_spatial));
+        }
+    }
+
+    // Tiles write disjoint pixels of `out` and only read the shared inputs
+    std::vector<RGB> out(colors);
+    ParallelFor(film->TileCount(), num_threads, [&](int tile_index) {
+        const TileBounds b = film->GetTileBounds(tile_index);
+        for (int y = b.y0; y < b.y1; ++y) {
+            for (int x = b.x0; x < b.x1; ++x) {
+                const size_t p = static_cast<size_t>(y) * width + x;
+                const ResolvedAOV& ap = aovs[p];
+                if (ap.object_id == kNoHitId) continue;  // Background is left as rendered
+
+                const float lum_p = irradiance[p].Luminance();
+                const float var_p = variance[p];
+                const float depth_scale = kSigmaDepth * std::max(ap.depth, 1e-3f);
+
+                RGB sum(0.0f);
+                float weight_sum = 0.0f;
+                for (int dy = -r; dy <= r; ++dy) {
+                    const int qy = y + dy;
+                    if (qy < 0 || qy >= height) continue;
+                    for (int dx = -r; dx <= r; ++dx) {
+                        const int qx = x + dx;
+                        if (qx < 0 || qx >= width) continue;
+                        const size_t q = static_cast<size_t>(qy) * width + qx;
+                        const ResolvedAOV& aq = aovs[q];
+                        if (aq.object_id == kNoHitId) continue;
+
+                        float w = spatial[(dy + r) * span + (dx + r)];
+
+                        float n_dot = std::max(0.0f, Dot(normals[p], normals[q]));
+                        w *= std::pow(n_dot, kNormalPower);
+
+                        RGB da = ap.albedo - aq.albedo;
+                        float da2 = da.r() * da.r() + da.g() * da.g() + da.b() * da.b();
+                        w *= std::exp(-da2 / (kSigmaAlbedo * kSigmaAlbedo));
+
+                        w *= std::exp(-std::abs(ap.depth - aq.depth) / depth_scale);
+
+                        float dl = lum_p - irradiance[q].Luminance();
+                        float denom = params.k_luminance * (var_p + variance[q]) + kLuminanceFloor;
+                        w *= std::exp(-dl * dl / denom);
+
+                        sum += irradiance[q] * w;
+                        weight_sum += w;
+                    }
+                }
+
+                // Only a degenerate (zero) normal can leave the centre pixel unweighted
+                if (weight_sum > 0.0f) out[p] = (sum / weight_sum) * albedo[p];
+            }
+        }
+    });
+
+    film->ReplaceColors(out);
+}
+
+}  // namespace skwr
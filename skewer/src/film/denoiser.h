@@ -0,0 +1,28 @@
+#ifndef SKWR_FILM_DENOISER_H_
+#define SKWR_FILM_DENOISER_H_
+
+#include "session/render_options.h"
+
+namespace skwr {
+
+class Film;
+
+/*
+ * Feature-guided denoiser, run on the film after rendering and before it is written out.
+ *
+ * A cross-bilateral filter: each pixel becomes a weighted average of its neighbours, where the
+ * weights come from the noise-free first-hit AOVs (albedo, normal, depth) rather than from the
+ * noisy colour, so edges and texture are kept while Monte Carlo noise is averaged away. The
+ * colour term is scaled by the per-pixel variance, so converged pixels are left alone and noisy
+ * ones are smoothed harder. Filtering happens on irradiance (colour / albedo) and the albedo is
+ * multiplied back in afterwards, which keeps texture detail out of the blur.
+ *
+ * Requires Film::HasAOVs(). Works tile by tile on num_threads threads (0 = all).
+ */
+void Denoise(Film* film, DenoiseStrength strength, int num_threads);
+
+const char* DenoiseStrengthName(DenoiseStrength strength);
+
+}  // namespace skwr
+
+#endif  // SKWR_FILM_DENOISER_H_
@@ -1,192 +1,254 @@
 #include "film/film.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
 
 #include "core/constants.h"
+#include "core/parallel.h"
 #include "film/image_buffer.h"
 #include "integrators/path_sample.h"
 
 namespace skwr {
 
-Film::Film(int width, int height)
-    : width_(width),
-      height_(height),
-      pixels_(width_ * height_),
-      deep_pool_(width_ * height_ * 100 * 4) {
-    // pixels_.resize(width_ * height_);
+// Depth-relative tolerance under which two deep segments count as the same surface: accounts for
+// sub-pixel depth variation caused by surface curvature, ray jittering, and anti-aliasing.
+// At depth 10 → epsilon ≈ 0.01, at depth 100 → epsilon ≈ 0.1
+static float DeepDepthEpsilon(float z) { return std::max(1e-2f, std::abs(z) * 1e-3f); }
+
+Film::Film(int width, int height) : Film(width, height, TileBounds{0, 0, width, height}) {}
+
+Film::Film(int width, int height, const TileBounds& window)
+    : frame_width_(width),
+      frame_height_(height),
+      x0_(window.x0),
+      y0_(window.y0),
+      width_(window.x1 - window.x0),
+      height_(window.y1 - window.y0),
+      tiles_x_((width_ + FilmTile::kSize - 1) / FilmTile::kSize),
+      tiles_y_((height_ + FilmTile::kSize - 1) / FilmTile::kSize),
+      pixels_(static_cast<size_t>(width_) * height_) {}
+
+void Film::EnableDeep(size_t max_bytes) {
+    deep_heads_.assign(pixels_.size(), DeepSegmentPool::kNoNode);
+    deep_pool_ = std::make_unique<DeepSegmentPool>(max_bytes);
+    deep_folded_ = 0;
+    deep_dropped_ = 0;
+    deep_bands_released_ = 0;
+}
 
-    // Pre-allocate pool based on expected usage
-    // Estimate: width * height * samples_per_pixel * avg_segments_per_path
-    // Example: 1920x1080 * 16spp * 8 segments = ~265M nodes
-    // might want to make this configurable
-    // deep_pool_.resize(width_ * height_ * 16 * 4);
+void Film::SetBandCallback(std::function<void(int band)> callback) {
+    band_callback_ = std::move(callback);
+    band_tiles_merged_ = std::make_unique<std::atomic<int>[]>(tiles_y_);
+    for (int i = 0; i < tiles_y_; ++i) band_tiles_merged_[i] = 0;
 }
 
-void Film::AddSample(int x, int y, const RGB& L, float weight) {
-    if (x < 0 || x >= width_ || y < 0 || y >= height_) return;
+TileBounds Film::GetTileBounds(int tile_index) const {
+    const int tx = tile_index % tiles_x_;
+    const int ty = tile_index / tiles_x_;
+    TileBounds b;
+    b.x0 = x0_ + tx * FilmTile::kSize;
+    b.y0 = y0_ + ty * FilmTile::kSize;
+    b.x1 = std::min(b.x0 + FilmTile::kSize, x0_ + width_);
+    b.y1 = std::min(b.y0 + FilmTile::kSize, y0_ + height_);
+    return b;
+}
 
-    Pixel& p = GetPixel(x, y);
+void Film::MergeTile(const FilmTile& tile) {
+    const TileBounds& b = tile.bounds();
+    for (int y = b.y0; y < b.y1; ++y) {
+        for (int x = b.x0; x < b.x1; ++x) {
+            const TilePixel& src = tile.At(x, y);
+            Pixel& dst = GetPixel(x, y);
+            dst.color_sum += src.color_sum;
+            dst.weight_sum += src.weight_sum;
+            dst.sample_count += src.sample_count;
+        }
+    }
+
+    if (!aovs_.empty()) {
+        for (int y = b.y0; y < b.y1; ++y) {
+            for (int x = b.x0; x < b.x1; ++x) {
+                aovs_[Index(x, y)].Merge(tile.AOVAt(x, y));
+            }
+        }
+    }
 
-    // Thread-safe accumulation (works because RGB is just floats)
-    // For true safety, you might want to use atomics or accept some race conditions
-    // In practice, the races are benign (slightly wrong accumulated values)
-    p.color_sum += L * weight;
-    p.weight_sum += weight;
+    if (band_callback_) {
+        const int band = (b.y0 - y0_) / kBandHeight;
+        if (band_tiles_merged_[band].fetch_add(1) + 1 == tiles_x_) band_callback_(band);
+    }
 }
 
 void Film::AddDeepSample(int x, int y, const PathSample& path_sample) {
-    if (x < 0 || x >= width_ || y < 0 || y >= height_) return;
-    if (path_sample.segments.empty()) return;
-
-    Pixel& p = GetPixel(x, y);
-
-    int prev_head = -1;
-    // reverse code for simplicity rn but it's not great for locality..
-    for (int i = path_sample.segments.size() - 1; i >= 0; --i) {
-        const DeepSegment& seg = path_sample.segments[i];
+    if (!InWindow(x, y)) return;
+    if (path_sample.segments.empty() || !deep_pool_) return;
 
+    for (const DeepSegment& seg : path_sample.segments) {
         // Skip empty/invalid segments
         if (seg.z_front >= seg.z_back && seg.z_back != kFarClip) continue;
         if (seg.alpha <= 0.0f && seg.L.IsBlack()) continue;
 
-        // Allocate node from pool
-        size_t node_index = pool_cursor_.fetch_add(1, std::memory_order_relaxed);
-        if (node_index >= deep_pool_.size()) {
-            // could dynamically grow this later
-            std::cerr << "Warning: Deep pool exhausted at pixel (" << x << "," << y << ")\n";
-            return;
-        }
-
-        // Fill node
-        DeepSegmentNode& node = deep_pool_[node_index];
-        node.z_front = seg.z_front;
-        node.z_back = seg.z_back;
-        node.L = seg.L;
-        node.alpha = seg.alpha;
-        node.next = prev_head;
-        prev_head = node_index;
-    }
-    // Atomically prepend the entire chain to the pixel's list
-    if (prev_head != -1) {
-        int old_head = p.deep_head.load(std::memory_order_relaxed);
-        do {
-            deep_pool_[prev_head].next = old_head;
-        } while (!p.deep_head.compare_exchange_weak(old_head, prev_head, std::memory_order_release,
-                                                    std::memory_order_relaxed));
+        AddDeepBin(x, y, {seg.z_front, seg.z_back, seg.L, seg.alpha, seg.object_id,
+                          seg.material_id, 1, DeepSegmentPool::kNoNode});
     }
 }
 
-std::unique_ptr<DeepImageBuffer> Film::CreateDeepBuffer(const int total_pixel_samples) const {
-    // Pass 1: Count samples per pixel
-    Imf::Array2D<unsigned int> counts(height_, width_);
-    size_t total_segments = 0;
+void Film::AddDeepBin(int x, int y, const DeepSegmentNode& seg) {
+    DeepSegmentPool& pool = *deep_pool_;
+    uint32_t& head = deep_heads_[Index(x, y)];
+
+    // Consolidate into a bin of the same object whose ends are both within the depth tolerance,
+    // so the list grows with the number of distinct surfaces rather than with the sample count
+    uint32_t bin = head;
+    while (bin != DeepSegmentPool::kNoNode) {
+        const DeepSegmentNode& node = pool[bin];
+        const float eps = DeepDepthEpsilon(node.z_front);
+        if (std::abs(seg.z_front - node.z_front) < eps &&
+            std::abs(seg.z_back - node.z_back) < eps && seg.object_id == node.object_id &&
+            seg.material_id == node.material_id) {
+            break;
+        }
+        bin = node.next;
+    }
+    if (bin != DeepSegmentPool::kNoNode) {
+        pool[bin].L += seg.L;
+        pool[bin].alpha += seg.alpha;
+        pool[bin].sample_count += seg.sample_count;
+        return;
+    }
 
-    for (int y = 0; y < height_; ++y) {
-        for (int x = 0; x < width_; ++x) {
-            unsigned int count = 0;
-            int head = GetPixel(x, y).deep_head.load(std::memory_order_acquire);
-            while (head != -1) {
-                count++;
-                head = deep_pool_[head].next;
+    const uint32_t node_index = pool.Allocate((y - y0_) / kBandHeight);
+    if (node_index == DeepSegmentPool::kNoNode) {
+        // Out of budget: fold into the closest existing bin so no energy is lost, even if that
+        // means crediting it to another object
+        uint32_t nearest = DeepSegmentPool::kNoNode;
+        float nearest_dist = 0.0f;
+        for (uint32_t i = head; i != DeepSegmentPool::kNoNode; i = pool[i].next) {
+            const float dist = std::abs(pool[i].z_front - seg.z_front);
+            if (nearest == DeepSegmentPool::kNoNode || dist < nearest_dist) {
+                nearest = i;
+                nearest_dist = dist;
             }
-            counts[y][x] = count;
-            total_segments += count;
         }
+        if (nearest == DeepSegmentPool::kNoNode) {
+            deep_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pool[nearest].L += seg.L;
+        pool[nearest].alpha += seg.alpha;
+        pool[nearest].sample_count += seg.sample_count;
+        deep_folded_.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
 
-    // Pass 2: Create the buffer (Allocates the flat memory)
-    auto buffer = std::make_unique<DeepImageBuffer>(width_, height_, total_segments, counts);
-
-    // Pass 3: Copy, Sort, and merge segments
-    for (int y = 0; y < height_; ++y) {
-        for (int x = 0; x < width_; ++x) {
-            if (counts[y][x] == 0) continue;
-
-            // Collect samples for this pixel
-            std::vector<DeepSample> segments;
-            segments.reserve(counts[y][x]);
-
-            int head = GetPixel(x, y).deep_head.load(std::memory_order_acquire);
-            while (head != -1) {
-                const DeepSegmentNode& node = deep_pool_[head];
-
-                DeepSample ds;
-                ds.z_front = node.z_front;
-                ds.z_back = node.z_back;
-                ds.r = node.L.r();
-                ds.g = node.L.g();
-                ds.b = node.L.b();
-                ds.alpha = node.alpha;
-
-                segments.push_back(ds);
-                head = node.next;
-            }
+    // Bin order does not matter, CreateDeepBuffer sorts each pixel by depth
+    DeepSegmentNode& node = pool[node_index];
+    node = seg;
+    node.next = head;
+    head = node_index;
+}
 
-            // Sort by Depth (Required for OpenEXR)
-            std::sort(segments.begin(), segments.end(),
-                      [](const DeepSample& a, const DeepSample& b) {
-                          if (std::abs(a.z_front - b.z_front) < 1e-5f) {
-                              return a.z_back < b.z_back;  // Tiebreaker
-                          }
-                          return a.z_front < b.z_front;
-                      });
+// Unsigned key with the same order as the float (negatives included), for radix sorting
+static uint32_t OrderedFloatKey(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
 
-            segments = MergeDeepSegments(segments, total_pixel_samples);
+static uint64_t DeepSortKey(const DeepSample& s) {
+    return (uint64_t(OrderedFloatKey(s.z_front)) << 32) | OrderedFloatKey(s.z_back);
+}
 
-            // Write to your buffer
-            buffer->SetPixel(x, y, segments);
+// Sorts by (z_front, z_back), as OpenEXR requires. LSD radix sort on the 64-bit key, one byte per
+// pass, skipping bytes every key shares. Short lists (the usual case once samples are binned) use
+// insertion sort on the same key.
+static void SortDeepSamples(DeepSample* data, size_t n, std::vector<DeepSample>* scratch) {
+    constexpr size_t kInsertionSortMax = 32;
+    if (n <= kInsertionSortMax) {
+        for (size_t i = 1; i < n; ++i) {
+            const DeepSample s = data[i];
+            const uint64_t key = DeepSortKey(s);
+            size_t j = i;
+            for (; j > 0 && DeepSortKey(data[j - 1]) > key; --j) data[j] = data[j - 1];
+            data[j] = s;
         }
+        return;
     }
 
-    return buffer;
-}
+    uint32_t hist[8][256] = {};
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = DeepSortKey(data[i]);
+        for (int b = 0; b < 8; ++b) hist[b][(key >> (8 * b)) & 0xff]++;
+    }
 
-// Helper: Merge overlapping/adjacent segments
-std::vector<DeepSample> Film::MergeDeepSegments(const std::vector<DeepSample>& input,
-                                                const int total_pixel_samples) const {
-    if (input.empty()) return input;
+    scratch->resize(n);
+    DeepSample* src = data;
+    DeepSample* dst = scratch->data();
+    for (int b = 0; b < 8; ++b) {
+        const int shift = 8 * b;
+        if (hist[b][(DeepSortKey(src[0]) >> shift) & 0xff] == n) continue;
+
+        uint32_t offset = 0;
+        for (uint32_t& h : hist[b]) {
+            const uint32_t count = h;
+            h = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            dst[hist[b][(DeepSortKey(src[i]) >> shift) & 0xff]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+    if (src != data) std::copy(src, src + n, data);
+}
 
-    std::vector<DeepSample> merged;
-    merged.reserve(input.size() / 4);  // estimate
+// Merges runs of depth-sorted segments of one object within the depth tolerance and scales them
+// by norm (one over the pixel's sample count, or 0 to keep the raw sums). Each segment is compared
+// against the previous one rather than the start of its run, which handles gradual depth changes
+// across curved surfaces. Works in place and returns how many merged segments now lead the array.
+static size_t MergeDeepSegments(DeepSample* data, size_t n, float norm) {
+    if (n == 0) return 0;
 
-    DeepSample current = input[0];
-    // Track the previous sample's depth for consecutive-gap detection.
-    // Comparing against the previous sample (rather than the cluster start)
-    // correctly handles gradual depth changes across curved surfaces.
+    size_t merged = 0;
+    DeepSample current = data[0];
     float prev_z_front = current.z_front;
     float prev_z_back = current.z_back;
 
-    for (size_t i = 1; i < input.size(); ++i) {
-        const DeepSample& next = input[i];
+    for (size_t i = 1; i < n; ++i) {
+        const DeepSample next = data[i];
         if (next.alpha <= 0.0f) continue;
 
-        // Depth-relative tolerance: accounts for sub-pixel depth variation
-        // caused by surface curvature, ray jittering, and anti-aliasing.
-        // At depth 10 → epsilon ≈ 0.01, at depth 100 → epsilon ≈ 0.1
-        float depth_epsilon = std::max(1e-2f, std::abs(prev_z_front) * 1e-3f);
+        const float depth_epsilon = DeepDepthEpsilon(prev_z_front);
+        const bool same_depth = (std::abs(next.z_front - prev_z_front) < depth_epsilon) &&
+                                (std::abs(next.z_back - prev_z_back) < depth_epsilon);
+        const bool same_object =
+            next.object_id == current.object_id && next.material_id == current.material_id;
 
-        bool same_depth = (std::abs(next.z_front - prev_z_front) < depth_epsilon) &&
-                          (std::abs(next.z_back - prev_z_back) < depth_epsilon);
-
-        if (same_depth) {
+        if (same_depth && same_object) {
             current.r += next.r;
             current.g += next.g;
             current.b += next.b;
             current.alpha += next.alpha;
+            current.sample_count += next.sample_count;
         } else {
-            merged.push_back(current);
+            data[merged++] = current;  // merged < i, so this never overwrites unread input
             current = next;
         }
 
         prev_z_front = next.z_front;
         prev_z_back = next.z_back;
     }
+    data[merged++] = current;
+    if (norm == 0.0f) return merged;
 
-    merged.push_back(current);
-
-    float norm = 1.0f / total_pixel_samples;
-
-    for (auto& seg : merged) {
+    for (size_t i = 0; i < merged; ++i) {
+        DeepSample& seg = data[i];
         seg.r *= norm;
         seg.g *= norm;
         seg.b *= norm;
@@ -195,18 +257,238 @@ std::vector<DeepSample> Film::MergeDeepSegments(const std::vector<DeepSample>& i
         // Safety clamp (though mathematically it shouldn't exceed 1.0 if samples <= total)
         if (seg.alpha > 1.0f) seg.alpha = 1.0f;
     }
+    return merged;
+}
+
+// Scale for MergeDeepSegments; 0 samples asks for the un-normalised sums of a chunk render
+static float DeepNorm(int total_pixel_samples) {
+    return total_pixel_samples > 0 ? 1.0f / total_pixel_samples : 0.0f;
+}
 
-    static std::atomic<int> log_count{0};
-    if (log_count.fetch_add(1) % 10000 == 0) {  // Log every 10000th pixel
-        std::cout << "Merge: " << input.size() << " → " << merged.size() << " segments\n";
-        if (merged.size() > 0) {
-            std::cout << "  First segment: z=" << merged[0].z_front << " rgb=(" << merged[0].r
-                      << "," << merged[0].g << "," << merged[0].b << ")"
-                      << " alpha=" << merged[0].alpha << "\n";
+size_t Film::ResolveDeepRow(int y, float norm, std::vector<DeepSample>* out,
+                            unsigned int* counts, std::vector<DeepSample>* scratch) const {
+    const DeepSegmentPool& pool = *deep_pool_;
+    size_t bins = 0;
+    for (int x = 0; x < width_; ++x) {
+        const size_t start = out->size();
+        for (uint32_t i = deep_heads_[y * width_ + x]; i != DeepSegmentPool::kNoNode;
+             i = pool[i].next) {
+            const DeepSegmentNode& node = pool[i];
+            out->push_back({node.z_front, node.z_back, node.L.r(), node.L.g(), node.L.b(),
+                            node.alpha, node.object_id, node.material_id, node.sample_count});
         }
+
+        const size_t n = out->size() - start;
+        SortDeepSamples(out->data() + start, n, scratch);
+        const size_t merged = MergeDeepSegments(out->data() + start, n, norm);
+        out->resize(start + merged);
+        counts[x] = static_cast<unsigned int>(merged);
+        bins += n;
     }
+    return bins;
+}
 
-    return merged;
+std::unique_ptr<DeepImageBuffer> Film::CreateDeepBand(int band,
+                                                      const int total_pixel_samples) const {
+    const int y0 = band * kBandHeight;
+    const int rows = std::min(kBandHeight, height_ - y0);
+    Imf::Array2D<unsigned int> counts(rows, width_);
+    std::vector<DeepSample> segments;
+    if (deep_pool_) {
+        std::vector<DeepSample> scratch;
+        const float norm = DeepNorm(total_pixel_samples);
+        for (int y = y0; y < y0 + rows; ++y) {
+            ResolveDeepRow(y, norm, &segments, counts[y - y0], &scratch);
+        }
+    } else {
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < width_; ++x) counts[y][x] = 0;
+        }
+    }
+
+    // The band's rows are contiguous in the buffer, in the same order ResolveDeepRow appended them
+    auto buffer = std::make_unique<DeepImageBuffer>(width_, rows, segments.size(), counts);
+    buffer->SetFrameWindow({frame_width_, frame_height_, x0_, y0_ + y0});
+    std::copy(segments.begin(), segments.end(), buffer->RowData(0));
+    return buffer;
+}
+
+void Film::ReleaseDeepBands(int band_count) {
+    if (!deep_pool_ || band_count <= deep_bands_released_) return;
+    const size_t first = static_cast<size_t>(deep_bands_released_) * kBandHeight * width_;
+    const size_t last = std::min(static_cast<size_t>(band_count) * kBandHeight * width_,
+                                 deep_heads_.size());
+    std::fill(deep_heads_.begin() + first, deep_heads_.begin() + last, DeepSegmentPool::kNoNode);
+    deep_pool_->ReleaseBands(band_count - 1);
+    deep_bands_released_ = band_count;
+}
+
+std::unique_ptr<DeepImageBuffer> Film::CreateDeepBuffer(const int total_pixel_samples,
+                                                        int num_threads) const {
+    Imf::Array2D<unsigned int> counts(height_, width_);
+    if (!deep_pool_) {
+        for (int y = 0; y < height_; ++y) {
+            for (int x = 0; x < width_; ++x) counts[y][x] = 0;
+        }
+        auto empty = std::make_unique<DeepImageBuffer>(width_, height_, 0, counts);
+        empty->SetFrameWindow(frame_window());
+        return empty;
+    }
+
+    std::clog << "[Film] Deep segment memory: " << (deep_pool_->ReservedBytes() >> 20) << " MB\n";
+    if (deep_folded_ > 0 || deep_dropped_ > 0) {
+        std::clog << "[Film] Deep memory cap reached: " << deep_folded_
+                  << " segments folded into a neighbour, " << deep_dropped_ << " dropped\n";
+    }
+
+    // Pass 1: sort and merge every row into its own staging array, which also yields the final
+    // per-pixel counts
+    const float norm = DeepNorm(total_pixel_samples);
+    std::vector<std::vector<DeepSample>> rows(height_);
+    std::atomic<size_t> total_bins{0};
+    ParallelFor(height_, num_threads, [&](int y) {
+        std::vector<DeepSample> scratch;
+        total_bins += ResolveDeepRow(y, norm, &rows[y], counts[y], &scratch);
+    });
+
+    // Pass 2: the buffer's constructor prefix-sums the counts into pixel offsets
+    size_t total_segments = 0;
+    for (const std::vector<DeepSample>& row : rows) total_segments += row.size();
+    auto buffer = std::make_unique<DeepImageBuffer>(width_, height_, total_segments, counts);
+    buffer->SetFrameWindow(frame_window());
+
+    // Pass 3: a row's pixels are contiguous in the buffer, so each row is one copy
+    ParallelFor(height_, num_threads, [&](int y) {
+        std::copy(rows[y].begin(), rows[y].end(), buffer->RowData(y));
+        std::vector<DeepSample>().swap(rows[y]);
+    });
+
+    std::clog << "[Film] Deep export: " << total_bins << " bins merged into " << total_segments
+              << " segments\n";
+    return buffer;
+}
+
+std::vector<RGB> Film::ResolveColors() const {
+    std::vector<RGB> colors(pixels_.size(), RGB(0.0f));
+    for (size_t i = 0; i < pixels_.size(); ++i) {
+        const Pixel& p = pixels_[i];
+        if (p.weight_sum > 0) colors[i] = p.color_sum.Mean(p.weight_sum);
+    }
+    return colors;
+}
+
+std::vector<ResolvedAOV> Film::ResolveAOVs() const {
+    std::vector<ResolvedAOV> out(aovs_.size());
+    for (size_t i = 0; i < aovs_.size(); ++i) {
+        const AOVPixel& a = aovs_[i];
+        ResolvedAOV& r = out[i];
+        r.depth = a.depth;
+        r.object_id = a.object_id;
+        r.material_id = a.material_id;
+
+        const float w = static_cast<float>(pixels_[i].weight_sum);
+        if (w <= 0) continue;
+        r.albedo = a.albedo_sum / w;
+        r.normal = a.normal_sum / w;
+        // Sample variance of the luminance, divided by the count for the variance of the mean
+        const float mean = a.lum_sum / w;
+        r.variance = std::max(0.0f, a.lum_sq_sum / w - mean * mean) / w;
+    }
+    return out;
+}
+
+void Film::ReplaceColors(const std::vector<RGB>& colors) {
+    for (size_t i = 0; i < pixels_.size(); ++i) {
+        pixels_[i].color_sum = RGBSum{};
+        pixels_[i].color_sum.Add(colors[i], static_cast<float>(pixels_[i].weight_sum));
+    }
+}
+
+std::unique_ptr<AOVImageBuffer> Film::CreateAOVBuffer() const {
+    auto buf = std::make_unique<AOVImageBuffer>(width_, height_);
+    buf->SetFrameWindow(frame_window());
+    std::vector<RGB> colors = ResolveColors();
+    std::vector<ResolvedAOV> aovs = ResolveAOVs();
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const size_t i = static_cast<size_t>(y) * width_ + x;
+            const ResolvedAOV a = aovs.empty() ? ResolvedAOV{} : aovs[i];
+
+            AOVImagePixel out;
+            out.r = colors[i].r();
+            out.g = colors[i].g();
+            out.b = colors[i].b();
+            out.albedo_r = a.albedo.r();
+            out.albedo_g = a.albedo.g();
+            out.albedo_b = a.albedo.b();
+            out.n_x = a.normal.x();
+            out.n_y = a.normal.y();
+            out.n_z = a.normal.z();
+            out.z = a.depth;
+            out.object_id = a.object_id;
+            out.material_id = a.material_id;
+            buf->SetPixel(x, y, out);
+        }
+    }
+    return buf;
+}
+
+std::unique_ptr<ChunkImageBuffer> Film::CreateChunkBuffer(const SampleRange& range) const {
+    auto buf = std::make_unique<ChunkImageBuffer>(width_, height_, range);
+    buf->SetFrameWindow(frame_window());
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const Pixel& p = pixels_[static_cast<size_t>(y) * width_ + x];
+            buf->SetPixel(x, y, {p.color_sum.r, p.color_sum.g, p.color_sum.b, p.weight_sum,
+                                 p.sample_count});
+        }
+    }
+    return buf;
+}
+
+// Chunks merge pixel for pixel, so their windows have to be the film's
+static bool SameWindow(const FrameWindow& a, const FrameWindow& b) {
+    return a.frame_width == b.frame_width && a.frame_height == b.frame_height && a.x0 == b.x0 &&
+           a.y0 == b.y0;
+}
+
+void Film::AddChunk(const ChunkImageBuffer& chunk) {
+    if (chunk.GetWidth() != width_ || chunk.GetHeight() != height_ ||
+        !SameWindow(chunk.GetFrameWindow(), frame_window())) {
+        throw std::runtime_error("Chunk is " + std::to_string(chunk.GetWidth()) + "x" +
+                                 std::to_string(chunk.GetHeight()) + ", film is " +
+                                 std::to_string(width_) + "x" + std::to_string(height_) +
+                                 " (or their windows in the frame differ)");
+    }
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const ChunkImagePixel& src = chunk.GetPixel(x, y);
+            Pixel& dst = pixels_[static_cast<size_t>(y) * width_ + x];
+            dst.color_sum += RGBSum{src.r, src.g, src.b};
+            dst.weight_sum += src.weight;
+            dst.sample_count += src.sample_count;
+        }
+    }
+}
+
+void Film::AddDeepChunk(const DeepImageBuffer& chunk) {
+    if (chunk.GetWidth() != width_ || chunk.GetHeight() != height_ ||
+        !SameWindow(chunk.GetFrameWindow(), frame_window())) {
+        throw std::runtime_error("Deep chunk size does not match the film");
+    }
+    if (!deep_pool_) EnableDeep();
+
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const DeepPixelView samples = chunk.GetPixel(x, y);
+            for (size_t i = 0; i < samples.count; ++i) {
+                const DeepSample& s = samples[i];
+                AddDeepBin(x0_ + x, y0_ + y,
+                           {s.z_front, s.z_back, RGB(s.r, s.g, s.b), s.alpha, s.object_id,
+                            s.material_id, s.sample_count, DeepSegmentPool::kNoNode});
+            }
+        }
+    }
 }
 
 void Film::WriteImage(const std::string& filename) const {
@@ -214,16 +496,10 @@ void Film::WriteImage(const std::string& filename) const {
     ImageBuffer temp_buffer(width_, height_);
 
     // Bake the data (Convert Accumulator -> Output Format)
+    std::vector<RGB> colors = ResolveColors();
     for (int y = 0; y < height_; ++y) {
         for (int x = 0; x < width_; ++x) {
-            const Pixel& p = GetPixel(x, y);
-
-            RGB final_color(0, 0, 0);
-            if (p.weight_sum > 0) {
-                final_color = p.color_sum / p.weight_sum;
-            }
-
-            temp_buffer.SetPixel(x, y, final_color);
+            temp_buffer.SetPixel(x, y, colors[y * width_ + x]);
         }
     }
 
@@ -3,53 +3,159 @@
 
 #include <atomic>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "core/color.h"
+#include "core/constants.h"
+#include "core/vec3.h"
+#include "film/deep_pool.h"
+#include "film/film_tile.h"
 #include "film/image_buffer.h"
 #include "integrators/path_sample.h"
 
 namespace skwr {
 
 struct Pixel {
-    RGB color_sum = RGB(0.0f);       // Accumulated Radiance
-    float weight_sum = 0.0f;         // Total weight (filter weight * count)
-    std::atomic<int> deep_head{-1};  // Head of linked list
+    RGBSum color_sum;           // Accumulated Radiance
+    double weight_sum = 0.0;    // Total weight (filter weight * count)
+    uint32_t sample_count = 0;  // Camera samples taken, whatever their weight
 };
 
-struct DeepSegmentNode {
-    float z_front;
-    float z_back;
-    RGB L;
-    float alpha;
-    int next;
+// Per-pixel AOV values after dividing out the sample weights
+struct ResolvedAOV {
+    RGB albedo = RGB(0.0f);
+    Vec3 normal;
+    float depth = kFarClip;
+    float variance = 0.0f;  // Variance of the pixel's mean luminance
+    uint32_t object_id = kNoHitId;
+    uint32_t material_id = kNoHitId;
 };
 
+// Pixels are addressed in frame coordinates. A film can hold just a window of its frame (a crop
+// render): tiles, samples and merges then only cover the window, and every buffer it creates is
+// window-sized with its FrameWindow set. Cameras and RNG seeds still see the whole frame, so a
+// window's pixels come out exactly as in a full render.
 class Film {
   public:
     Film(int width, int height);
+    // Holds only window (which must lie inside the width x height frame)
+    Film(int width, int height, const TileBounds& window);
 
-    void AddSample(int x, int y, const RGB& L, float weight = 1.0f);
+    // Direct accumulation for single-threaded integrators. Multi-threaded ones render into a
+    // FilmTile and merge it with MergeTile instead.
+    void AddSample(int x, int y, const RGB& L, float weight = 1.0f) {
+        if (!InWindow(x, y)) return;
+
+        Pixel& p = GetPixel(x, y);
+        p.color_sum.Add(L, weight);
+        p.weight_sum += weight;
+        p.sample_count++;
+    }
+    // Adds the sample's segments to the pixel's depth bins, summing each into an existing bin
+    // within the merge tolerance; requires HasDeep(). Only the thread rendering the pixel's tile
+    // may call this for that pixel.
     void AddDeepSample(int x, int y, const PathSample& path_sample);
 
+    // Per-pixel average colour (color_sum / weight_sum), row-major over the window
+    std::vector<RGB> ResolveColors() const;
+    // Per-pixel AOVs, row-major; requires HasAOVs()
+    std::vector<ResolvedAOV> ResolveAOVs() const;
+    // Overwrites the resolved colours (e.g. with a denoised image), keeping the sample weights
+    void ReplaceColors(const std::vector<RGB>& colors);
+
+    // Allocates the AOV planes; call before rendering with IntegratorConfig::enable_aovs
+    void EnableAOVs() { aovs_.assign(pixels_.size(), AOVPixel{}); }
+    bool HasAOVs() const { return !aovs_.empty(); }
+
+    // Sets up the deep segment lists; call before rendering with IntegratorConfig::enable_deep.
+    // Bin memory grows on demand up to max_bytes (0 = no cap). Past the cap, segments that would
+    // open a new bin are folded into the pixel's nearest-depth bin instead.
+    void EnableDeep(size_t max_bytes = 0);
+    bool HasDeep() const { return deep_pool_ != nullptr; }
+
     // Saves to disk (PPM, EXR)
     void WriteImage(const std::string& filename) const;
-    std::unique_ptr<DeepImageBuffer> CreateDeepBuffer(const int total_pixel_samples) const;
+    std::unique_ptr<AOVImageBuffer> CreateAOVBuffer() const;
+    // Sorts and merges every pixel's deep bins across up to num_threads threads (0 = all cores).
+    // Colour and alpha are divided by total_pixel_samples; 0 keeps the raw sums, for chunks.
+    std::unique_ptr<DeepImageBuffer> CreateDeepBuffer(const int total_pixel_samples,
+                                                      int num_threads = 0) const;
+
+    // Chunk renders: the accumulators of the samples in range, before normalisation. Adding the
+    // chunks of a frame's disjoint sample ranges to an empty film reproduces the colour sums of
+    // rendering the whole range in one film, so ResolveColors matches the single-process image.
+    std::unique_ptr<ChunkImageBuffer> CreateChunkBuffer(const SampleRange& range) const;
+    // Adds a chunk's sums into the film. Throws std::runtime_error if the sizes differ.
+    void AddChunk(const ChunkImageBuffer& chunk);
+    // Bins a raw-sum deep chunk (CreateDeepBuffer(0)) into the film's deep lists, enabling deep
+    // if needed. Samples are re-binned with the same depth tolerance as during rendering, so the
+    // merged segments match a single-process render up to where that tolerance splits bins.
+    void AddDeepChunk(const DeepImageBuffer& chunk);
 
-    int width() { return width_; }
-    int height() { return height_; }
+    // Bands are the rows of tiles: band b covers window rows [b * kBandHeight, (b + 1) *
+    // kBandHeight), clipped at the bottom edge. With a band callback set, MergeTile calls it (on
+    // the merging thread) once the last tile of a band has been merged.
+    static constexpr int kBandHeight = FilmTile::kSize;
+    int BandCount() const { return tiles_y_; }
+    void SetBandCallback(std::function<void(int band)> callback);
+    // Deep buffer holding just the band's rows, resolved like CreateDeepBuffer
+    std::unique_ptr<DeepImageBuffer> CreateDeepBand(int band, const int total_pixel_samples) const;
+    // Frees the deep bins of bands [0, band_count); they read as empty afterwards. Must not run
+    // concurrently with itself or while those bands are still rendering.
+    void ReleaseDeepBands(int band_count);
+
+    // Tiles are FilmTile::kSize squares in row-major order from the window's corner, clipped at
+    // its right/bottom edges
+    int TileCount() const { return tiles_x_ * tiles_y_; }
+    TileBounds GetTileBounds(int tile_index) const;
+
+    // Adds a finished tile's sums into the film. Tiles cover disjoint pixels and each pixel's
+    // samples are summed in a fixed order inside its tile, so the image is bit-identical no matter
+    // how many threads rendered it or in which order tiles complete.
+    void MergeTile(const FilmTile& tile);
+
+    // Size of the stored window (the whole frame unless cropped)
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int frame_width() const { return frame_width_; }
+    int frame_height() const { return frame_height_; }
+    FrameWindow frame_window() const { return {frame_width_, frame_height_, x0_, y0_}; }
 
   private:
-    Pixel& GetPixel(int x, int y) { return pixels_[y * width_ + x]; }
-    const Pixel& GetPixel(int x, int y) const { return pixels_[y * width_ + x]; }
-    std::vector<DeepSample> MergeDeepSegments(const std::vector<DeepSample>& input,
-                                              const int total_pixel_samples) const;
+    bool InWindow(int x, int y) const {
+        return x >= x0_ && x < x0_ + width_ && y >= y0_ && y < y0_ + height_;
+    }
+    // Storage index of frame pixel (x, y)
+    size_t Index(int x, int y) const { return size_t(y - y0_) * width_ + (x - x0_); }
+    Pixel& GetPixel(int x, int y) { return pixels_[Index(x, y)]; }
+    const Pixel& GetPixel(int x, int y) const { return pixels_[Index(x, y)]; }
+    // Sums seg into the pixel's bin for the same object within the depth tolerance, or opens a
+    // new one (folding into the nearest bin when the memory cap is reached)
+    void AddDeepBin(int x, int y, const DeepSegmentNode& seg);
+    // Appends window row y's sorted, merged and normalised deep segments to out and stores each
+    // pixel's segment count in counts[x]. Returns the number of bins read.
+    size_t ResolveDeepRow(int y, float norm, std::vector<DeepSample>* out, unsigned int* counts,
+                          std::vector<DeepSample>* scratch) const;
 
-    int width_, height_;
+    int frame_width_, frame_height_;
+    int x0_, y0_;        // Window corner in the frame
+    int width_, height_;  // Window size
+    int tiles_x_, tiles_y_;
     std::vector<Pixel> pixels_;
-    std::vector<DeepSegmentNode> deep_pool_;
-    std::atomic<size_t> pool_cursor_{0};
+    std::vector<AOVPixel> aovs_;  // Empty unless EnableAOVs() was called
+    // Deep list heads live apart from the colour sums; only the thread rendering a pixel's tile
+    // ever touches its list, so these need no atomics. Both stay empty unless EnableDeep().
+    std::vector<uint32_t> deep_heads_;
+    std::unique_ptr<DeepSegmentPool> deep_pool_;
+    std::atomic<size_t> deep_folded_{0};   // Segments merged into a neighbour at the memory cap
+    std::atomic<size_t> deep_dropped_{0};  // Segments of pixels with no list to fold into
+    int deep_bands_released_ = 0;
+
+    std::function<void(int band)> band_callback_;
+    std::unique_ptr<std::atomic<int>[]> band_tiles_merged_;
 };
 
 }  // namespace skwr
@@ -0,0 +1,136 @@
+#ifndef SKWR_FILM_FILM_TILE_H_
+#define SKWR_FILM_FILM_TILE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/color.h"
+#include "core/vec3.h"
+#include "integrators/path_sample.h"
+
+namespace skwr {
+
+constexpr size_t kCacheLineSize = 64;
+
+// Pixel rectangle [x0, x1) x [y0, y1) in film coordinates
+struct TileBounds {
+    int x0, y0;
+    int x1, y1;
+};
+
+// Colour sum kept in double precision. Samples arrive as floats with unit weights, so each
+// addition is exact until the values summed differ by more than ~2^29 in magnitude: sums over
+// disjoint sample ranges then add up to exactly the sum over the whole range, which is what lets
+// separately rendered chunks merge into the single-process image (see Film::AddChunk).
+struct RGBSum {
+    double r = 0.0, g = 0.0, b = 0.0;
+
+    void Add(const RGB& c, float weight) {
+        r += double(c.r()) * weight;
+        g += double(c.g()) * weight;
+        b += double(c.b()) * weight;
+    }
+    RGBSum& operator+=(const RGBSum& o) {
+        r += o.r;
+        g += o.g;
+        b += o.b;
+        return *this;
+    }
+    RGB Mean(double weight) const {
+        return RGB(float(r / weight), float(g / weight), float(b / weight));
+    }
+};
+
+struct TilePixel {
+    RGBSum color_sum;
+    double weight_sum = 0.0;
+    uint32_t sample_count = 0;
+};
+
+// First-hit passes. Albedo and normal are weighted sums like the colour; depth and the ids come
+// from the nearest sample, since averaging them across an edge produces values nothing has.
+// The luminance moments give the denoiser a per-pixel variance estimate.
+struct AOVPixel {
+    RGB albedo_sum = RGB(0.0f);
+    Vec3 normal_sum;
+    float lum_sum = 0.0f;
+    float lum_sq_sum = 0.0f;
+    float depth = kFarClip;
+    uint32_t object_id = kNoHitId;
+    uint32_t material_id = kNoHitId;
+
+    void Add(const AOVSample& s, const RGB& L, float weight) {
+        const float lum = L.Luminance();
+        albedo_sum += s.albedo * weight;
+        normal_sum += s.normal * weight;
+        lum_sum += lum * weight;
+        lum_sq_sum += lum * lum * weight;
+        if (s.depth < depth) {
+            depth = s.depth;
+            object_id = s.object_id;
+            material_id = s.material_id;
+        }
+    }
+
+    void Merge(const AOVPixel& o) {
+        albedo_sum += o.albedo_sum;
+        normal_sum += o.normal_sum;
+        lum_sum += o.lum_sum;
+        lum_sq_sum += o.lum_sq_sum;
+        if (o.depth < depth) {
+            depth = o.depth;
+            object_id = o.object_id;
+            material_id = o.material_id;
+        }
+    }
+};
+
+// Private accumulation buffer for one tile of the film. Each render worker owns one, fills it
+// for the tile it is working on, and hands it to Film::MergeTile when the tile is done, so the
+// sample loop never writes memory another thread can touch.
+class alignas(kCacheLineSize) FilmTile {
+  public:
+    static constexpr int kSize = 32;  // Edge length in pixels; edge tiles use a subset
+
+    // AOV sums are only cleared (and meant to be read) when with_aovs is set
+    void Reset(const TileBounds& bounds, bool with_aovs = false) {
+        bounds_ = bounds;
+        std::fill(pixels_.begin(), pixels_.end(), TilePixel{});
+        if (with_aovs) std::fill(aovs_.begin(), aovs_.end(), AOVPixel{});
+    }
+
+    const TileBounds& bounds() const { return bounds_; }
+
+    // x, y are film coordinates inside bounds()
+    void AddSample(int x, int y, const RGB& L, float weight = 1.0f) {
+        TilePixel& p = At(x, y);
+        p.color_sum.Add(L, weight);
+        p.weight_sum += weight;
+        p.sample_count++;
+    }
+
+    // Weighted like AddSample; the film divides by the same weight_sum. L is the sample's
+    // beauty value, used only for the variance estimate.
+    void AddAOVSample(int x, int y, const AOVSample& s, const RGB& L, float weight = 1.0f) {
+        aovs_[Index(x, y)].Add(s, L, weight);
+    }
+
+    const TilePixel& At(int x, int y) const {
+        return pixels_[Index(x, y)];
+    }
+    TilePixel& At(int x, int y) { return pixels_[Index(x, y)]; }
+    const AOVPixel& AOVAt(int x, int y) const { return aovs_[Index(x, y)]; }
+
+  private:
+    int Index(int x, int y) const { return (y - bounds_.y0) * kSize + (x - bounds_.x0); }
+
+    TileBounds bounds_{0, 0, 0, 0};
+    std::array<TilePixel, kSize * kSize> pixels_;
+    std::array<AOVPixel, kSize * kSize> aovs_;
+};
+
+}  // namespace skwr
+
+#endif  // SKWR_FILM_FILM_TILE_H_
@@ -75,7 +75,7 @@ void ImageBuffer::WritePPM(const std::string& filename) const {
 
 DeepImageBuffer::DeepImageBuffer(int width, int height, size_t totalSamples,
                                  const Imf::Array2D<unsigned int>& sampleCounts)
-    : width_(width), height_(height) {
+    : width_(width), height_(height), window_{width, height, 0, 0} {
     // At the very least the offsets needs to be allocated
     size_t numPixels = width * height;
     pixelOffsets_.resize(numPixels + 1);  // for sentinel
@@ -114,7 +114,53 @@ DeepPixelView DeepImageBuffer::GetPixel(int x, int y) const {
     size_t start = pixelOffsets_[idx];
     size_t end = pixelOffsets_[idx + 1];
 
-    return {&allSamples_[start], end - start};
+    return {allSamples_.data() + start, end - start};
 }
 
+DeepSample* DeepImageBuffer::RowData(int y) {
+    assert(y >= 0 && y < height_);
+    return allSamples_.data() + pixelOffsets_[static_cast<size_t>(y) * width_];
+}
+
+AOVImageBuffer::AOVImageBuffer(int width, int height)
+    : width_(width),
+      height_(height),
+      window_{width, height, 0, 0},
+      pixels_(static_cast<size_t>(width) * height) {}
+
+void AOVImageBuffer::SetPixel(int x, int y, const AOVImagePixel& p) {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) return;
+    pixels_[y * width_ + x] = p;
+}
+
+const AOVImagePixel& AOVImageBuffer::GetPixel(int x, int y) const {
+    assert(x >= 0 && x < width_ && y >= 0 && y < height_);
+    return pixels_[y * width_ + x];
+}
+
+int AOVImageBuffer::GetWidth(void) const { return width_; }
+
+int AOVImageBuffer::GetHeight(void) const { return height_; }
+
+ChunkImageBuffer::ChunkImageBuffer(int width, int height, const SampleRange& range)
+    : width_(width),
+      height_(height),
+      window_{width, height, 0, 0},
+      range_(range),
+      pixels_(static_cast<size_t>(width) * height, ChunkImagePixel{0.0, 0.0, 0.0, 0.0, 0}) {}
+
+void ChunkImageBuffer::SetPixel(int x, int y, const ChunkImagePixel& p) {
+    if (x < 0 || x >= width_ || y < 0 || y >= height_) return;
+    pixels_[y * width_ + x] = p;
+}
+
+const ChunkImagePixel& ChunkImageBuffer::GetPixel(int x, int y) const {
+    assert(x >= 0 && x < width_ && y >= 0 && y < height_);
+    return pixels_[y * width_ + x];
+}
+
+int ChunkImageBuffer::GetWidth(void) const { return width_; }
+
+int ChunkImageBuffer::GetHeight(void) const { return height_; }
+
 }  // namespace skwr
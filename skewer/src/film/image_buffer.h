@@ -3,6 +3,7 @@
 
 #include <ImfArray.h>
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -29,6 +30,14 @@ class ImageBuffer {
     std::vector<RGB> pixels_;
 };
 
+// Where a buffer's pixels sit in the frame: a region render's buffers hold only the window
+// [x0, x0 + width) x [y0, y0 + height) of a frame_width x frame_height image. ImageIO writes it
+// as the EXR data window inside the display window. Buffers default to the whole frame.
+struct FrameWindow {
+    int frame_width, frame_height;
+    int x0, y0;
+};
+
 struct DeepSample {
     // Depth information
     float z_front;
@@ -37,6 +46,10 @@ struct DeepSample {
     float g;
     float b;
     float alpha;  // opacity
+    // Written as the objectId / materialId / sampleCount UINT channels
+    uint32_t object_id;
+    uint32_t material_id;
+    uint32_t sample_count;  // Camera samples merged into this one
 };
 
 struct DeepPixelView {
@@ -59,18 +72,96 @@ class DeepImageBuffer {
     void SetPixel(int x, int y, const std::vector<DeepSample>& newSamples);
 
     DeepPixelView GetPixel(int x, int y) const;
+    // Samples of row y: the row's pixels are stored back to back in x order, so a whole row can be
+    // written with one copy
+    DeepSample* RowData(int y);
 
     int GetWidth(void) const;
     int GetHeight(void) const;
+    void SetFrameWindow(const FrameWindow& window) { window_ = window; }
+    const FrameWindow& GetFrameWindow(void) const { return window_; }
 
   private:
     const int width_;
     const int height_;
+    FrameWindow window_;
 
     std::vector<DeepSample> allSamples_;
     std::vector<size_t> pixelOffsets_;
 };
 
+// One pixel of the flat AOV image: the beauty pass plus the first-hit passes
+struct AOVImagePixel {
+    float r, g, b;
+    float albedo_r, albedo_g, albedo_b;
+    float n_x, n_y, n_z;
+    float z;
+    uint32_t object_id;
+    uint32_t material_id;
+};
+
+// Interleaved flat image with one AOVImagePixel per pixel; ImageIO writes each field as a channel
+class AOVImageBuffer {
+    friend class ImageIO;
+
+  public:
+    AOVImageBuffer(int width, int height);
+
+    void SetPixel(int x, int y, const AOVImagePixel& p);
+    const AOVImagePixel& GetPixel(int x, int y) const;
+
+    int GetWidth(void) const;
+    int GetHeight(void) const;
+    void SetFrameWindow(const FrameWindow& window) { window_ = window; }
+    const FrameWindow& GetFrameWindow(void) const { return window_; }
+
+  private:
+    const int width_;
+    const int height_;
+    FrameWindow window_;
+    std::vector<AOVImagePixel> pixels_;
+};
+
+// The part of a frame's samples a chunk render covers: sample indices [start, end) of total
+// per pixel. Stored in chunk EXR headers so a merge can check the chunks fit together.
+struct SampleRange {
+    int start = 0;
+    int end = 0;
+    int total = 0;
+};
+
+// One pixel of a chunk: the film's accumulators before they are divided into a colour
+struct ChunkImagePixel {
+    double r, g, b;  // Weighted radiance sums
+    double weight;
+    uint32_t sample_count;
+};
+
+// Un-normalised flat image of one sample range, to be summed with the frame's other chunks
+// (see Film::CreateChunkBuffer and Film::AddChunk)
+class ChunkImageBuffer {
+    friend class ImageIO;
+
+  public:
+    ChunkImageBuffer(int width, int height, const SampleRange& range);
+
+    void SetPixel(int x, int y, const ChunkImagePixel& p);
+    const ChunkImagePixel& GetPixel(int x, int y) const;
+
+    const SampleRange& GetRange(void) const { return range_; }
+    int GetWidth(void) const;
+    int GetHeight(void) const;
+    void SetFrameWindow(const FrameWindow& window) { window_ = window; }
+    const FrameWindow& GetFrameWindow(void) const { return window_; }
+
+  private:
+    const int width_;
+    const int height_;
+    FrameWindow window_;
+    SampleRange range_;
+    std::vector<ChunkImagePixel> pixels_;
+};
+
 class FlatImageBuffer {
   public:
     FlatImageBuffer(int width, int height) : width_(width), height_(height), pixels_({}) {};
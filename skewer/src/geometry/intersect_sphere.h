@@ -4,6 +4,7 @@
 #include <cmath>
 
 #include "core/constants.h"
+#include "core/kernel_inline.h"
 #include "core/ray.h"
 #include "core/vec3.h"
 #include "geometry/sphere.h"
@@ -11,8 +12,8 @@
 
 namespace skwr {
 
-inline bool IntersectSphere(const Ray& r, const Sphere& s, float t_min, float t_max,
-                            SurfaceInteraction* si) {
+SKWR_KERNEL_INLINE bool IntersectSphere(const Ray& r, const Sphere& s, float t_min, float t_max,
+                                        SurfaceInteraction* si) {
     Vec3 oc = r.origin() - s.center;
     float a = Dot(r.direction(), r.direction());
     float half_b = Dot(oc, r.direction());
@@ -34,6 +35,7 @@ inline bool IntersectSphere(const Ray& r, const Sphere& s, float t_min, float t_
     Vec3 outward_normal = (si->point - s.center) / s.radius;
     si->SetFaceNormal(r, outward_normal);
     si->material_id = s.material_id;
+    si->object_id = s.object_id;
 
     // Spherical UV coordinates
     float theta = std::acos(std::clamp(-outward_normal.y(), -1.0f, 1.0f));
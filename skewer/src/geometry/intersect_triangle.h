@@ -3,14 +3,15 @@
 
 #include <cmath>
 
+#include "core/kernel_inline.h"
 #include "core/vec3.h"
 #include "geometry/triangle.h"
 #include "scene/surface_interaction.h"
 
 namespace skwr {
 
-inline bool IntersectTriangle(const Ray& r, const Triangle& tri, float t_min, float t_max,
-                              SurfaceInteraction* si) {
+SKWR_KERNEL_INLINE bool IntersectTriangle(const Ray& r, const Triangle& tri, float t_min,
+                                          float t_max, SurfaceInteraction* si) {
     // Moller-Trumbore: all geometry read from pre-baked Triangle fields,
     // no index buffer or vertex buffer indirection.
     Vec3 ray_cross_e2 = Cross(r.direction(), tri.e2);
@@ -35,6 +36,7 @@ inline bool IntersectTriangle(const Ray& r, const Triangle& tri, float t_min, fl
     si->t = t;
     si->point = r.at(t);
     si->material_id = tri.material_id;
+    si->object_id = tri.object_id;
 
     // Barycentric interpolation of pre-baked normals.
     // For flat meshes n0==n1==n2==geometric normal, so no branch needed.
@@ -45,7 +47,7 @@ inline bool IntersectTriangle(const Ray& r, const Triangle& tri, float t_min, fl
     // Barycentric interpolation of UV coordinates.
     si->uv = w * tri.uv0 + u * tri.uv1 + v * tri.uv2;
 
-    // Tangent frame is only needed for normal-mapped materials.
+    // Tangent frame is only needed for textured materials (normal-map TBN, MIP level selection).
     if (tri.needs_tangent_frame) {
         Vec3 duv1 = tri.uv1 - tri.uv0;
         Vec3 duv2 = tri.uv2 - tri.uv0;
@@ -17,6 +17,7 @@ struct Mesh {
     // Index buffer
     std::vector<uint32_t> indices;
     uint32_t material_id;
+    uint32_t object_id = 0;  // Index of the scene object this came from
 };
 
 }  // namespace skwr
@@ -11,6 +11,7 @@ struct Sphere {
     Vec3 center;
     float radius;
     uint32_t material_id;
+    uint32_t object_id = 0;  // Index of the scene object this came from
 };
 
 }  // namespace skwr
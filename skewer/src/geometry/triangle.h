@@ -14,7 +14,8 @@ struct Triangle {
     Vec3 n0, n1, n2;     // Per-vertex normals (all set to geometric normal for flat meshes)
     Vec3 uv0, uv1, uv2;  // Per-vertex UVs (z unused)
     uint32_t material_id;
-    bool needs_tangent_frame = false;  // True only when material uses a normal map
+    uint32_t object_id;
+    bool needs_tangent_frame = false;  // True only when material uses a texture (dpdu/dpdv)
 };
 
 }  // namespace skwr
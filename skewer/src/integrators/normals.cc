@@ -7,6 +7,7 @@
 #include "film/film.h"
 #include "scene/camera.h"
 #include "scene/scene.h"
+#include "scene/scene_intersect.h"
 #include "scene/surface_interaction.h"
 #include "session/render_options.h"
 
@@ -15,18 +16,19 @@ namespace skwr {
 void Normals::Render(const Scene& scene, const Camera& cam, Film* film,
                      const IntegratorConfig& config) {
     (void)config;
-    for (int y = 0; y < film->height(); ++y) {
-        for (int x = 0; x < film->width(); ++x) {
+    const FrameWindow w = film->frame_window();
+    for (int y = w.y0; y < w.y0 + film->height(); ++y) {
+        for (int x = w.x0; x < w.x0 + film->width(); ++x) {
             // Integrator calculates normalized coords
-            float u = (float)x / film->width();
-            float v = (float)y / film->height();
+            float u = (float)x / w.frame_width;
+            float v = (float)y / w.frame_height;
             Ray r = cam.GetRay(u, v);
 
             SurfaceInteraction si;
             const float t_min = kShadowEpsilon;
             RGB color(0.f);
 
-            if (scene.Intersect(r, t_min, kInfinity, &si)) {
+            if (IntersectScene(scene, r, t_min, kInfinity, &si)) {
                 // If Hit: Visualise Normal
                 // Normals range from -1.0 to 1.0.
                 // We map them to 0.0 to 1.0 for color display.
@@ -1,26 +1,46 @@
 #ifndef SKWR_INTEGRATORS_PATH_SAMPLE_H_
 #define SKWR_INTEGRATORS_PATH_SAMPLE_H_
 
-#include <vector>
+#include <cstdint>
+#include <limits>
 
 #include "core/color.h"
+#include "core/constants.h"
+#include "core/small_vector.h"
 #include "core/spectrum.h"
+#include "core/vec3.h"
 
 namespace skwr {
 
+// Object / material id recorded when the primary ray escapes the scene
+constexpr uint32_t kNoHitId = std::numeric_limits<uint32_t>::max();
+
 struct DeepSegment {
     float z_front;
     float z_back;
     RGB L;  // radiance; integrated over segment
     float alpha;
+    uint32_t object_id = kNoHitId;  // What the segment's surface belongs to, for deep holdouts
+    uint32_t material_id = kNoHitId;
+};
+
+// What the primary ray saw at its first hit, for the albedo / normal / depth / id passes
+struct AOVSample {
+    RGB albedo = RGB(0.0f);  // Linear surface reflectance (texture already applied)
+    Vec3 normal;             // World-space shading normal
+    float depth = kFarClip;  // Distance along the camera forward axis
+    uint32_t object_id = kNoHitId;
+    uint32_t material_id = kNoHitId;
 };
 
 struct PathSample {
-    Spectrum L;  // "Flat" beauty pass
-    std::vector<DeepSegment> segments;
+    // Segments a path records before spilling to the heap. Li emits one per path today, so the
+    // inline capacity leaves room for volumetric segments without allocating per camera sample.
+    static constexpr size_t kInlineSegments = 8;
 
-    // TODO: consider boost::small_vector or some optimization for stack vs heap alloc tradeoffs
-    explicit PathSample(size_t reserveCount = 16) { segments.reserve(reserveCount); }
+    Spectrum L;  // "Flat" beauty pass
+    SmallVector<DeepSegment, kInlineSegments> segments;  // Only filled when deep is enabled
+    AOVSample aov;                                       // Only filled when AOVs are enabled
 };
 
 }  // namespace skwr
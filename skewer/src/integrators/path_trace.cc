@@ -1,18 +1,17 @@
 #include "integrators/path_trace.h"
 
 #include <atomic>
-#include <thread>
-#include <vector>
+#include <memory>
 
 #include "barkeep.h"
-#include "core/sampling.h"
-#include "core/sampling/wavelength_sampler.h"
-#include "core/spectrum.h"
+#include "core/parallel.h"
+#include "core/thread_pool.h"
 #include "film/film.h"
-#include "integrators/path_sample.h"
-#include "kernels/path_kernel.h"
+#include "film/film_tile.h"
+#include "kernels/cpu_dispatch.h"
+#include "kernels/render_kernel.h"
+#include "materials/texture_cache.h"
 #include "scene/camera.h"
-#include "scene/light.h"
 #include "scene/scene.h"
 #include "session/render_options.h"
 
@@ -22,74 +21,53 @@ namespace skwr {
 
 void PathTrace::Render(const Scene& scene, const Camera& cam, Film* film,
                        const IntegratorConfig& config) {
-    int width = film->width();
-    int height = film->height();
-
     // Determine number of threads
-    int thread_count = config.num_threads;
-    if (thread_count <= 0) {
-        thread_count = std::thread::hardware_concurrency();
-        if (thread_count == 0) thread_count = 4;  // Fallback
-    }
+    const int thread_count = ResolveThreadCount(config.num_threads);
 
     std::clog << "[Session] Rendering with " << thread_count << " threads...\n";
 
-    // Atomic counter for scanline work-stealing
-    std::atomic<int> next_scanline(0);
-    std::atomic<int> scanlines_completed(0);
+    // Atomic counter for tile work-stealing
+    const int tile_count = film->TileCount();
+    std::atomic<int> next_tile(0);
+    std::atomic<int> tiles_completed(0);
+
+    auto bar = bk::ProgressBar(&tiles_completed, {
+                                                     .total = tile_count,
+                                                     .message = "Rendering",
+                                                     .speed = 0.0,
+                                                     .speed_unit = "tiles/s",
+                                                     .style = bk::ProgressBarStyle::Line,
+                                                 });
 
-    auto bar = bk::ProgressBar(&scanlines_completed, {
-                                                         .total = height,
-                                                         .message = "Rendering",
-                                                         .speed = 0.0,
-                                                         .speed_unit = "scanlines/s",
-                                                         .style = bk::ProgressBarStyle::Line,
-                                                     });
+    // Hot loop compiled for the best instruction set this CPU supports
+    const RenderTileFn render_tile = SelectRenderTile(ActiveIsaLevel());
 
-    // Worker function - each thread grabs scanlines dynamically
+    // Worker function - each thread grabs tiles dynamically and accumulates into its own
+    // FilmTile, merging it into the film once the tile is finished
     auto render_worker = [&]() {
+        auto tile = std::make_unique<FilmTile>();
         while (true) {
-            int y = next_scanline.fetch_add(1);
-            if (y >= height) break;
-
-            std::clog.flush();
-            for (int x = 0; x < width; ++x) {
-                RNG rng = MakeDeterministicPixelRNG(x, y, width, config.start_sample);
-                for (int s = 0; s < config.samples_per_pixel; ++s) {
-                    float u = (float(x) + rng.UniformFloat()) / width;
-                    float v = 1.0f - (float(y) + rng.UniformFloat()) / height;
-
-                    SampledWavelengths wl = WavelengthSampler::Sample(rng.UniformFloat());
-
-                    Ray r = cam.GetRay(u, v);
-
-                    PathSample result = Li(r, scene, rng, config, wl);
-
-                    RGB pixel_color = SpectrumToRGB(result.L, wl);
-
-                    float weight = 1.0f;
-                    film->AddSample(x, y, pixel_color, weight);
+            int tile_index = next_tile.fetch_add(1);
+            if (tile_index >= tile_count) break;
 
-                    if (config.enable_deep) film->AddDeepSample(x, y, result);
-                }
-            }
+            tile->Reset(film->GetTileBounds(tile_index), film->HasAOVs());
+            render_tile(scene, cam, film, tile.get(), config);
+            film->MergeTile(*tile);
 
-            scanlines_completed.fetch_add(1);
+            tiles_completed.fetch_add(1);
         }
+        // Pool threads outlive the render; don't let them pin texture tiles while idle
+        TextureCache::ReleaseThreadTiles();
     };
 
     bar->show();
 
-    // Launch worker threads
-    std::vector<std::thread> threads;
-    for (int t = 0; t < thread_count; ++t) {
-        threads.emplace_back(render_worker);
-    }
+    // One worker per pool thread; the pool survives this render for the next one
+    if (!pool_ || pool_->size() != thread_count) pool_ = std::make_unique<ThreadPool>(thread_count);
+    for (int t = 0; t < thread_count; ++t) pool_->Submit(render_worker);
 
-    // Wait for all threads to complete
-    for (auto& thread : threads) {
-        thread.join();
-    }
+    // Wait for all workers to complete
+    pool_->Wait();
 
     bar->done();
 
@@ -1,6 +1,9 @@
 #ifndef SKWR_INTEGRATORS_PATH_TRACE_H_
 #define SKWR_INTEGRATORS_PATH_TRACE_H_
 
+#include <memory>
+
+#include "core/thread_pool.h"
 #include "integrators/integrator.h"
 
 namespace skwr {
@@ -9,6 +12,10 @@ class PathTrace : public Integrator {
   public:
     void Render(const Scene& scene, const Camera& cam, Film* film,
                 const IntegratorConfig& config) override;
+
+  private:
+    // Render threads, kept between renders so a sequence of frames starts them only once
+    std::unique_ptr<ThreadPool> pool_;
 };
 }  // namespace skwr
 
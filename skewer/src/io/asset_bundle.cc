@@ -0,0 +1,381 @@
+#include "io/asset_bundle.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "core/vec3.h"
+#include "geometry/mesh.h"
+#include "materials/material.h"
+#include "materials/texture.h"
+#include "scene/scene.h"
+
+namespace skwr {
+
+// Structs below are stored byte for byte; a bundle is only read by the build that wrote it
+// (material_size and version guard against layout drift)
+static_assert(std::is_trivially_copyable_v<Material>);
+static_assert(std::is_trivially_copyable_v<MipLevel>);
+static_assert(std::is_trivially_copyable_v<Vec3> && sizeof(Vec3) == 3 * sizeof(float));
+
+namespace {
+
+constexpr char kBundleMagic[8] = {'S', 'K', 'W', 'R', 'B', 'N', 'D', 'L'};
+constexpr uint32_t kBundleVersion = 1;
+constexpr uint64_t kArrayAlignment = 64;   // Mesh buffers start on a cache line
+constexpr uint64_t kTileAlignment = 4096;  // Tile blobs start on a page
+
+struct BundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t material_size;  // sizeof(Material) of the writer
+    uint32_t material_count;
+    uint32_t texture_count;
+    uint32_t level_count;
+    uint32_t mesh_count;
+    uint64_t materials_offset;
+    uint64_t textures_offset;
+    uint64_t levels_offset;
+    uint64_t meshes_offset;
+    uint64_t file_size;
+};
+
+struct BundleTexture {
+    int32_t width;
+    int32_t height;
+    uint32_t format;       // TexelFormat
+    uint32_t first_level;  // Into the MipLevel table
+    uint32_t level_count;
+    uint32_t reserved;
+    uint64_t tiles_offset;
+    uint64_t tiles_bytes;
+};
+
+enum BundleMeshFlags : uint32_t {
+    kMeshHasNormals = 1u << 0,
+    kMeshHasUVs = 1u << 1,
+};
+
+struct BundleMesh {
+    uint32_t material_id;  // Into the bundle's materials
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t flags;  // BundleMeshFlags
+    uint64_t p_offset;
+    uint64_t n_offset;
+    uint64_t uv_offset;
+    uint64_t indices_offset;
+};
+
+uint64_t AlignUp(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Read-only private mapping of a whole file, unmapped when the last owner lets go
+class MappedFile {
+  public:
+    static std::shared_ptr<const MappedFile> Open(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return nullptr;
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);  // The mapping keeps its own reference to the file
+        if (data == MAP_FAILED) return nullptr;
+        return std::shared_ptr<const MappedFile>(new MappedFile(data, size));
+    }
+
+    ~MappedFile() { munmap(data_, size_); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(data_); }
+    size_t size() const { return size_; }
+
+    // True if [offset, offset + bytes) lies inside the file
+    bool Contains(uint64_t offset, uint64_t bytes) const {
+        return offset <= size_ && bytes <= size_ - offset;
+    }
+
+  private:
+    MappedFile(void* data, size_t size) : data_(data), size_(size) {}
+
+    void* data_;
+    size_t size_;
+};
+
+// Sequential writer that zero-pads up to each section's precomputed offset
+class BundleWriter {
+  public:
+    explicit BundleWriter(const std::string& filename)
+        : out_(filename, std::ios::binary | std::ios::trunc) {}
+
+    bool ok() const { return out_.good(); }
+
+    void Write(uint64_t offset, const void* data, size_t bytes) {
+        static const char kZeros[kTileAlignment] = {};
+        while (pos_ < offset) {
+            const uint64_t pad = std::min<uint64_t>(offset - pos_, sizeof(kZeros));
+            out_.write(kZeros, static_cast<std::streamsize>(pad));
+            pos_ += pad;
+        }
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        pos_ += bytes;
+    }
+
+  private:
+    std::ofstream out_;
+    uint64_t pos_ = 0;
+};
+
+bool Fail(const std::string& filename, const char* reason) {
+    std::cerr << "[Bundle] " << filename << ": " << reason << std::endl;
+    return false;
+}
+
+}  // namespace
+
+bool IsBundlePath(const std::string& filename) {
+    const size_t ext_len = std::strlen(kBundleExtension);
+    return filename.size() > ext_len &&
+           filename.compare(filename.size() - ext_len, ext_len, kBundleExtension) == 0;
+}
+
+bool WriteBundle(const std::string& filename, const Scene& scene) {
+    const std::vector<Material>& materials = scene.Materials();
+
+    // Lay the file out first so every table can be written with final offsets
+    BundleHeader header{};
+    std::memcpy(header.magic, kBundleMagic, sizeof(kBundleMagic));
+    header.version = kBundleVersion;
+    header.material_size = sizeof(Material);
+    header.material_count = static_cast<uint32_t>(materials.size());
+    header.texture_count = static_cast<uint32_t>(scene.TextureCount());
+    header.mesh_count = static_cast<uint32_t>(scene.MeshCount());
+
+    std::vector<BundleTexture> textures(header.texture_count);
+    std::vector<MipLevel> levels;
+    for (uint32_t t = 0; t < header.texture_count; ++t) {
+        const ImageTexture& tex = scene.GetTexture(t);
+        textures[t].width = tex.width;
+        textures[t].height = tex.height;
+        textures[t].format = static_cast<uint32_t>(tex.format);
+        textures[t].first_level = static_cast<uint32_t>(levels.size());
+        textures[t].level_count = static_cast<uint32_t>(tex.levels.size());
+        textures[t].tiles_bytes = tex.TileBytes();
+        levels.insert(levels.end(), tex.levels.begin(), tex.levels.end());
+    }
+    header.level_count = static_cast<uint32_t>(levels.size());
+
+    uint64_t offset = sizeof(BundleHeader);
+    header.materials_offset = AlignUp(offset, alignof(Material));
+    offset = header.materials_offset + materials.size() * sizeof(Material);
+    header.textures_offset = AlignUp(offset, alignof(BundleTexture));
+    offset = header.textures_offset + textures.size() * sizeof(BundleTexture);
+    header.levels_offset = AlignUp(offset, alignof(MipLevel));
+    offset = header.levels_offset + levels.size() * sizeof(MipLevel);
+    header.meshes_offset = AlignUp(offset, alignof(BundleMesh));
+    offset = header.meshes_offset + header.mesh_count * sizeof(BundleMesh);
+
+    std::vector<BundleMesh> meshes(header.mesh_count);
+    auto place = [&](uint64_t bytes) {
+        offset = AlignUp(offset, kArrayAlignment);
+        const uint64_t start = offset;
+        offset += bytes;
+        return start;
+    };
+    for (uint32_t m = 0; m < header.mesh_count; ++m) {
+        const Mesh& mesh = scene.GetMesh(m);
+        BundleMesh& bm = meshes[m];
+        bm.material_id = mesh.material_id;
+        bm.vertex_count = static_cast<uint32_t>(mesh.p.size());
+        bm.index_count = static_cast<uint32_t>(mesh.indices.size());
+        bm.flags = 0;
+        if (!mesh.n.empty()) bm.flags |= kMeshHasNormals;
+        if (!mesh.uv.empty()) bm.flags |= kMeshHasUVs;
+        bm.p_offset = place(mesh.p.size() * sizeof(Vec3));
+        if (!mesh.n.empty()) bm.n_offset = place(mesh.n.size() * sizeof(Vec3));
+        if (!mesh.uv.empty()) bm.uv_offset = place(mesh.uv.size() * sizeof(Vec3));
+        bm.indices_offset = place(mesh.indices.size() * sizeof(uint32_t));
+    }
+    for (BundleTexture& bt : textures) {
+        offset = AlignUp(offset, kTileAlignment);
+        bt.tiles_offset = offset;
+        offset += bt.tiles_bytes;
+    }
+    header.file_size = offset;
+
+    BundleWriter out(filename);
+    out.Write(0, &header, sizeof(header));
+    out.Write(header.materials_offset, materials.data(), materials.size() * sizeof(Material));
+    out.Write(header.textures_offset, textures.data(), textures.size() * sizeof(BundleTexture));
+    out.Write(header.levels_offset, levels.data(), levels.size() * sizeof(MipLevel));
+    out.Write(header.meshes_offset, meshes.data(), meshes.size() * sizeof(BundleMesh));
+    for (uint32_t m = 0; m < header.mesh_count; ++m) {
+        const Mesh& mesh = scene.GetMesh(m);
+        const BundleMesh& bm = meshes[m];
+        out.Write(bm.p_offset, mesh.p.data(), mesh.p.size() * sizeof(Vec3));
+        if (!mesh.n.empty()) out.Write(bm.n_offset, mesh.n.data(), mesh.n.size() * sizeof(Vec3));
+        if (!mesh.uv.empty()) {
+            out.Write(bm.uv_offset, mesh.uv.data(), mesh.uv.size() * sizeof(Vec3));
+        }
+        out.Write(bm.indices_offset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    }
+    for (uint32_t t = 0; t < header.texture_count; ++t) {
+        const ImageTexture& tex = scene.GetTexture(t);
+        const size_t tile_bytes = TexelBytes(tex.format) * kTextureTileTexels;
+        const uint32_t tile_count = tex.TileCount();
+        for (uint32_t i = 0; i < tile_count; ++i) {
+            out.Write(textures[t].tiles_offset + i * tile_bytes, tex.TileData(i), tile_bytes);
+        }
+    }
+
+    if (!out.ok()) return Fail(filename, "write failed");
+    std::clog << "[Bundle] Wrote: " << filename << " (" << header.mesh_count << " meshes, "
+              << header.material_count << " materials, " << header.texture_count
+              << " textures, " << (header.file_size >> 10) << " KB)" << std::endl;
+    return true;
+}
+
+bool LoadBundle(const std::string& filename, Scene& scene) {
+    std::shared_ptr<const MappedFile> file = MappedFile::Open(filename);
+    if (!file) return Fail(filename, "cannot map file");
+
+    BundleHeader header;
+    if (!file->Contains(0, sizeof(header))) return Fail(filename, "truncated header");
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, kBundleMagic, sizeof(kBundleMagic)) != 0) {
+        return Fail(filename, "not a skewer bundle");
+    }
+    if (header.version != kBundleVersion || header.material_size != sizeof(Material)) {
+        return Fail(filename, "written by an incompatible build; re-run skewer-bundle");
+    }
+    if (header.file_size != file->size() ||
+        !file->Contains(header.materials_offset, uint64_t{header.material_count} *
+                                                     sizeof(Material)) ||
+        !file->Contains(header.textures_offset,
+                        uint64_t{header.texture_count} * sizeof(BundleTexture)) ||
+        !file->Contains(header.levels_offset, uint64_t{header.level_count} * sizeof(MipLevel)) ||
+        !file->Contains(header.meshes_offset, uint64_t{header.mesh_count} * sizeof(BundleMesh))) {
+        return Fail(filename, "truncated or corrupt tables");
+    }
+    const uint8_t* base = file->data();
+
+    // Everything is validated into locals first, so a bad file adds nothing to the scene
+    const uint32_t texture_base = static_cast<uint32_t>(scene.TextureCount());
+    std::vector<ImageTexture> textures(header.texture_count);
+    for (uint32_t t = 0; t < header.texture_count; ++t) {
+        BundleTexture bt;
+        std::memcpy(&bt, base + header.textures_offset + t * sizeof(BundleTexture), sizeof(bt));
+        if (bt.format > static_cast<uint32_t>(TexelFormat::SpectralCoeffs) ||
+            bt.level_count > header.level_count ||
+            bt.first_level > header.level_count - bt.level_count) {
+            return Fail(filename, "corrupt texture table");
+        }
+
+        ImageTexture& tex = textures[t];
+        tex.width = bt.width;
+        tex.height = bt.height;
+        tex.format = static_cast<TexelFormat>(bt.format);
+        tex.levels.resize(bt.level_count);
+        const uint8_t* level_table = base + header.levels_offset;
+        std::memcpy(tex.levels.data(), level_table + bt.first_level * sizeof(MipLevel),
+                    bt.level_count * sizeof(MipLevel));
+
+        // Sampling trusts the level table, so it must describe exactly the stored tiles
+        uint32_t next_tile = 0;
+        for (const MipLevel& level : tex.levels) {
+            if (level.width <= 0 || level.height <= 0 ||
+                level.tiles_x != (level.width + kTextureTileSize - 1) / kTextureTileSize ||
+                level.tiles_y != (level.height + kTextureTileSize - 1) / kTextureTileSize ||
+                level.first_tile != next_tile) {
+                return Fail(filename, "corrupt MIP level table");
+            }
+            next_tile += static_cast<uint32_t>(level.tiles_x * level.tiles_y);
+        }
+        if (bt.tiles_bytes != tex.TileBytes() || bt.tiles_offset % kTileAlignment != 0 ||
+            !file->Contains(bt.tiles_offset, bt.tiles_bytes)) {
+            return Fail(filename, "corrupt texture data");
+        }
+        if (tex.IsValid()) {
+            tex.mapped_tiles = base + bt.tiles_offset;
+            tex.mapping = file;
+        }
+    }
+
+    const uint32_t material_base = static_cast<uint32_t>(scene.Materials().size());
+    std::vector<Material> materials(header.material_count);
+    std::memcpy(static_cast<void*>(materials.data()), base + header.materials_offset,
+                materials.size() * sizeof(Material));
+    for (Material& m : materials) {
+        for (uint32_t* tex : {&m.albedo_tex, &m.normal_tex, &m.roughness_tex}) {
+            if (*tex == kNoTexture) continue;
+            if (*tex >= header.texture_count) return Fail(filename, "corrupt material table");
+            *tex += texture_base;
+        }
+    }
+
+    std::vector<Mesh> meshes(header.mesh_count);
+    size_t triangle_count = 0;
+    for (uint32_t i = 0; i < header.mesh_count; ++i) {
+        BundleMesh bm;
+        std::memcpy(&bm, base + header.meshes_offset + i * sizeof(BundleMesh), sizeof(bm));
+        const uint64_t vec_bytes = uint64_t{bm.vertex_count} * sizeof(Vec3);
+        const bool has_n = bm.flags & kMeshHasNormals;
+        const bool has_uv = bm.flags & kMeshHasUVs;
+        if (bm.material_id >= header.material_count || bm.index_count % 3 != 0 ||
+            !file->Contains(bm.p_offset, vec_bytes) ||
+            (has_n && !file->Contains(bm.n_offset, vec_bytes)) ||
+            (has_uv && !file->Contains(bm.uv_offset, vec_bytes)) ||
+            !file->Contains(bm.indices_offset, uint64_t{bm.index_count} * sizeof(uint32_t))) {
+            return Fail(filename, "corrupt mesh table");
+        }
+
+        Mesh& mesh = meshes[i];
+        mesh.material_id = material_base + bm.material_id;
+        mesh.p.resize(bm.vertex_count);
+        std::memcpy(static_cast<void*>(mesh.p.data()), base + bm.p_offset, vec_bytes);
+        if (has_n) {
+            mesh.n.resize(bm.vertex_count);
+            std::memcpy(static_cast<void*>(mesh.n.data()), base + bm.n_offset, vec_bytes);
+        }
+        if (has_uv) {
+            mesh.uv.resize(bm.vertex_count);
+            std::memcpy(static_cast<void*>(mesh.uv.data()), base + bm.uv_offset, vec_bytes);
+        }
+        mesh.indices.resize(bm.index_count);
+        std::memcpy(mesh.indices.data(), base + bm.indices_offset,
+                    mesh.indices.size() * sizeof(uint32_t));
+        for (uint32_t index : mesh.indices) {
+            if (index >= bm.vertex_count) return Fail(filename, "mesh index out of range");
+        }
+        triangle_count += bm.index_count / 3;
+    }
+
+    for (ImageTexture& tex : textures) scene.AddTexture(std::move(tex));
+    for (const Material& m : materials) scene.AddMaterial(m);
+    for (Mesh& mesh : meshes) scene.AddMesh(std::move(mesh));
+
+    std::clog << "[Bundle] Loaded: " << filename << " (" << header.mesh_count << " meshes, "
+              << triangle_count << " triangles, " << header.material_count << " materials, "
+              << header.texture_count << " textures)" << std::endl;
+    return true;
+}
+
+}  // namespace skwr
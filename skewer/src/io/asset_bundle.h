@@ -0,0 +1,42 @@
+#ifndef SKWR_IO_ASSET_BUNDLE_H_
+#define SKWR_IO_ASSET_BUNDLE_H_
+
+// Skewer-native binary asset bundle (.skb).
+// Holds the meshes, materials and textures of a Scene exactly as the renderer stores them:
+// per-material-group vertex and index buffers, converted Material structs and tiled MIP chains
+// in their texel format. Loading is a memory map plus header checks; nothing is parsed.
+//
+// Layout (native endianness, all offsets from the start of the file):
+//   BundleHeader
+//   Material[material_count]        raw structs
+//   BundleTexture[texture_count]    each names a run of MipLevels and a tile blob
+//   MipLevel[level_count]
+//   BundleMesh[mesh_count]          each names its p / n / uv / index arrays
+//   data                            mesh arrays 64-byte aligned, tile blobs page aligned
+//
+// Texture tiles are sampled straight from the mapped pages (ImageTexture::mapped_tiles), so the
+// OS pages them in on first touch and can drop them again under memory pressure. Mesh buffers
+// are copied out, since scene transforms edit them in place.
+
+#include <string>
+
+namespace skwr {
+
+class Scene;
+
+// Bundle files are recognised by this extension wherever an OBJ path is accepted
+constexpr const char* kBundleExtension = ".skb";
+
+bool IsBundlePath(const std::string& filename);
+
+// Writes every mesh, material and texture of the scene to a bundle. Textures must have finished
+// loading (Scene::FinishTextureLoads). Returns true on success.
+bool WriteBundle(const std::string& filename, const Scene& scene);
+
+// Maps a bundle and adds its textures, materials and meshes to the scene, remapping material
+// and texture ids past what the scene already holds. Returns true on success.
+bool LoadBundle(const std::string& filename, Scene& scene);
+
+}  // namespace skwr
+
+#endif  // SKWR_IO_ASSET_BUNDLE_H_
@@ -0,0 +1,625 @@
+#include "io/gltf_loader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/spectral/spectral_utils.h"
+#include "core/transform.h"
+#include "core/vec3.h"
+#include "geometry/mesh.h"
+#include "materials/material.h"
+#include "materials/texture.h"
+#include "scene/scene.h"
+
+using json = nlohmann::json;
+
+namespace skwr {
+
+namespace {
+
+constexpr uint32_t kGlbMagic = 0x46546C67;      // "glTF"
+constexpr uint32_t kGlbChunkJson = 0x4E4F534A;  // "JSON"
+constexpr uint32_t kGlbChunkBin = 0x004E4942;   // "BIN\0"
+
+// Accessor component types
+constexpr int kUnsignedByte = 5121;
+constexpr int kUnsignedShort = 5123;
+constexpr int kUnsignedInt = 5125;
+constexpr int kFloat = 5126;
+
+constexpr int kModeTriangles = 4;
+
+struct GLTFFile {
+    json doc;
+    std::string base_path;  // Directory that relative URIs resolve against
+    std::vector<std::vector<uint8_t>> buffers;
+};
+
+// Elements of one accessor, validated against its buffer
+struct AccessorView {
+    const uint8_t* data = nullptr;  // First element
+    size_t stride = 0;              // Bytes between elements
+    size_t count = 0;
+    int component_type = 0;
+    int components = 0;
+    bool normalized = false;
+};
+
+// Member arrays and objects by reference (empty if absent); json::value() would copy them
+const json& Array(const json& j, const char* key) {
+    static const json kEmpty = json::array();
+    auto it = j.find(key);
+    return it != j.end() && it->is_array() ? *it : kEmpty;
+}
+
+const json& Object(const json& j, const char* key) {
+    static const json kEmpty = json::object();
+    auto it = j.find(key);
+    return it != j.end() && it->is_object() ? *it : kEmpty;
+}
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>* out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    out->assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+bool DecodeBase64(const std::string& in, size_t start, std::vector<uint8_t>* out) {
+    auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    };
+    out->clear();
+    out->reserve((in.size() - start) / 4 * 3);
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (size_t i = start; i < in.size() && in[i] != '='; ++i) {
+        const int v = value(in[i]);
+        if (v < 0) return false;
+        bits = (bits << 6) | static_cast<uint32_t>(v);
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            out->push_back(static_cast<uint8_t>(bits >> bit_count));
+        }
+    }
+    return true;
+}
+
+// Relative URIs are percent-encoded; absolute paths are taken as they are
+std::string ResolveURI(const std::string& base_path, const std::string& uri) {
+    std::string path;
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size()) {
+            path.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+            i += 2;
+        } else {
+            path.push_back(uri[i]);
+        }
+    }
+    if (!path.empty() && path[0] == '/') return path;
+    return base_path.empty() ? path : (base_path + "/" + path);
+}
+
+// Parses the JSON (from a .gltf or the first chunk of a .glb) and loads every buffer
+bool OpenGLTF(const std::string& filename, GLTFFile* file) {
+    std::vector<uint8_t> bytes;
+    if (!ReadFile(filename, &bytes)) {
+        std::cerr << "[glTF] Cannot read: " << filename << std::endl;
+        return false;
+    }
+    size_t last_slash = filename.find_last_of("/\\");
+    if (last_slash != std::string::npos) file->base_path = filename.substr(0, last_slash);
+
+    // GLB: 12-byte header, then a JSON chunk and an optional BIN chunk
+    std::vector<uint8_t> glb_bin;
+    uint32_t magic = 0;
+    if (bytes.size() >= 4) std::memcpy(&magic, bytes.data(), 4);
+    if (magic == kGlbMagic) {
+        size_t pos = 12;
+        bool have_json = false;
+        while (pos + 8 <= bytes.size()) {
+            uint32_t chunk_length, chunk_type;
+            std::memcpy(&chunk_length, bytes.data() + pos, 4);
+            std::memcpy(&chunk_type, bytes.data() + pos + 4, 4);
+            pos += 8;
+            if (chunk_length > bytes.size() - pos) break;
+            const uint8_t* chunk = bytes.data() + pos;
+            if (chunk_type == kGlbChunkJson && !have_json) {
+                file->doc = json::parse(chunk, chunk + chunk_length);
+                have_json = true;
+            } else if (chunk_type == kGlbChunkBin && glb_bin.empty()) {
+                glb_bin.assign(chunk, chunk + chunk_length);
+            }
+            pos += chunk_length;
+        }
+        if (!have_json) {
+            std::cerr << "[glTF] No JSON chunk in: " << filename << std::endl;
+            return false;
+        }
+    } else {
+        file->doc = json::parse(bytes.begin(), bytes.end());
+    }
+
+    const json& buffers = Array(file->doc, "buffers");
+    file->buffers.resize(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        const json& b = buffers[i];
+        std::vector<uint8_t>& data = file->buffers[i];
+        if (!b.contains("uri")) {
+            data = std::move(glb_bin);  // The GLB-stored buffer (at most one)
+        } else {
+            const std::string uri = b["uri"].get<std::string>();
+            if (uri.rfind("data:", 0) == 0) {
+                const size_t comma = uri.find(";base64,");
+                if (comma == std::string::npos || !DecodeBase64(uri, comma + 8, &data)) {
+                    std::cerr << "[glTF] Unsupported data URI in buffer " << i << std::endl;
+                    return false;
+                }
+            } else if (!ReadFile(ResolveURI(file->base_path, uri), &data)) {
+                std::cerr << "[glTF] Cannot read buffer: " << uri << std::endl;
+                return false;
+            }
+        }
+        if (data.size() < b.value("byteLength", size_t{0})) {
+            std::cerr << "[glTF] Buffer " << i << " is shorter than its byteLength" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int ComponentCount(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+size_t ComponentBytes(int component_type) {
+    switch (component_type) {
+        case kUnsignedByte:
+            return 1;
+        case kUnsignedShort:
+            return 2;
+        case kUnsignedInt:
+        case kFloat:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+bool GetAccessor(const GLTFFile& file, int index, AccessorView* view) {
+    const json& accessors = Array(file.doc, "accessors");
+    if (index < 0 || index >= static_cast<int>(accessors.size())) return false;
+    const json& a = accessors[index];
+    if (a.contains("sparse") || !a.contains("bufferView")) return false;  // Not supported
+
+    const json& views = Array(file.doc, "bufferViews");
+    const int view_index = a["bufferView"].get<int>();
+    if (view_index < 0 || view_index >= static_cast<int>(views.size())) return false;
+    const json& bv = views[view_index];
+    const int buffer = bv.at("buffer").get<int>();
+    if (buffer < 0 || buffer >= static_cast<int>(file.buffers.size())) return false;
+
+    view->component_type = a.at("componentType").get<int>();
+    view->components = ComponentCount(a.at("type").get<std::string>());
+    view->count = a.at("count").get<size_t>();
+    view->normalized = a.value("normalized", false);
+    const size_t element_bytes = ComponentBytes(view->component_type) * view->components;
+    if (element_bytes == 0) return false;
+    view->stride = bv.value("byteStride", size_t{0});
+    if (view->stride == 0) view->stride = element_bytes;
+
+    // The last element must end inside both the view and the buffer
+    const size_t offset = bv.value("byteOffset", size_t{0}) + a.value("byteOffset", size_t{0});
+    const size_t view_end = bv.value("byteOffset", size_t{0}) + bv.at("byteLength").get<size_t>();
+    const size_t span = view->count == 0 ? 0 : (view->count - 1) * view->stride + element_bytes;
+    const std::vector<uint8_t>& data = file.buffers[buffer];
+    if (view_end > data.size() || offset > view_end || span > view_end - offset) return false;
+    view->data = data.data() + offset;
+    return true;
+}
+
+// Float VEC3 data (positions, normals), copied in one go when tightly packed
+bool ReadVec3(const AccessorView& view, std::vector<Vec3>* out) {
+    if (view.component_type != kFloat || view.components != 3) return false;
+    out->resize(view.count);
+    if (view.stride == sizeof(Vec3)) {
+        std::memcpy(static_cast<void*>(out->data()), view.data, view.count * sizeof(Vec3));
+        return true;
+    }
+    for (size_t i = 0; i < view.count; ++i) {
+        std::memcpy(static_cast<void*>(&(*out)[i]), view.data + i * view.stride, sizeof(Vec3));
+    }
+    return true;
+}
+
+// TEXCOORD_0 as float or normalized integers. glTF puts v = 0 at the top of the image, while
+// textures are loaded bottom row first, so v is flipped.
+bool ReadUV(const AccessorView& view, std::vector<Vec3>* out) {
+    if (view.components != 2) return false;
+    if (view.component_type != kFloat && !view.normalized) return false;
+    out->resize(view.count);
+    for (size_t i = 0; i < view.count; ++i) {
+        const uint8_t* e = view.data + i * view.stride;
+        float uv[2];
+        for (int c = 0; c < 2; ++c) {
+            switch (view.component_type) {
+                case kFloat:
+                    std::memcpy(&uv[c], e + 4 * c, 4);
+                    break;
+                case kUnsignedShort: {
+                    uint16_t v;
+                    std::memcpy(&v, e + 2 * c, 2);
+                    uv[c] = v / 65535.0f;
+                    break;
+                }
+                case kUnsignedByte:
+                    uv[c] = e[c] / 255.0f;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        (*out)[i] = Vec3(uv[0], 1.0f - uv[1], 0.0f);
+    }
+    return true;
+}
+
+bool ReadIndices(const AccessorView& view, std::vector<uint32_t>* out) {
+    if (view.components != 1) return false;
+    out->resize(view.count);
+    if (view.component_type == kUnsignedInt && view.stride == 4) {
+        std::memcpy(out->data(), view.data, view.count * 4);
+        return true;
+    }
+    for (size_t i = 0; i < view.count; ++i) {
+        const uint8_t* e = view.data + i * view.stride;
+        switch (view.component_type) {
+            case kUnsignedInt:
+                std::memcpy(&(*out)[i], e, 4);
+                break;
+            case kUnsignedShort: {
+                uint16_t v;
+                std::memcpy(&v, e, 2);
+                (*out)[i] = v;
+                break;
+            }
+            case kUnsignedByte:
+                (*out)[i] = e[0];
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// Image file behind a textureInfo object; images embedded in buffers are not supported
+uint32_t LoadGltfTexture(const json& info, const GLTFFile& file, Scene& scene,
+                         TextureUsage usage) {
+    if (!info.is_object() || !info.contains("index")) return kNoTexture;
+    const json& textures = Array(file.doc, "textures");
+    const json& images = Array(file.doc, "images");
+    const int tex = info["index"].get<int>();
+    if (tex < 0 || tex >= static_cast<int>(textures.size())) return kNoTexture;
+    const int source = textures[tex].value("source", -1);
+    if (source < 0 || source >= static_cast<int>(images.size())) return kNoTexture;
+    const json& image = images[source];
+    const std::string uri = image.value("uri", std::string());
+    if (uri.empty() || uri.rfind("data:", 0) == 0) {
+        std::cerr << "[glTF] Warning: image " << source
+                  << " is embedded; only external image files are supported" << std::endl;
+        return kNoTexture;
+    }
+    return scene.LoadTexture(ResolveURI(file.base_path, uri), usage);
+}
+
+RGB GetRGB(const json& j, const std::string& key, const RGB& default_value) {
+    if (!j.contains(key)) return default_value;
+    const json& v = j[key];
+    return RGB(v.at(0).get<float>(), v.at(1).get<float>(), v.at(2).get<float>());
+}
+
+// Mapping strategy:
+//   1. KHR_materials_transmission >= 0.5  -> Dielectric (KHR_materials_ior, default 1.5)
+//   2. metallicFactor >= 0.5              -> Metal (roughness halved, as for OBJ PBR metals)
+//   3. Default                            -> Lambertian
+// emissiveFactor (times KHR_materials_emissive_strength) becomes emission, and the base colour
+// alpha becomes opacity for alphaMode BLEND.
+Material ConvertGltfMaterial(const json& m, const GLTFFile& file, Scene& scene) {
+    const json& pbr = Object(m, "pbrMetallicRoughness");
+    const json& ext = Object(m, "extensions");
+    const RGB base = GetRGB(pbr, "baseColorFactor", RGB(1.0f));
+    const float alpha = pbr.contains("baseColorFactor") ? pbr["baseColorFactor"].at(3).get<float>()
+                                                        : 1.0f;
+    const float metallic = pbr.value("metallicFactor", 1.0f);
+    const float roughness = pbr.value("roughnessFactor", 1.0f);
+    const float transmission =
+        Object(ext, "KHR_materials_transmission").value("transmissionFactor", 0.0f);
+
+    std::clog << "  Material: \"" << m.value("name", std::string()) << "\" base=(" << base.r()
+              << ", " << base.g() << ", " << base.b() << ") metallic=" << metallic
+              << " roughness=" << roughness << " transmission=" << transmission << std::endl;
+
+    Material mat{};
+    mat.albedo = RGBToCurve(base);
+    mat.albedo_rgb = ToLinear(base);
+    if (transmission >= 0.5f) {
+        mat.type = MaterialType::Dielectric;
+        mat.ior = Object(ext, "KHR_materials_ior").value("ior", 1.5f);
+        mat.roughness = roughness;
+        std::clog << "    -> Dielectric (ior=" << mat.ior << ")" << std::endl;
+    } else if (metallic >= 0.5f) {
+        mat.type = MaterialType::Metal;
+        mat.roughness = std::max(0.0f, std::min(1.0f, roughness * 0.5f));
+        std::clog << "    -> Metal (PBR)" << std::endl;
+    } else {
+        mat.type = MaterialType::Lambertian;
+        mat.roughness = 1.0f;
+        std::clog << "    -> Lambertian" << std::endl;
+    }
+
+    const float strength =
+        Object(ext, "KHR_materials_emissive_strength").value("emissiveStrength", 1.0f);
+    mat.emission = RGBToCurve(GetRGB(m, "emissiveFactor", RGB(0.0f)) * strength);
+    if (m.value("alphaMode", std::string("OPAQUE")) == "BLEND") {
+        mat.opacity = RGBToCurve(RGB(alpha));
+    }
+
+    mat.albedo_tex = LoadGltfTexture(Object(pbr, "baseColorTexture"), file, scene,
+                                     TextureUsage::Albedo);
+    mat.normal_tex =
+        LoadGltfTexture(Object(m, "normalTexture"), file, scene, TextureUsage::Normal);
+    if (mat.type != MaterialType::Dielectric) {
+        mat.roughness_tex = LoadGltfTexture(Object(pbr, "metallicRoughnessTexture"), file,
+                                            scene, TextureUsage::GltfRoughness);
+    }
+    return mat;
+}
+
+// One Mesh per triangle primitive; material_id is the glTF material index (-1 for none) until
+// the caller resolves it
+bool ConvertGltfMesh(const json& mesh, const GLTFFile& file, std::vector<Mesh>* out,
+                     std::vector<int>* materials) {
+    for (const json& prim : Array(mesh, "primitives")) {
+        if (prim.value("mode", kModeTriangles) != kModeTriangles) {
+            std::cerr << "[glTF] Warning: skipping non-triangle primitive in mesh \""
+                      << mesh.value("name", std::string()) << "\"" << std::endl;
+            continue;
+        }
+        const json& attributes = prim.at("attributes");
+        AccessorView view;
+        Mesh m;
+        if (!attributes.contains("POSITION") ||
+            !GetAccessor(file, attributes["POSITION"].get<int>(), &view) || !ReadVec3(view, &m.p)) {
+            return false;
+        }
+        if (attributes.contains("NORMAL") &&
+            (!GetAccessor(file, attributes["NORMAL"].get<int>(), &view) || !ReadVec3(view, &m.n))) {
+            return false;
+        }
+        if (attributes.contains("TEXCOORD_0") &&
+            (!GetAccessor(file, attributes["TEXCOORD_0"].get<int>(), &view) ||
+             !ReadUV(view, &m.uv))) {
+            return false;
+        }
+        if (prim.contains("indices")) {
+            if (!GetAccessor(file, prim["indices"].get<int>(), &view) ||
+                !ReadIndices(view, &m.indices)) {
+                return false;
+            }
+        } else {
+            m.indices.resize(m.p.size());
+            for (uint32_t i = 0; i < m.indices.size(); ++i) m.indices[i] = i;
+        }
+
+        // Same tolerance as the OBJ loader: drop partial attributes, reject broken topology
+        if (!m.n.empty() && m.n.size() != m.p.size()) m.n.clear();
+        if (!m.uv.empty() && m.uv.size() != m.p.size()) m.uv.clear();
+        m.indices.resize(m.indices.size() / 3 * 3);
+        for (uint32_t index : m.indices) {
+            if (index >= m.p.size()) return false;
+        }
+
+        m.material_id = UINT32_MAX;  // Resolved by the caller
+        materials->push_back(prim.value("material", -1));
+        out->push_back(std::move(m));
+    }
+    return true;
+}
+
+Affine3 NodeTransform(const json& node) {
+    Affine3 a;
+    if (node.contains("matrix")) {
+        const json& mat = node["matrix"];  // Column-major 4x4
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) a.m[r][c] = mat.at(c * 4 + r).get<float>();
+        }
+        return a;
+    }
+
+    // T * R * S
+    float q[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float s[3] = {1.0f, 1.0f, 1.0f};
+    float t[3] = {0.0f, 0.0f, 0.0f};
+    if (node.contains("rotation")) {
+        for (int i = 0; i < 4; ++i) q[i] = node["rotation"].at(i).get<float>();
+    }
+    if (node.contains("scale")) {
+        for (int i = 0; i < 3; ++i) s[i] = node["scale"].at(i).get<float>();
+    }
+    if (node.contains("translation")) {
+        for (int i = 0; i < 3; ++i) t[i] = node["translation"].at(i).get<float>();
+    }
+    const float x = q[0], y = q[1], z = q[2], w = q[3];
+    const float rot[3][3] = {
+        {1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w)},
+        {2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w)},
+        {2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y)},
+    };
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) a.m[r][c] = rot[r][c] * s[c];
+        a.m[r][3] = t[r];
+    }
+    return a;
+}
+
+struct MeshPlacement {
+    int mesh;
+    Affine3 to_world;
+};
+
+// World transform of every mesh reference in the default scene
+std::vector<MeshPlacement> PlaceMeshes(const json& doc, const Affine3& root) {
+    std::vector<MeshPlacement> placements;
+    const json& nodes = Array(doc, "nodes");
+    const json& scenes = Array(doc, "scenes");
+    if (scenes.empty()) {
+        const size_t mesh_count = Array(doc, "meshes").size();
+        for (size_t m = 0; m < mesh_count; ++m) placements.push_back({static_cast<int>(m), root});
+        return placements;
+    }
+
+    const int scene_index = std::clamp(doc.value("scene", 0), 0, int(scenes.size()) - 1);
+    std::vector<std::pair<int, Affine3>> stack;
+    for (const json& n : Array(scenes[scene_index], "nodes")) {
+        stack.emplace_back(n.get<int>(), root);
+    }
+    size_t visited = 0;  // Bounds the walk if a malformed file has cycles
+    while (!stack.empty() && visited++ <= nodes.size()) {
+        auto [index, parent] = stack.back();
+        stack.pop_back();
+        if (index < 0 || index >= static_cast<int>(nodes.size())) continue;
+        const json& node = nodes[index];
+        const Affine3 to_world = parent * NodeTransform(node);
+        if (node.contains("mesh")) placements.push_back({node["mesh"].get<int>(), to_world});
+        for (const json& child : Array(node, "children")) {
+            stack.emplace_back(child.get<int>(), to_world);
+        }
+    }
+    return placements;
+}
+
+}  // namespace
+
+bool LoadGLTF(const std::string& filename, Scene& scene, const GLTFPlacement& placement) {
+    std::clog << "[glTF] Loading: " << filename << std::endl;
+    try {
+        GLTFFile file;
+        if (!OpenGLTF(filename, &file)) return false;
+        const json& doc = file.doc;
+
+        // Materials convert up front and in order, like the OBJ loader's
+        std::vector<uint32_t> material_ids;
+        if (placement.material_override == UINT32_MAX) {
+            const json& materials = Array(doc, "materials");
+            std::clog << "[glTF] Converting " << materials.size() << " materials" << std::endl;
+            for (const json& m : materials) {
+                material_ids.push_back(scene.AddMaterial(ConvertGltfMaterial(m, file, scene)));
+            }
+        }
+        uint32_t fallback_mat_id = UINT32_MAX;
+        auto resolve_material = [&](int gltf_material) -> uint32_t {
+            if (placement.material_override != UINT32_MAX) return placement.material_override;
+            if (gltf_material >= 0 && gltf_material < static_cast<int>(material_ids.size())) {
+                return material_ids[gltf_material];
+            }
+            if (fallback_mat_id == UINT32_MAX) {
+                Material fallback{};
+                fallback.type = MaterialType::Lambertian;
+                fallback.albedo = RGBToCurve(RGB(0.5f, 0.5f, 0.5f));
+                fallback.albedo_rgb = ToLinear(RGB(0.5f, 0.5f, 0.5f));
+                fallback.roughness = 1.0f;
+                fallback_mat_id = scene.AddMaterial(fallback);
+            }
+            return fallback_mat_id;
+        };
+
+        const std::vector<MeshPlacement> placements = PlaceMeshes(doc, placement.transform);
+        const json& meshes = Array(doc, "meshes");
+        std::vector<int> use_count(meshes.size(), 0);
+        for (const MeshPlacement& p : placements) {
+            if (p.mesh < 0 || p.mesh >= static_cast<int>(meshes.size())) {
+                std::cerr << "[glTF] Node references missing mesh " << p.mesh << std::endl;
+                return false;
+            }
+            use_count[p.mesh]++;
+        }
+
+        // Meshes are converted once, on first use
+        std::vector<std::vector<Mesh>> converted(meshes.size());
+        std::vector<uint32_t> prototype_ids(meshes.size(), UINT32_MAX);
+        size_t primitives = 0, triangles = 0, flattened = 0, instances = 0;
+        for (const MeshPlacement& p : placements) {
+            if (use_count[p.mesh] == 0) continue;
+            if (p.to_world.Determinant() == 0.0f) {
+                std::cerr << "[glTF] Warning: skipping mesh " << p.mesh
+                          << " with a degenerate transform" << std::endl;
+                continue;
+            }
+            std::vector<Mesh>& prims = converted[p.mesh];
+            if (prims.empty() && prototype_ids[p.mesh] == UINT32_MAX) {
+                std::vector<int> gltf_materials;
+                if (!ConvertGltfMesh(meshes[p.mesh], file, &prims, &gltf_materials)) {
+                    std::cerr << "[glTF] Invalid or unsupported accessors in mesh " << p.mesh
+                              << std::endl;
+                    return false;
+                }
+                for (size_t i = 0; i < prims.size(); ++i) {
+                    prims[i].material_id = resolve_material(gltf_materials[i]);
+                    prims[i].object_id = placement.object_id;
+                    primitives++;
+                    triangles += prims[i].indices.size() / 3;
+                }
+            }
+
+            if (use_count[p.mesh] > 1) {
+                if (prototype_ids[p.mesh] == UINT32_MAX) {
+                    prototype_ids[p.mesh] = scene.AddPrototype(std::move(prims));
+                }
+                scene.AddInstance(prototype_ids[p.mesh], p.to_world, placement.object_id);
+                instances++;
+                continue;
+            }
+
+            // Used once: bake the transform into the vertices
+            const Affine3 normal_xform = p.to_world.Inverse();
+            for (Mesh& mesh : prims) {
+                for (Vec3& v : mesh.p) v = p.to_world.Point(v);
+                for (Vec3& n : mesh.n) n = Normalize(normal_xform.TransposedVector(n));
+                scene.AddMesh(std::move(mesh));
+                flattened++;
+            }
+            prims.clear();
+        }
+
+        std::clog << "[glTF] Loaded " << meshes.size() << " meshes (" << primitives
+                  << " primitives, " << triangles << " triangles), " << flattened
+                  << " placed meshes, " << instances << " instances, " << material_ids.size()
+                  << " materials" << std::endl;
+        return true;
+    } catch (const std::exception& e) {  // JSON syntax or type errors, bad escapes
+        std::cerr << "[glTF] Malformed file " << filename << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+
+}  // namespace skwr
@@ -0,0 +1,32 @@
+#ifndef SKWR_IO_GLTF_LOADER_H_
+#define SKWR_IO_GLTF_LOADER_H_
+
+// glTF 2.0 loader (.gltf with external or data-URI buffers, and binary .glb).
+// Accessors are copied straight from the binary buffers into Mesh arrays, PBR metallic-roughness
+// materials are mapped onto Material, and the node hierarchy is kept: a mesh referenced by
+// several nodes becomes one Scene prototype with an instance per node, while a mesh used once is
+// transformed into world space like any OBJ mesh.
+
+#include <cstdint>
+#include <string>
+
+#include "core/transform.h"
+#include "scene/scene.h"
+
+namespace skwr {
+
+// How a glTF file is placed in the scene
+struct GLTFPlacement {
+    Affine3 transform;                        // Applied on top of the file's node transforms
+    uint32_t object_id = 0;                   // Object id of everything the file adds
+    uint32_t material_override = UINT32_MAX;  // Scene material for every primitive, if set
+};
+
+// Load the file's default scene (or every mesh once, if it has no scenes) into the Scene.
+// Returns true on success.
+bool LoadGLTF(const std::string& filename, Scene& scene,
+              const GLTFPlacement& placement = GLTFPlacement{});
+
+}  // namespace skwr
+
+#endif  // SKWR_IO_GLTF_LOADER_H_
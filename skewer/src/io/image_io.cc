@@ -5,15 +5,26 @@
 #include <ImfDeepFrameBuffer.h>
 #include <ImfDeepScanLineInputFile.h>
 #include <ImfDeepScanLineOutputFile.h>
+#include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfIntAttribute.h>
 #include <ImfMultiPartInputFile.h>
+#include <ImfOutputFile.h>
 #include <ImfPartType.h>
 #include <ImfPixelType.h>
 #include <half.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "film/image_buffer.h"
 #include "stb_image.h"
@@ -45,6 +56,21 @@ static void insertDeepSlice(Imf::DeepFrameBuffer& fb, const char* name, void* pt
                              xStride, yStride, sampleStride));
 }
 
+// Header whose display window is the buffer's frame and data window the buffer's own pixels
+static Imf::Header MakeWindowHeader(int width, int height, const FrameWindow& window) {
+    Imath::Box2i dataWindow(Imath::V2i(window.x0, window.y0),
+                            Imath::V2i(window.x0 + width - 1, window.y0 + height - 1));
+    return Imf::Header(window.frame_width, window.frame_height, dataWindow);
+}
+
+// Inverse of MakeWindowHeader, relative to the display window's corner
+static FrameWindow ReadFrameWindow(const Imf::Header& header) {
+    const Imath::Box2i& display = header.displayWindow();
+    const Imath::Box2i& data = header.dataWindow();
+    return {display.max.x - display.min.x + 1, display.max.y - display.min.y + 1,
+            data.min.x - display.min.x, data.min.y - display.min.y};
+}
+
 // =============================================================================================
 // PPM / Flat Image I/O
 // =============================================================================================
@@ -68,6 +94,9 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
     // Check channels
     Imf::ChannelList channels = header.channels();
     const bool hasZBack = channels.findChannel("ZBack") != nullptr;
+    const bool hasObjectId = channels.findChannel("objectId") != nullptr;
+    const bool hasMaterialId = channels.findChannel("materialId") != nullptr;
+    const bool hasSampleCount = channels.findChannel("sampleCount") != nullptr;
 
     // Prepare all pointer arrays (even if we don't have data yet)
     auto sampleCounts = Imf::Array2D<unsigned int>(height, width);
@@ -77,6 +106,9 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
     Imf::Array2D<const float*> aPtrs(height, width);
     Imf::Array2D<const float*> zPtrs(height, width);
     Imf::Array2D<const float*> zBackPtrs(height, width);
+    Imf::Array2D<const uint32_t*> objectIdPtrs(height, width);
+    Imf::Array2D<const uint32_t*> materialIdPtrs(height, width);
+    Imf::Array2D<const uint32_t*> sampleCountPtrs(height, width);
 
     // Configure FrameBuffer with everything
     Imf::DeepFrameBuffer frameBuffer;
@@ -101,6 +133,18 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
         insertDeepSlice(frameBuffer, "ZBack", &zBackPtrs[0][0], Imf::FLOAT, minX, minY, width,
                         sampleStride);
     }
+    if (hasObjectId) {
+        insertDeepSlice(frameBuffer, "objectId", &objectIdPtrs[0][0], Imf::UINT, minX, minY,
+                        width, sampleStride);
+    }
+    if (hasMaterialId) {
+        insertDeepSlice(frameBuffer, "materialId", &materialIdPtrs[0][0], Imf::UINT, minX, minY,
+                        width, sampleStride);
+    }
+    if (hasSampleCount) {
+        insertDeepSlice(frameBuffer, "sampleCount", &sampleCountPtrs[0][0], Imf::UINT, minX,
+                        minY, width, sampleStride);
+    }
 
     file.setFrameBuffer(frameBuffer);
 
@@ -116,6 +160,7 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
     }
 
     DeepImageBuffer deepbuf(width, height, totalSamples, sampleCounts);
+    deepbuf.SetFrameWindow(ReadFrameWindow(header));
 
     // Now populate the pointers in our arrays
     for (int y = 0; y < height; ++y) {
@@ -137,6 +182,9 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
                 } else {
                     zBackPtrs[y][x] = nullptr;
                 }
+                objectIdPtrs[y][x] = &firstSample.object_id;
+                materialIdPtrs[y][x] = &firstSample.material_id;
+                sampleCountPtrs[y][x] = &firstSample.sample_count;
             } else {
                 rPtrs[y][x] = nullptr;
                 gPtrs[y][x] = nullptr;
@@ -144,6 +192,9 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
                 aPtrs[y][x] = nullptr;
                 zPtrs[y][x] = nullptr;
                 zBackPtrs[y][x] = nullptr;
+                objectIdPtrs[y][x] = nullptr;
+                materialIdPtrs[y][x] = nullptr;
+                sampleCountPtrs[y][x] = nullptr;
             }
         }
     }
@@ -151,32 +202,28 @@ DeepImageBuffer ImageIO::LoadEXR(const std::string& filename) {
     // Read Pixels (pointers in rPtrs etc. are now valid)
     file.readPixels(dataWindow.min.y, dataWindow.max.y);
 
-    // Handle missing ZBack channel manually
-    if (!hasZBack) {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                size_t start = deepbuf.pixelOffsets_[y * width + x];
-                size_t end = deepbuf.pixelOffsets_[y * width + x + 1];
-                size_t count = end - start;
-
-                for (size_t i = 0; i < count; ++i) {
-                    deepbuf.allSamples_[start + i].z_back = deepbuf.allSamples_[start + i].z_front;
-                }
-            }
-        }
+    // Handle missing ZBack and metadata channels manually
+    for (DeepSample& sample : deepbuf.allSamples_) {
+        if (!hasZBack) sample.z_back = sample.z_front;
+        if (!hasObjectId) sample.object_id = UINT32_MAX;
+        if (!hasMaterialId) sample.material_id = UINT32_MAX;
+        if (!hasSampleCount) sample.sample_count = 0;
     }
 
     return deepbuf;
 }
 
-void ImageIO::SaveEXR(const DeepImageBuffer& buf, const std::string& filename) {
-    const int width = buf.GetWidth();
-    const int height = buf.GetHeight();
+// A chunk's sample range, as skewer.sampleStart / sampleEnd / totalSamples int attributes
+static void SetSampleRange(Imf::Header& header, const SampleRange& range) {
+    header.insert("skewer.sampleStart", Imf::IntAttribute(range.start));
+    header.insert("skewer.sampleEnd", Imf::IntAttribute(range.end));
+    header.insert("skewer.totalSamples", Imf::IntAttribute(range.total));
+}
 
-    Imath::Box2i dataWindow(Imath::V2i(0, 0), Imath::V2i(width - 1, height - 1));
-    Imf::Header header(width, height, dataWindow);
-    int minX = dataWindow.min.x;
-    int minY = dataWindow.min.y;
+// Header shared by the one-shot and the streaming deep writers
+static Imf::Header MakeDeepHeader(int width, int height, const FrameWindow& window,
+                                  const SampleRange* range = nullptr) {
+    Imf::Header header = MakeWindowHeader(width, height, window);
 
     header.channels().insert("R", Imf::Channel(Imf::FLOAT));
     header.channels().insert("G", Imf::Channel(Imf::FLOAT));
@@ -184,10 +231,21 @@ void ImageIO::SaveEXR(const DeepImageBuffer& buf, const std::string& filename) {
     header.channels().insert("A", Imf::Channel(Imf::FLOAT));
     header.channels().insert("Z", Imf::Channel(Imf::FLOAT));
     header.channels().insert("ZBack", Imf::Channel(Imf::FLOAT));
+    header.channels().insert("objectId", Imf::Channel(Imf::UINT));
+    header.channels().insert("materialId", Imf::Channel(Imf::UINT));
+    header.channels().insert("sampleCount", Imf::Channel(Imf::UINT));
     header.setType(Imf::DEEPSCANLINE);
     header.compression() = Imf::ZIPS_COMPRESSION;
+    if (range) SetSampleRange(header, *range);
+    return header;
+}
 
-    Imf::DeepScanLineOutputFile file(filename.c_str(), header);
+// Writes buf's rows as the file's scanlines [minY, minY + buf height), starting at column minX.
+// Rows must reach the file in increasing y, continuing where the previous call stopped.
+static void WriteDeepRows(Imf::DeepScanLineOutputFile& file, const DeepImageBuffer& buf,
+                          int minX, int minY) {
+    const int width = buf.GetWidth();
+    const int height = buf.GetHeight();
 
     auto sampleCounts = Imf::Array2D<unsigned int>(height, width);
 
@@ -197,24 +255,29 @@ void ImageIO::SaveEXR(const DeepImageBuffer& buf, const std::string& filename) {
     Imf::Array2D<const float*> aPtrs(height, width);
     Imf::Array2D<const float*> zPtrs(height, width);
     Imf::Array2D<const float*> zBackPtrs(height, width);
+    Imf::Array2D<const uint32_t*> objectIdPtrs(height, width);
+    Imf::Array2D<const uint32_t*> materialIdPtrs(height, width);
+    Imf::Array2D<const uint32_t*> sampleCountPtrs(height, width);
 
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
             // Grab the address information of the sample at the start of the pixel
-            size_t start = buf.pixelOffsets_[y * width + x];
-            size_t end = buf.pixelOffsets_[y * width + x + 1];
+            DeepPixelView pixel = buf.GetPixel(x, y);
 
-            unsigned int count = static_cast<unsigned int>(end - start);
+            unsigned int count = static_cast<unsigned int>(pixel.count);
             sampleCounts[y][x] = count;
 
             if (count > 0) {
-                const DeepSample& firstSample = buf.allSamples_[start];
+                const DeepSample& firstSample = pixel[0];
                 rPtrs[y][x] = &firstSample.r;
                 gPtrs[y][x] = &firstSample.g;
                 bPtrs[y][x] = &firstSample.b;
                 aPtrs[y][x] = &firstSample.alpha;
                 zPtrs[y][x] = &firstSample.z_front;
                 zBackPtrs[y][x] = &firstSample.z_back;
+                objectIdPtrs[y][x] = &firstSample.object_id;
+                materialIdPtrs[y][x] = &firstSample.material_id;
+                sampleCountPtrs[y][x] = &firstSample.sample_count;
             } else {
                 rPtrs[y][x] = nullptr;
                 gPtrs[y][x] = nullptr;
@@ -222,6 +285,9 @@ void ImageIO::SaveEXR(const DeepImageBuffer& buf, const std::string& filename) {
                 aPtrs[y][x] = nullptr;
                 zPtrs[y][x] = nullptr;
                 zBackPtrs[y][x] = nullptr;
+                objectIdPtrs[y][x] = nullptr;
+                materialIdPtrs[y][x] = nullptr;
+                sampleCountPtrs[y][x] = nullptr;
             }
         }
     }
@@ -245,11 +311,232 @@ void ImageIO::SaveEXR(const DeepImageBuffer& buf, const std::string& filename) {
     insertDeepSlice(frameBuffer, "Z", &zPtrs[0][0], Imf::FLOAT, minX, minY, width, sampleStride);
     insertDeepSlice(frameBuffer, "ZBack", &zBackPtrs[0][0], Imf::FLOAT, minX, minY, width,
                     sampleStride);
+    insertDeepSlice(frameBuffer, "objectId", &objectIdPtrs[0][0], Imf::UINT, minX, minY, width,
+                    sampleStride);
+    insertDeepSlice(frameBuffer, "materialId", &materialIdPtrs[0][0], Imf::UINT, minX, minY,
+                    width, sampleStride);
+    insertDeepSlice(frameBuffer, "sampleCount", &sampleCountPtrs[0][0], Imf::UINT, minX, minY,
+                    width, sampleStride);
 
     file.setFrameBuffer(frameBuffer);
     file.writePixels(height);
+}
+
+void ImageIO::SaveEXR(const DeepImageBuffer& buf, const std::string& filename,
+                      const SampleRange* chunk_range) {
+    const FrameWindow& window = buf.GetFrameWindow();
+    Imf::DeepScanLineOutputFile file(
+        filename.c_str(), MakeDeepHeader(buf.GetWidth(), buf.GetHeight(), window, chunk_range));
+    WriteDeepRows(file, buf, window.x0, window.y0);
 
     std::clog << "Saved EXR: " << filename << std::endl;
 }
 
+// =============================================================================================
+// Streaming Deep Image Output (OpenEXR)
+// =============================================================================================
+
+struct DeepEXRBandWriter::State {
+    std::string filename;
+    FrameWindow window;
+    int band_height;
+    int band_count;
+    Imf::DeepScanLineOutputFile file;
+    std::vector<bool> submitted;
+    // Reorder buffer: finished bands waiting for the ones above them
+    std::map<int, std::unique_ptr<DeepImageBuffer>> pending;
+    int next_band = 0;
+
+    State(const std::string& name, int width, int height, int band_rows,
+          const SampleRange* range, const FrameWindow& frame_window)
+        : filename(name),
+          window(frame_window),
+          band_height(band_rows),
+          band_count((height + band_rows - 1) / band_rows),
+          file(name.c_str(), MakeDeepHeader(width, height, frame_window, range)),
+          submitted(band_count, false) {}
+};
+
+DeepEXRBandWriter::DeepEXRBandWriter(const std::string& filename, int width, int height,
+                                     int band_height, const SampleRange* chunk_range,
+                                     const FrameWindow* window)
+    : state_(std::make_unique<State>(filename, width, height, band_height, chunk_range,
+                                     window ? *window : FrameWindow{width, height, 0, 0})) {}
+
+DeepEXRBandWriter::~DeepEXRBandWriter() = default;
+
+int DeepEXRBandWriter::Submit(int band, std::unique_ptr<DeepImageBuffer> rows) {
+    State& st = *state_;
+    assert(band >= 0 && band < st.band_count && !st.submitted[band]);
+    st.submitted[band] = true;
+    st.pending.emplace(band, std::move(rows));
+
+    while (!st.pending.empty() && st.pending.begin()->first == st.next_band) {
+        WriteDeepRows(st.file, *st.pending.begin()->second, st.window.x0,
+                      st.window.y0 + st.next_band * st.band_height);
+        st.pending.erase(st.pending.begin());
+        st.next_band++;
+    }
+    if (st.next_band == st.band_count) std::clog << "Saved EXR: " << st.filename << std::endl;
+    return st.next_band;
+}
+
+bool DeepEXRBandWriter::HasBand(int band) const { return state_->submitted[band]; }
+
+int DeepEXRBandWriter::BandCount() const { return state_->band_count; }
+
+// =============================================================================================
+// Flat AOV Image I/O (OpenEXR)
+// =============================================================================================
+
+void ImageIO::SaveAOVEXR(const AOVImageBuffer& buf, const std::string& filename) {
+    const int width = buf.GetWidth();
+    const int height = buf.GetHeight();
+
+    struct ChannelDesc {
+        const char* name;
+        Imf::PixelType type;
+        size_t offset;
+    };
+    const ChannelDesc channels[] = {
+        {"R", Imf::FLOAT, offsetof(AOVImagePixel, r)},
+        {"G", Imf::FLOAT, offsetof(AOVImagePixel, g)},
+        {"B", Imf::FLOAT, offsetof(AOVImagePixel, b)},
+        {"albedo.R", Imf::FLOAT, offsetof(AOVImagePixel, albedo_r)},
+        {"albedo.G", Imf::FLOAT, offsetof(AOVImagePixel, albedo_g)},
+        {"albedo.B", Imf::FLOAT, offsetof(AOVImagePixel, albedo_b)},
+        {"N.X", Imf::FLOAT, offsetof(AOVImagePixel, n_x)},
+        {"N.Y", Imf::FLOAT, offsetof(AOVImagePixel, n_y)},
+        {"N.Z", Imf::FLOAT, offsetof(AOVImagePixel, n_z)},
+        {"Z", Imf::FLOAT, offsetof(AOVImagePixel, z)},
+        {"objectId", Imf::UINT, offsetof(AOVImagePixel, object_id)},
+        {"materialId", Imf::UINT, offsetof(AOVImagePixel, material_id)},
+    };
+
+    const FrameWindow& window = buf.GetFrameWindow();
+    Imf::Header header = MakeWindowHeader(width, height, window);
+    header.compression() = Imf::ZIP_COMPRESSION;
+
+    // One interleaved buffer; every channel is a strided view into it, based at the data window
+    size_t xStride = sizeof(AOVImagePixel);
+    size_t yStride = xStride * width;
+    const char* base = makeBasePointer(const_cast<AOVImagePixel*>(buf.pixels_.data()), window.x0,
+                                       window.y0, width, xStride, yStride);
+
+    Imf::FrameBuffer frameBuffer;
+    for (const ChannelDesc& c : channels) {
+        header.channels().insert(c.name, Imf::Channel(c.type));
+        frameBuffer.insert(c.name, Imf::Slice(c.type, const_cast<char*>(base + c.offset),
+                                              xStride, yStride));
+    }
+
+    Imf::OutputFile file(filename.c_str(), header);
+    file.setFrameBuffer(frameBuffer);
+    file.writePixels(height);
+
+    std::clog << "Saved AOV EXR: " << filename << std::endl;
+}
+
+// =============================================================================================
+// Chunk Accumulator I/O (OpenEXR)
+// =============================================================================================
+
+// A double split into two UINT channel words, so the sums survive the file bit for bit
+static constexpr int kChunkWords = 9;
+static const char* const kChunkChannels[kChunkWords] = {
+    "R.hi", "R.lo", "G.hi", "G.lo", "B.hi", "B.lo", "weight.hi", "weight.lo", "sampleCount",
+};
+
+static void SplitDouble(double d, uint32_t* words) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    words[0] = static_cast<uint32_t>(bits >> 32);
+    words[1] = static_cast<uint32_t>(bits);
+}
+
+static double JoinDouble(const uint32_t* words) {
+    const uint64_t bits = (uint64_t(words[0]) << 32) | words[1];
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// words holds the data window's pixels, minX, minY is its corner
+static Imf::FrameBuffer MakeChunkFrameBuffer(uint32_t* words, int minX, int minY, int width) {
+    const size_t xStride = sizeof(uint32_t) * kChunkWords;
+    const size_t yStride = xStride * width;
+    char* base = makeBasePointer(words, minX, minY, width, xStride, yStride);
+    Imf::FrameBuffer frameBuffer;
+    for (int c = 0; c < kChunkWords; ++c) {
+        frameBuffer.insert(kChunkChannels[c],
+                           Imf::Slice(Imf::UINT, base + c * sizeof(uint32_t), xStride, yStride));
+    }
+    return frameBuffer;
+}
+
+void ImageIO::SaveChunkEXR(const ChunkImageBuffer& buf, const std::string& filename) {
+    const int width = buf.GetWidth();
+    const int height = buf.GetHeight();
+
+    std::vector<uint32_t> words(static_cast<size_t>(width) * height * kChunkWords);
+    for (size_t i = 0; i < buf.pixels_.size(); ++i) {
+        const ChunkImagePixel& p = buf.pixels_[i];
+        uint32_t* w = words.data() + i * kChunkWords;
+        SplitDouble(p.r, w + 0);
+        SplitDouble(p.g, w + 2);
+        SplitDouble(p.b, w + 4);
+        SplitDouble(p.weight, w + 6);
+        w[8] = p.sample_count;
+    }
+
+    const FrameWindow& window = buf.GetFrameWindow();
+    Imf::Header header = MakeWindowHeader(width, height, window);
+    header.compression() = Imf::ZIP_COMPRESSION;
+    for (const char* name : kChunkChannels) header.channels().insert(name, Imf::Channel(Imf::UINT));
+    SetSampleRange(header, buf.GetRange());
+
+    Imf::OutputFile file(filename.c_str(), header);
+    file.setFrameBuffer(MakeChunkFrameBuffer(words.data(), window.x0, window.y0, width));
+    file.writePixels(height);
+
+    std::clog << "Saved chunk EXR: " << filename << std::endl;
+}
+
+ChunkImageBuffer ImageIO::LoadChunkEXR(const std::string& filename) {
+    Imf::InputFile file(filename.c_str());
+    const Imf::Header& header = file.header();
+
+    for (const char* name : kChunkChannels) {
+        if (!header.channels().findChannel(name)) {
+            throw std::runtime_error(filename + " is not a chunk EXR (no " + name + " channel)");
+        }
+    }
+    SampleRange range;
+    int* fields[] = {&range.start, &range.end, &range.total};
+    const char* names[] = {"skewer.sampleStart", "skewer.sampleEnd", "skewer.totalSamples"};
+    for (int i = 0; i < 3; ++i) {
+        const auto* attr = header.findTypedAttribute<Imf::IntAttribute>(names[i]);
+        if (!attr) throw std::runtime_error(filename + " has no " + names[i] + " attribute");
+        *fields[i] = attr->value();
+    }
+
+    const Imath::Box2i dataWindow = header.dataWindow();
+    const int width = dataWindow.max.x - dataWindow.min.x + 1;
+    const int height = dataWindow.max.y - dataWindow.min.y + 1;
+
+    std::vector<uint32_t> words(static_cast<size_t>(width) * height * kChunkWords);
+    file.setFrameBuffer(
+        MakeChunkFrameBuffer(words.data(), dataWindow.min.x, dataWindow.min.y, width));
+    file.readPixels(dataWindow.min.y, dataWindow.max.y);
+
+    ChunkImageBuffer buf(width, height, range);
+    buf.SetFrameWindow(ReadFrameWindow(header));
+    for (size_t i = 0; i < buf.pixels_.size(); ++i) {
+        const uint32_t* w = words.data() + i * kChunkWords;
+        buf.pixels_[i] = {JoinDouble(w + 0), JoinDouble(w + 2), JoinDouble(w + 4),
+                          JoinDouble(w + 6), w[8]};
+    }
+    return buf;
+}
+
 }  // namespace skwr
@@ -1,23 +1,67 @@
 #ifndef IMAGE_IO_H
 #define IMAGE_IO_H
 
+#include <memory>
 #include <string>
 
 #include "film/image_buffer.h"
 
 namespace skwr {
 
+// EXRs are written with each buffer's FrameWindow as data window inside the display window, and
+// loaded buffers get the window of their file
 class ImageIO {
   public:
     static void SavePPM(const FlatImageBuffer& buf, const std::string& filename);
 
-    static void SaveEXR(const DeepImageBuffer& buf, const std::string& filename);
+    // Deep scanline EXR: R, G, B, A, Z, ZBack, and the per-sample objectId, materialId and
+    // sampleCount (camera samples merged into the sample) as UINT channels. With a chunk_range
+    // the header also records the sample range, as SaveChunkEXR does.
+    static void SaveEXR(const DeepImageBuffer& buf, const std::string& filename,
+                        const SampleRange* chunk_range = nullptr);
+
+    // Flat scanline EXR: R, G, B, albedo.{R,G,B}, N.{X,Y,Z}, Z, objectId, materialId
+    static void SaveAOVEXR(const AOVImageBuffer& buf, const std::string& filename);
+
+    // Flat scanline EXR of a chunk's accumulators. The double sums are stored bit-exact as
+    // R/G/B/weight .hi and .lo UINT channels (high and low 32 bits) next to a sampleCount UINT
+    // channel; the sample range goes in the skewer.sampleStart, skewer.sampleEnd and
+    // skewer.totalSamples int attributes.
+    static void SaveChunkEXR(const ChunkImageBuffer& buf, const std::string& filename);
+    // Throws std::runtime_error if the file lacks the chunk channels or attributes
+    static ChunkImageBuffer LoadChunkEXR(const std::string& filename);
 
     static FlatImageBuffer LoadPPM(const std::string& filename);
 
+    // Files without the metadata channels load with kNoHitId ids and a zero sampleCount
     static DeepImageBuffer LoadEXR(const std::string& filename);
 };
 
+// Deep scanline EXR written band by band while the frame is still rendering. Bands may be
+// submitted in any order, but scanlines reach the file top to bottom, so a band is held until
+// every band above it has been written. Not thread-safe: callers serialise Submit.
+class DeepEXRBandWriter {
+  public:
+    // Band b covers rows [b * band_height, (b + 1) * band_height), clipped to the image. A
+    // chunk_range is recorded in the header as ImageIO::SaveEXR does; a window places the
+    // width x height image inside a larger frame (default: it is the whole frame).
+    DeepEXRBandWriter(const std::string& filename, int width, int height, int band_height,
+                      const SampleRange* chunk_range = nullptr,
+                      const FrameWindow* window = nullptr);
+    ~DeepEXRBandWriter();
+
+    // Takes a band's rows (a buffer band_height tall, or less for the last band). Returns how
+    // many leading bands are now in the file.
+    int Submit(int band, std::unique_ptr<DeepImageBuffer> rows);
+
+    bool HasBand(int band) const;
+    int BandCount() const;
+
+  private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
 }  // namespace skwr
 
 #endif
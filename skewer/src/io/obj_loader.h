@@ -5,15 +5,17 @@
 // Loads .obj files via tinyobjloader, converts materials to v2 Material structs,
 // and populates a Scene with Mesh geometry.
 
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "core/vec3.h"
+#include "geometry/mesh.h"
 #include "materials/material.h"
 #include "scene/scene.h"
-
-namespace tinyobj {
-struct material_t;
-}  // namespace tinyobj
+#include "tiny_obj_loader.h"
 
 namespace skwr {
 
@@ -29,9 +31,35 @@ Material ConvertObjMaterial(const tinyobj::material_t& mtl);
 // scale: per-axis scale applied to vertex positions (e.g. Vec3(1,1,1) = no scaling).
 // auto_fit: when true, normalizes the model to a 2-unit cube centered at origin before applying
 // scale. Returns true on success.
+//
+// Loading is split in two so several files can be parsed at once: ParseOBJ reads and converts the
+// geometry without touching a Scene (safe to run concurrently), and AddParsedOBJ then adds the
+// materials and meshes in file order.
 bool LoadOBJ(const std::string& filename, Scene& scene, const Vec3& scale = Vec3(1.0f, 1.0f, 1.0f),
              bool auto_fit = true);
 
+// Geometry of one OBJ file, ready to be added to a Scene
+struct ParsedOBJ {
+    bool ok = false;
+    std::string base_path;  // Directory that MTL texture names are relative to
+    std::vector<tinyobj::material_t> materials;
+    std::vector<Mesh> meshes;         // material_id is set by AddParsedOBJ
+    std::vector<int> mesh_materials;  // OBJ material index per mesh, -1 for none
+    size_t shape_count = 0;
+    uint32_t total_triangles = 0;
+    std::ostringstream log;     // Progress messages, printed by AddParsedOBJ
+    std::ostringstream errors;  // Warnings and errors, printed by AddParsedOBJ
+};
+
+// Reads and triangulates an OBJ file, converting its shapes on up to num_threads threads
+// (0 = all hardware threads). Does not print; messages are buffered for AddParsedOBJ.
+ParsedOBJ ParseOBJ(const std::string& filename, const Vec3& scale, bool auto_fit,
+                   int num_threads = 0);
+
+// Adds a parsed file's materials (queueing their textures) and meshes to the Scene.
+// Returns obj.ok.
+bool AddParsedOBJ(ParsedOBJ&& obj, Scene& scene);
+
 }  // namespace skwr
 
 #endif  // SKWR_IO_OBJ_LOADER_H_
@@ -1,22 +1,29 @@
 #include "io/scene_loader.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "core/parallel.h"
 #include "core/spectral/spectral_curve.h"
 #include "core/spectral/spectral_utils.h"
 #include "core/transform.h"
 #include "core/vec3.h"
 #include "geometry/sphere.h"
+#include "io/asset_bundle.h"
+#include "io/gltf_loader.h"
 #include "io/obj_loader.h"
 #include "materials/material.h"
 #include "materials/texture.h"
+#include "scene/animation.h"
 #include "scene/mesh_utils.h"
 #include "scene/scene.h"
 #include "session/render_options.h"
@@ -75,7 +82,8 @@ using MaterialMap = std::map<std::string, uint32_t>;
 // Resolves relative paths against scene_dir.
 // Returns kNoTexture if the string is empty or load fails.
 static uint32_t LoadSceneTexture(const json& m, const std::string& key,
-                                 const std::string& scene_dir, Scene& scene) {
+                                 const std::string& scene_dir, Scene& scene,
+                                 TextureUsage usage = TextureUsage::Color) {
     if (!m.contains(key)) return kNoTexture;
 
     std::string texpath = m[key].get<std::string>();
@@ -88,10 +96,7 @@ static uint32_t LoadSceneTexture(const json& m, const std::string& key,
         filepath = scene_dir.empty() ? texpath : (scene_dir + "/" + texpath);
     }
 
-    ImageTexture tex;
-    if (!tex.Load(filepath)) return kNoTexture;
-
-    return scene.AddTexture(std::move(tex));
+    return scene.LoadTexture(filepath, usage);
 }
 
 static MaterialMap ParseMaterials(const json& j, Scene& scene, const std::string& scene_dir) {
@@ -112,13 +117,16 @@ static MaterialMap ParseMaterials(const json& j, Scene& scene, const std::string
         if (type == "lambertian") {
             mat.type = MaterialType::Lambertian;
             mat.albedo = RGBToCurve(GetRGBOr(m, "albedo", RGB(1.0f)));
+            mat.albedo_rgb = ToLinear(GetRGBOr(m, "albedo", RGB(1.0f)));
         } else if (type == "metal") {
             mat.type = MaterialType::Metal;
             mat.albedo = RGBToCurve(GetRGBOr(m, "albedo", RGB(1.0f)));
+            mat.albedo_rgb = ToLinear(GetRGBOr(m, "albedo", RGB(1.0f)));
             mat.roughness = GetOr(m, "roughness", 0.0f);
         } else if (type == "dielectric") {
             mat.type = MaterialType::Dielectric;
             mat.albedo = RGBToCurve(GetRGBOr(m, "albedo", RGB(1.0f)));
+            mat.albedo_rgb = ToLinear(GetRGBOr(m, "albedo", RGB(1.0f)));
             mat.ior = m.at("ior").get<float>();
             mat.roughness = GetOr(m, "roughness", 0.0f);
         } else {
@@ -131,9 +139,12 @@ static MaterialMap ParseMaterials(const json& j, Scene& scene, const std::string
         mat.opacity = RGBToCurve(GetRGBOr(m, "opacity", RGB(1.0f)));
 
         // Optional texture maps (paths resolved relative to scene file directory)
-        mat.albedo_tex = LoadSceneTexture(m, "albedo_texture", scene_dir, scene);
-        mat.normal_tex = LoadSceneTexture(m, "normal_texture", scene_dir, scene);
+        mat.albedo_tex =
+            LoadSceneTexture(m, "albedo_texture", scene_dir, scene, TextureUsage::Albedo);
+        mat.normal_tex =
+            LoadSceneTexture(m, "normal_texture", scene_dir, scene, TextureUsage::Normal);
         mat.roughness_tex = LoadSceneTexture(m, "roughness_texture", scene_dir, scene);
+        mat.deep = GetOr(m, "deep", true);
 
         uint32_t id = scene.AddMaterial(mat);
         mat_map[name] = id;
@@ -169,7 +180,7 @@ static void ParseSphere(const json& obj, const MaterialMap& mat_map, Scene& scen
     Vec3 center = ParseVec3(obj.at("center"));
     float radius = obj.at("radius").get<float>();
 
-    scene.AddSphere(Sphere{center, radius, mat_id});
+    scene.AddSphere(Sphere{center, radius, mat_id, static_cast<uint32_t>(index)});
     std::clog << "[Scene] Sphere at (" << center << "), r=" << radius << std::endl;
 }
 
@@ -187,7 +198,9 @@ static void ParseQuad(const json& obj, const MaterialMap& mat_map, Scene& scene,
     Vec3 p2 = ParseVec3(verts[2]);
     Vec3 p3 = ParseVec3(verts[3]);
 
-    scene.AddMesh(CreateQuad(p0, p1, p2, p3, mat_id));
+    Mesh quad = CreateQuad(p0, p1, p2, p3, mat_id);
+    quad.object_id = static_cast<uint32_t>(index);
+    scene.AddMesh(std::move(quad));
 
     std::string comment = GetOr<std::string>(obj, "comment", "");
     if (!comment.empty()) {
@@ -197,18 +210,17 @@ static void ParseQuad(const json& obj, const MaterialMap& mat_map, Scene& scene,
     }
 }
 
-static void ParseObj(const json& obj, const MaterialMap& mat_map, Scene& scene, int index,
-                     const std::string& scene_dir) {
+// Resolve an object's "file" relative to the scene file directory
+static std::string ResolveObjectPath(const json& obj, const std::string& scene_dir) {
     std::string file = obj.at("file").get<std::string>();
-
-    // Resolve path relative to scene file directory
-    std::string filepath;
     if (!file.empty() && file[0] == '/') {
-        filepath = file;  // Absolute path
-    } else {
-        filepath = scene_dir.empty() ? file : (scene_dir + "/" + file);
+        return file;  // Absolute path
     }
+    return scene_dir.empty() ? file : (scene_dir + "/" + file);
+}
 
+static void ParseObj(const json& obj, const MaterialMap& mat_map, Scene& scene, int index,
+                     const std::string& filepath, ParsedOBJ&& parsed) {
     bool auto_fit = GetOr(obj, "auto_fit", true);
 
     // Parse transform
@@ -235,13 +247,18 @@ static void ParseObj(const json& obj, const MaterialMap& mat_map, Scene& scene,
     // Record mesh count before loading so we can apply transforms to new meshes
     size_t mesh_count_before = scene.MeshCount();
 
-    // Load OBJ — when auto_fit is true, the loader normalizes to 2-unit cube.
-    // We pass Vec3(1,1,1) as scale here because we handle scaling ourselves via ApplyTransform.
-    if (!LoadOBJ(filepath, scene, Vec3(1.0f, 1.0f, 1.0f), auto_fit)) {
+    // Bundles carry converted meshes and materials already; auto_fit was applied when converting
+    const bool loaded = IsBundlePath(filepath) ? LoadBundle(filepath, scene)
+                                               : AddParsedOBJ(std::move(parsed), scene);
+    if (!loaded) {
         throw std::runtime_error("Object at index " + std::to_string(index) +
                                  ": failed to load OBJ file '" + filepath + "'");
     }
 
+    for (size_t i = mesh_count_before; i < scene.MeshCount(); i++) {
+        scene.GetMutableMesh(static_cast<uint32_t>(i)).object_id = static_cast<uint32_t>(index);
+    }
+
     // Override material if specified
     if (obj.contains("material") && !obj["material"].is_null()) {
         uint32_t mat_id = LookupMaterial(obj, mat_map, index);
@@ -269,6 +286,43 @@ static void ParseObj(const json& obj, const MaterialMap& mat_map, Scene& scene,
     std::clog << "[Scene] OBJ: " << filepath << " (auto_fit=" << auto_fit << ")" << std::endl;
 }
 
+static void ParseGltf(const json& obj, const MaterialMap& mat_map, Scene& scene, int index,
+                      const std::string& scene_dir) {
+    const std::string filepath = ResolveObjectPath(obj, scene_dir);
+
+    // Same transform keys as "obj"; applied on top of the file's own node transforms
+    Vec3 translate(0.0f, 0.0f, 0.0f);
+    Vec3 rotate_deg(0.0f, 0.0f, 0.0f);
+    Vec3 obj_scale(1.0f, 1.0f, 1.0f);
+    if (obj.contains("transform")) {
+        const auto& t = obj["transform"];
+        translate = GetVec3Or(t, "translate", Vec3(0.0f, 0.0f, 0.0f));
+        rotate_deg = GetVec3Or(t, "rotate", Vec3(0.0f, 0.0f, 0.0f));
+        if (t.contains("scale")) {
+            if (t["scale"].is_number()) {
+                float s = t["scale"].get<float>();
+                obj_scale = Vec3(s, s, s);
+            } else {
+                obj_scale = ParseVec3(t["scale"]);
+            }
+        }
+    }
+
+    GLTFPlacement placement;
+    placement.transform = Affine3::FromSRT(translate, rotate_deg, obj_scale);
+    placement.object_id = static_cast<uint32_t>(index);
+    if (obj.contains("material") && !obj["material"].is_null()) {
+        placement.material_override = LookupMaterial(obj, mat_map, index);
+    }
+
+    if (!LoadGLTF(filepath, scene, placement)) {
+        throw std::runtime_error("Object at index " + std::to_string(index) +
+                                 ": failed to load glTF file '" + filepath + "'");
+    }
+
+    std::clog << "[Scene] glTF: " << filepath << std::endl;
+}
+
 static void ParseObjects(const json& j, const MaterialMap& mat_map, Scene& scene,
                          const std::string& scene_dir) {
     if (!j.contains("objects")) {
@@ -276,6 +330,33 @@ static void ParseObjects(const json& j, const MaterialMap& mat_map, Scene& scene
     }
 
     const auto& objects = j["objects"];
+
+    // OBJ files are read and converted in parallel up front; everything is then added to the
+    // scene in file order, so material, mesh and texture ids match a serial load
+    std::vector<int> obj_indices;
+    for (int i = 0; i < static_cast<int>(objects.size()); i++) {
+        if (objects[i].at("type").get<std::string>() == "obj") obj_indices.push_back(i);
+    }
+    std::vector<std::string> obj_paths;
+    std::vector<char> obj_auto_fit;
+    for (int i : obj_indices) {
+        obj_paths.push_back(ResolveObjectPath(objects[i], scene_dir));
+        obj_auto_fit.push_back(GetOr(objects[i], "auto_fit", true));
+    }
+
+    // When auto_fit is true, the loader normalizes to 2-unit cube. We pass Vec3(1,1,1) as scale
+    // here because we handle scaling ourselves via ApplyTransform.
+    const int file_count = static_cast<int>(obj_indices.size());
+    const int threads = ResolveThreadCount(scene.LoadThreads());
+    const int threads_per_file = std::max(1, threads / std::max(1, file_count));
+    std::vector<ParsedOBJ> parsed(file_count);
+    ParallelFor(file_count, threads, [&](int f) {
+        if (IsBundlePath(obj_paths[f])) return;  // Mapped, not parsed
+        parsed[f] = ParseOBJ(obj_paths[f], Vec3(1.0f, 1.0f, 1.0f), obj_auto_fit[f] != 0,
+                             threads_per_file);
+    });
+
+    int next_obj = 0;
     for (int i = 0; i < static_cast<int>(objects.size()); i++) {
         const auto& obj = objects[i];
         std::string type = obj.at("type").get<std::string>();
@@ -285,11 +366,18 @@ static void ParseObjects(const json& j, const MaterialMap& mat_map, Scene& scene
         } else if (type == "quad") {
             ParseQuad(obj, mat_map, scene, i);
         } else if (type == "obj") {
-            ParseObj(obj, mat_map, scene, i, scene_dir);
+            ParseObj(obj, mat_map, scene, i, obj_paths[next_obj],
+                     std::move(parsed[next_obj]));
+            next_obj++;
+        } else if (type == "gltf") {
+            ParseGltf(obj, mat_map, scene, i, scene_dir);
         } else {
             throw std::runtime_error("Object at index " + std::to_string(i) + ": unknown type '" +
                                      type + "'");
         }
+
+        // Object ids are object indices for every type
+        if (!GetOr(obj, "deep", true)) scene.SetObjectDeep(static_cast<uint32_t>(i), false);
     }
 }
 
@@ -301,16 +389,43 @@ static SceneConfig ParseConfig(const json& j) {
     SceneConfig config{};
 
     // --- Camera ---
-    if (!j.contains("camera")) {
+    if (!j.contains("camera") && !j.contains("cameras")) {
         throw std::runtime_error("Scene file missing 'camera' section");
     }
+    if (j.contains("cameras") && (!j["cameras"].is_array() || j["cameras"].empty())) {
+        throw std::runtime_error("cameras must be a non-empty list");
+    }
 
-    const auto& cam = j["camera"];
+    // Without "camera", the first view is also the still camera
+    const auto& cam = j.contains("camera") ? j["camera"] : j["cameras"][0];
     config.look_from = ParseVec3(cam.at("look_from"));
     config.look_at = ParseVec3(cam.at("look_at"));
     config.vup = GetVec3Or(cam, "vup", Vec3(0.0f, 1.0f, 0.0f));
     config.vfov = GetOr(cam, "vfov", 90.0f);
 
+    // --- Views: each field defaults to the still camera's, outputs to names derived from it ---
+    if (j.contains("cameras")) {
+        const auto& cameras = j["cameras"];
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            const auto& c = cameras[i];
+            ViewConfig view;
+            view.name = GetOr<std::string>(c, "name", "cam" + std::to_string(i));
+            for (const ViewConfig& other : config.views) {
+                if (other.name == view.name) {
+                    throw std::runtime_error("Duplicate camera name: " + view.name);
+                }
+            }
+            view.look_from = GetVec3Or(c, "look_from", config.look_from);
+            view.look_at = GetVec3Or(c, "look_at", config.look_at);
+            view.vup = GetVec3Or(c, "vup", config.vup);
+            view.vfov = GetOr(c, "vfov", config.vfov);
+            view.outfile = GetOr<std::string>(c, "outfile", "");
+            view.exrfile = GetOr<std::string>(c, "exrfile", "");
+            view.aovfile = GetOr<std::string>(c, "aovfile", "");
+            config.views.push_back(view);
+        }
+    }
+
     // --- Render ---
     auto& opts = config.render_options;
 
@@ -321,10 +436,13 @@ static SceneConfig ParseConfig(const json& j) {
     opts.integrator_config.max_depth = 50;
     opts.integrator_config.num_threads = 0;
     opts.integrator_config.enable_deep = false;
+    opts.integrator_config.enable_aovs = false;
+    opts.integrator_config.sort_shading = false;
     opts.image_config.width = 800;
     opts.image_config.height = 450;
     opts.image_config.outfile = "output.ppm";
     opts.image_config.exrfile = "output.exr";
+    opts.image_config.aovfile = "output_aovs.exr";
 
     if (j.contains("render")) {
         const auto& r = j["render"];
@@ -343,6 +461,39 @@ static SceneConfig ParseConfig(const json& j) {
         opts.integrator_config.max_depth = GetOr(r, "max_depth", 50);
         opts.integrator_config.num_threads = GetOr(r, "threads", 0);
         opts.integrator_config.enable_deep = GetOr(r, "enable_deep", false);
+        opts.integrator_config.enable_aovs = GetOr(r, "enable_aovs", false);
+        opts.integrator_config.sort_shading = GetOr(r, "sort_shading", false);
+        opts.deep_memory_mb = GetOr(r, "deep_memory_mb", 0);
+        if (opts.deep_memory_mb < 0) {
+            throw std::runtime_error("deep_memory_mb must be non-negative");
+        }
+        opts.stream_deep = GetOr(r, "stream_deep", false);
+        opts.integrator_config.deep_min_depth = GetOr(r, "deep_min_depth", 0.0f);
+        opts.integrator_config.deep_max_depth = GetOr(r, "deep_max_depth", kInfinity);
+        if (opts.integrator_config.deep_min_depth > opts.integrator_config.deep_max_depth) {
+            throw std::runtime_error("deep_min_depth must not exceed deep_max_depth");
+        }
+        std::string excluded_str = GetOr<std::string>(r, "deep_excluded", "flatten");
+        if (excluded_str == "flatten") {
+            opts.integrator_config.deep_flatten_excluded = true;
+        } else if (excluded_str == "omit") {
+            opts.integrator_config.deep_flatten_excluded = false;
+        } else {
+            throw std::runtime_error("Unknown deep_excluded mode: " + excluded_str);
+        }
+
+        std::string denoise_str = GetOr<std::string>(r, "denoise", "off");
+        if (denoise_str == "off") {
+            opts.denoise = DenoiseStrength::Off;
+        } else if (denoise_str == "low") {
+            opts.denoise = DenoiseStrength::Low;
+        } else if (denoise_str == "medium") {
+            opts.denoise = DenoiseStrength::Medium;
+        } else if (denoise_str == "high") {
+            opts.denoise = DenoiseStrength::High;
+        } else {
+            throw std::runtime_error("Unknown denoise strength: " + denoise_str);
+        }
 
         // Image config (nested)
         if (r.contains("image")) {
@@ -351,17 +502,89 @@ static SceneConfig ParseConfig(const json& j) {
             opts.image_config.height = GetOr(img, "height", 450);
             opts.image_config.outfile = GetOr<std::string>(img, "outfile", "output.ppm");
             opts.image_config.exrfile = GetOr<std::string>(img, "exrfile", "output.exr");
+            opts.image_config.aovfile = GetOr<std::string>(img, "aovfile", "output_aovs.exr");
+            if (img.contains("crop")) {
+                const auto& c = img["crop"];
+                if (!c.is_array() || c.size() != 4) {
+                    throw std::runtime_error("crop must be [x0, y0, x1, y1]");
+                }
+                opts.image_config.crop = {c[0].get<int>(), c[1].get<int>(), c[2].get<int>(),
+                                          c[3].get<int>()};
+            }
         }
     }
 
     return config;
 }
 
+//------------------------------------------------------------------------------
+// Animation Parsing
+//------------------------------------------------------------------------------
+
+// "animation": {"frame_start": 1, "frame_count": 48,
+//               "camera": [{"frame": 1, "look_from": [...], "look_at": [...], "vfov": 40}, ...],
+//               "objects": [{"object": 2, "keys": [{"frame": 1, "translate": [...],
+//                                                   "rotate": [...], "scale": 1}, ...]}]}
+// Camera keys default to the still camera; motion keys to no motion.
+static void ParseAnimation(const json& j, SceneConfig& config) {
+    if (!j.contains("animation")) return;
+
+    const auto& a = j["animation"];
+    AnimationConfig& anim = config.animation;
+    anim.frame_start = GetOr(a, "frame_start", 0);
+    anim.frame_count = GetOr(a, "frame_count", 0);
+    if (anim.frame_count < 1) {
+        throw std::runtime_error("animation.frame_count must be at least 1");
+    }
+
+    auto by_frame = [](const auto& x, const auto& y) { return x.frame < y.frame; };
+    if (a.contains("camera") && !config.views.empty()) {
+        throw std::runtime_error("animation.camera cannot be combined with cameras");
+    }
+    if (a.contains("camera")) {
+        for (const auto& k : a["camera"]) {
+            CameraKey key;
+            key.frame = k.at("frame").get<int>();
+            key.look_from = GetVec3Or(k, "look_from", config.look_from);
+            key.look_at = GetVec3Or(k, "look_at", config.look_at);
+            key.vfov = GetOr(k, "vfov", config.vfov);
+            anim.camera.push_back(key);
+        }
+        std::stable_sort(anim.camera.begin(), anim.camera.end(), by_frame);
+    }
+
+    if (a.contains("objects")) {
+        const size_t object_count = j.contains("objects") ? j["objects"].size() : 0;
+        for (const auto& o : a["objects"]) {
+            const int object = o.at("object").get<int>();
+            if (object < 0 || static_cast<size_t>(object) >= object_count) {
+                throw std::runtime_error("animation: no object at index " +
+                                         std::to_string(object));
+            }
+            std::vector<MotionKey>& keys = anim.objects[static_cast<uint32_t>(object)];
+            for (const auto& k : o.at("keys")) {
+                MotionKey key;
+                key.frame = k.at("frame").get<int>();
+                key.translate = GetVec3Or(k, "translate", key.translate);
+                key.rotate = GetVec3Or(k, "rotate", key.rotate);
+                if (k.contains("scale") && k["scale"].is_number()) {
+                    const float scale = k["scale"].get<float>();
+                    key.scale = Vec3(scale, scale, scale);
+                } else {
+                    key.scale = GetVec3Or(k, "scale", key.scale);
+                }
+                keys.push_back(key);
+            }
+            std::stable_sort(keys.begin(), keys.end(), by_frame);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 // Main Entry Point
 //------------------------------------------------------------------------------
 
-SceneConfig LoadSceneFile(const std::string& filepath, Scene& scene) {
+SceneConfig LoadSceneFile(const std::string& filepath, Scene& scene, int thread_override) {
     std::clog << "[Scene] Loading scene file: " << filepath << std::endl;
 
     // Open and parse JSON
@@ -385,17 +608,47 @@ SceneConfig LoadSceneFile(const std::string& filepath, Scene& scene) {
         scene_dir = filepath.substr(0, last_slash);
     }
 
-    // 1. Parse materials first (objects reference them by name)
+    // 1. Loader threads and texture storage options; they apply as soon as materials start
+    // loading textures
+    int load_threads = thread_override;
+    if (load_threads <= 0 && j.contains("render")) load_threads = GetOr(j["render"], "threads", 0);
+    scene.SetLoadThreads(load_threads);
+    if (j.contains("render")) {
+        int budget_mb = GetOr(j["render"], "texture_cache_mb", 0);
+        if (budget_mb < 0) {
+            throw std::runtime_error("texture_cache_mb must be non-negative");
+        }
+        scene.SetTextureCacheBudget(static_cast<size_t>(budget_mb) << 20);
+        scene.SetSpectralAlbedoTextures(GetOr(j["render"], "spectral_textures", false));
+    }
+
+    // 2. Parse materials (objects reference them by name)
     MaterialMap mat_map = ParseMaterials(j, scene, scene_dir);
 
-    // 2. Parse objects (geometry)
+    // 3. Parse objects (geometry)
     ParseObjects(j, mat_map, scene, scene_dir);
 
-    // 3. Parse camera and render config
+    // 4. Parse camera and render config
     SceneConfig config = ParseConfig(j);
 
+    // 5. Animated objects move as instances, so frames only rebuild the top-level BVH
+    ParseAnimation(j, config);
+    for (const auto& [object_id, keys] : config.animation.objects) {
+        scene.MakeObjectMovable(object_id);
+    }
+
     std::clog << "[Scene] Scene loaded successfully" << std::endl;
     return config;
 }
 
+std::shared_ptr<const PreparedScene> PrepareSceneFile(const std::string& filepath,
+                                                      int thread_override) {
+    auto scene = std::make_shared<Scene>();
+    auto prepared = std::make_shared<PreparedScene>();
+    prepared->config = LoadSceneFile(filepath, *scene, thread_override);
+    scene->Build();
+    prepared->scene = std::move(scene);
+    return prepared;
+}
+
 }  // namespace skwr
@@ -7,9 +7,12 @@
 // and returns camera/render configuration.
 //==============================================================================================
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "core/vec3.h"
+#include "scene/animation.h"
 #include "session/render_options.h"
 
 namespace skwr {
@@ -17,6 +20,19 @@ namespace skwr {
 // Forward declarations
 class Scene;
 
+// One of several cameras rendering the same scene ("cameras" in the scene file). Empty output
+// paths derive from the image config's with the name before the extension (see ViewPath).
+struct ViewConfig {
+    std::string name;
+    Vec3 look_from;
+    Vec3 look_at;
+    Vec3 vup = Vec3(0.0f, 1.0f, 0.0f);
+    float vfov = 90.0f;
+    std::string outfile;
+    std::string exrfile;
+    std::string aovfile;
+};
+
 // Result of loading a scene file — camera and render parameters
 // that the RenderSession uses to configure itself.
 struct SceneConfig {
@@ -27,13 +43,30 @@ struct SceneConfig {
     Vec3 look_at;
     Vec3 vup = Vec3(0.0f, 1.0f, 0.0f);
     float vfov = 90.0f;
+
+    // Views to render instead of the single camera above, which is then the first view's
+    std::vector<ViewConfig> views;
+
+    // Frame sequence ("animation"); its animated objects are made movable in the Scene
+    AnimationConfig animation;
 };
 
 // Load a JSON scene file. Populates the Scene with geometry and materials,
 // and returns a SceneConfig with camera and render parameters.
 // The Scene's BVH is NOT built — caller must call scene.Build() after.
-// Throws std::runtime_error on parse failure.
-SceneConfig LoadSceneFile(const std::string& filepath, Scene& scene);
+// Loading (OBJ parsing, texture decoding) uses thread_override threads if positive, else the
+// file's render.threads. Throws std::runtime_error on parse failure.
+SceneConfig LoadSceneFile(const std::string& filepath, Scene& scene, int thread_override = 0);
+
+// A scene loaded and built once, then only read, so any number of renders can share it
+struct PreparedScene {
+    std::shared_ptr<const Scene> scene;  // BVH already built
+    SceneConfig config;
+};
+
+// LoadSceneFile followed by Scene::Build. Throws std::runtime_error like LoadSceneFile.
+std::shared_ptr<const PreparedScene> PrepareSceneFile(const std::string& filepath,
+                                                      int thread_override = 0);
 
 }  // namespace skwr
 
@@ -0,0 +1,121 @@
+#include "kernels/cpu_dispatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "kernels/render_kernel.h"
+
+namespace skwr {
+
+const char* IsaLevelName(IsaLevel level) {
+    switch (level) {
+        case IsaLevel::Baseline:
+            return "baseline";
+        case IsaLevel::SSE42:
+            return "sse4.2";
+        case IsaLevel::AVX2:
+            return "avx2";
+        case IsaLevel::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+bool ParseIsaLevel(const std::string& name, IsaLevel* level) {
+    if (name == "baseline") {
+        *level = IsaLevel::Baseline;
+    } else if (name == "sse4.2" || name == "sse42") {
+        *level = IsaLevel::SSE42;
+    } else if (name == "avx2") {
+        *level = IsaLevel::AVX2;
+    } else if (name == "avx512") {
+        *level = IsaLevel::AVX512;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+IsaLevel DetectIsaLevel() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    // __builtin_cpu_supports also checks XCR0, so AVX state the OS doesn't save is not reported
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+        __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+        __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("f16c")) {
+        return IsaLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+        __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("f16c")) {
+        return IsaLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+        return IsaLevel::SSE42;
+    }
+#endif
+    return IsaLevel::Baseline;
+}
+
+// Highest level compiled into this binary (CMake defines SKWR_HAS_KERNEL_* per built variant)
+static IsaLevel BuiltIsaLevel() {
+#if defined(SKWR_HAS_KERNEL_AVX512)
+    return IsaLevel::AVX512;
+#elif defined(SKWR_HAS_KERNEL_AVX2)
+    return IsaLevel::AVX2;
+#elif defined(SKWR_HAS_KERNEL_SSE42)
+    return IsaLevel::SSE42;
+#else
+    return IsaLevel::Baseline;
+#endif
+}
+
+static IsaLevel ResolveIsaLevel() {
+    const IsaLevel detected = DetectIsaLevel();
+    IsaLevel level = std::min(detected, BuiltIsaLevel());
+
+    if (const char* forced = std::getenv("SKEWER_ISA")) {
+        IsaLevel requested;
+        if (!ParseIsaLevel(forced, &requested)) {
+            std::cerr << "[Dispatch] Ignoring unknown SKEWER_ISA value '" << forced << "'\n";
+        } else if (requested > level) {
+            // Never run code the CPU can't execute
+            std::cerr << "[Dispatch] SKEWER_ISA=" << forced << " is not available here; using "
+                      << IsaLevelName(level) << "\n";
+        } else {
+            level = requested;
+        }
+    }
+
+    std::clog << "[Dispatch] CPU supports " << IsaLevelName(detected) << ", running "
+              << IsaLevelName(level) << " kernels\n";
+    return level;
+}
+
+IsaLevel ActiveIsaLevel() {
+    static const IsaLevel level = ResolveIsaLevel();
+    return level;
+}
+
+RenderTileFn SelectRenderTile(IsaLevel level) {
+    switch (level) {
+#if defined(SKWR_HAS_KERNEL_AVX512)
+        case IsaLevel::AVX512:
+            return isa_avx512::RenderTile;
+#endif
+#if defined(SKWR_HAS_KERNEL_AVX2)
+        case IsaLevel::AVX2:
+            return isa_avx2::RenderTile;
+#endif
+#if defined(SKWR_HAS_KERNEL_SSE42)
+        case IsaLevel::SSE42:
+            return isa_sse42::RenderTile;
+#endif
+        default:
+            return isa_baseline::RenderTile;
+    }
+}
+
+}  // namespace skwr
@@ -0,0 +1,30 @@
+#ifndef SKWR_KERNELS_CPU_DISPATCH_H_
+#define SKWR_KERNELS_CPU_DISPATCH_H_
+
+#include <string>
+
+namespace skwr {
+
+// Instruction set levels the hot kernels are compiled for, ordered so a higher level can always
+// run the code of a lower one
+enum class IsaLevel {
+    Baseline,  // Whatever the compiler targets by default (SSE2 on x86-64, NEON on arm64)
+    SSE42,
+    AVX2,    // AVX2 + FMA + BMI2 + F16C
+    AVX512,  // AVX-512 F/DQ/BW/VL on top of AVX2
+};
+
+const char* IsaLevelName(IsaLevel level);
+bool ParseIsaLevel(const std::string& name, IsaLevel* level);
+
+// Highest level the CPU (and OS) supports, from cpuid
+IsaLevel DetectIsaLevel();
+
+// Level the renderer runs at: the highest level that is both supported by the CPU and built into
+// this binary. Setting SKEWER_ISA (baseline, sse4.2, avx2, avx512) forces a lower level, e.g. for
+// benchmarking. Resolved once on first call.
+IsaLevel ActiveIsaLevel();
+
+}  // namespace skwr
+
+#endif  // SKWR_KERNELS_CPU_DISPATCH_H_
@@ -1,10 +1,12 @@
 #ifndef SKWR_KERNELS_PATH_KERNEL_H_
 #define SKWR_KERNELS_PATH_KERNEL_H_
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "core/color.h"
 #include "core/constants.h"
+#include "core/kernel_inline.h"
 #include "core/ray.h"
 #include "core/rng.h"
 #include "core/spectral/spectral_utils.h"
@@ -15,14 +17,91 @@
 #include "materials/material.h"
 #include "materials/texture_lookup.h"
 #include "scene/scene.h"
+#include "scene/scene_intersect.h"
 #include "scene/surface_interaction.h"
 #include "session/render_options.h"
 
 namespace skwr {
 
-inline void AddSegment(PathSample& sample, const float& t_min, const float& t_max, const RGB& L,
-                       const float& alpha) {
-    sample.segments.push_back({t_min, t_max, L, alpha});
+SKWR_KERNEL_INLINE void AddSegment(PathSample& sample, const float& t_min, const float& t_max,
+                                   const RGB& L, const float& alpha, uint32_t object_id = kNoHitId,
+                                   uint32_t material_id = kNoHitId) {
+    sample.segments.push_back({t_min, t_max, L, alpha, object_id, material_id});
+}
+
+// Everything one camera path carries from one vertex to the next. Li runs a single path to
+// completion; the sorted tile kernel keeps a batch of these and advances them a vertex at a
+// time, so every piece of the bounce loop lives in the steps below rather than in Li itself.
+struct PathState {
+    Ray r;
+    RayDifferential diff;            // Pixel footprint for texture filtering
+    Spectrum L = Spectrum(0.0f);     // Accumulated Radiance (color)
+    Spectrum beta = Spectrum(1.0f);  // Throughput (attenuation)
+    int depth = 0;
+    bool specular_bounce = true;
+
+    // Deep Info
+    bool valid_deep_hit = false;
+    Point3 deep_hit_point;
+    Vec3 deep_origin;
+    float deep_hit_alpha = 1.0f;  // default solid
+    bool deep_hit_masked = false;  // Hit's material or object has deep output turned off
+    uint32_t deep_object_id = kNoHitId;
+    uint32_t deep_material_id = kNoHitId;
+
+    AOVSample aov;
+};
+
+SKWR_KERNEL_INLINE PathState StartPath(const Ray& ray, const RayDifferential& diff = {}) {
+    PathState st;
+    st.r = ray;
+    st.diff = diff;
+    st.deep_hit_point = ray.at(kFarClip);
+    st.deep_origin = ray.origin();
+    return st;
+}
+
+// Traces the path's current ray. Returns false if it escapes, which ends the path.
+SKWR_KERNEL_INLINE bool IntersectPath(PathState& st, const Scene& scene, SurfaceInteraction* si) {
+    if (IntersectScene(scene, st.r, kShadowEpsilon, kInfinity, si)) return true;
+
+    // Environment Segment
+    Spectrum env_L = st.beta * Spectrum(0.0f);
+    st.L += env_L;
+    return false;
+}
+
+// Carries the differential rays through a mirror or refraction at si, treating the surface as
+// locally flat: each offset direction bends about the same normal the main direction did.
+// eta is the relative IOR for refraction (unused for reflection).
+SKWR_KERNEL_INLINE void TransferSpecularDifferential(PathState& st, const Vec3& d_in,
+                                                     const Vec3& wi, const SurfaceInteraction& si,
+                                                     const Vec3& dpdx, const Vec3& dpdy,
+                                                     float eta) {
+    const Vec3& n = si.n_geom;  // Faces the incoming ray
+    const bool transmit = Dot(wi, n) < 0.0f;
+    auto bend = [&](const Vec3& dir, Vec3* out) {
+        if (!transmit) {
+            *out = Reflect(dir, n);
+            return true;
+        }
+        float cos_i = -Dot(dir, n);
+        float sin2_t = eta * eta * std::max(0.0f, 1.0f - cos_i * cos_i);
+        if (sin2_t >= 1.0f) return false;
+        *out = eta * dir + (eta * cos_i - std::sqrt(1.0f - sin2_t)) * n;
+        return true;
+    };
+
+    Vec3 base, bx, by;
+    RayDifferential& d = st.diff;
+    if (!bend(d_in, &base) || !bend(d.rx_direction, &bx) || !bend(d.ry_direction, &by)) {
+        d.valid = false;
+        return;
+    }
+    d.rx_origin = st.r.origin() + dpdx;
+    d.ry_origin = st.r.origin() + dpdy;
+    d.rx_direction = wi + (bx - base);
+    d.ry_direction = wi + (by - base);
 }
 
 /**
@@ -35,177 +114,224 @@ inline void AddSegment(PathSample& sample, const float& t_min, const float& t_ma
  * Bounce 1 (Red Wall): β = 1.0 × 0.5(Red) = 0.5
  * Bounce 2 (Grey Floor): β = 0.5 × 0.5(Grey) = 0.25
  * Hit Light (Intensity 10): FinalColor += β × 10 = 2.5
+ *
+ * ShadeHit is one trip around that loop for the hit `si`: emission, next event estimation,
+ * BSDF sampling and Russian roulette. Returns false when the path terminates.
  */
-inline PathSample Li(const Ray& ray, const Scene& scene, RNG& rng, const IntegratorConfig& config,
-                     const SampledWavelengths& wl) {
-    PathSample result;
-    Spectrum L(0.0f);     // Accumulated Radiance (color)
-    Spectrum beta(1.0f);  // Throughput (attenuation)
-    Ray r = ray;
-    bool specular_bounce = true;
+SKWR_KERNEL_INLINE bool ShadeHit(PathState& st, const SurfaceInteraction& si, const Scene& scene,
+                                 RNG& rng, const IntegratorConfig& config,
+                                 const SampledWavelengths& wl) {
+    // Empty Space Segment (Volume/Air)
+    // If we had volumetrics, we would ray-march here and accumulate L/Alpha.
+    // AddSegment(result, t_prev, si.t, Spectrum(0.0f), 0.0f);
 
-    // Deep Info
-    bool valid_deep_hit = false;
-    Point3 deep_hit_point = r.at(kFarClip);
-    Vec3 deep_origin = r.origin();
-    float deep_hit_alpha = 1.0f;  // default solid
+    const Material& mat = scene.GetMaterial(si.material_id);
 
-    // "Bounce" loop - calculates Li: how much Radiance (L) is incoming (i)
-    // by multiplying the total light by the amount lost at the end
-    for (int depth = 0; depth < config.max_depth; ++depth) {
-        SurfaceInteraction si;
-        if (!scene.Intersect(r, kShadowEpsilon, kInfinity, &si)) {
-            // Environment Segment
-            Spectrum env_L = beta * Spectrum(0.0f);
-            L += env_L;
-            break;
-        }
+    // Pixel footprint at the hit selects the texture MIP level
+    Vec3 dpdx, dpdy;
+    const bool has_footprint =
+        st.diff.valid && ComputeSurfaceDifferentials(st.diff, si, &dpdx, &dpdy);
+    UVDifferentials duv;
+    if (has_footprint && mat.HasAnyTexture()) duv = ComputeUVDifferentials(si, dpdx, dpdy);
 
-        // Empty Space Segment (Volume/Air)
-        // If we had volumetrics, we would ray-march here and accumulate L/Alpha.
-        // AddSegment(result, t_prev, si.t, Spectrum(0.0f), 0.0f);
-
-        const Material& mat = scene.GetMaterial(si.material_id);
-        ShadingData sd = ResolveShadingData(mat, si, scene);
-        // Lazy Evaluation
-        Spectrum opacity(1.0f);
-        float alpha = 1.0f;
-        if (mat.IsTransparent()) {
-            opacity = CurveToSpectrum(mat.opacity, wl);
-            alpha = opacity.Average();
-        }
-        Spectrum emission(0.0f);
-        if (mat.IsEmissive()) {
-            emission = CurveToSpectrum(mat.emission, wl);
-            if (specular_bounce) {
-                L += beta * emission;
-                deep_hit_point = si.point;  // Record actual emissive surface depth
-                valid_deep_hit = true;
-            }
-        }
+    ShadingData sd = ResolveShadingData(mat, si, scene, duv);
 
-        // Record if it's the first deep hit
-        if (!valid_deep_hit) {
-            // For simplicity, just have all hits update the depth
-            // and we rely on the loop finishing to define the color.
-            deep_hit_point = si.point;
-            // For volumetrics, we RAY MARCH here from r.origin to si.point
-            // and AddSegment() continuously.
+    // AOVs describe the first surface only
+    if (st.depth == 0 && config.enable_aovs) {
+        st.aov.albedo = ResolveAlbedoRGB(mat, si, scene, duv);
+        st.aov.normal = sd.n_shading;
+        st.aov.depth = std::max(0.0f, Dot(si.point - st.r.origin(), config.cam_w));
+        st.aov.object_id = si.object_id;
+        st.aov.material_id = si.material_id;
+    }
+
+    // Lazy Evaluation
+    Spectrum opacity(1.0f);
+    float alpha = 1.0f;
+    if (mat.IsTransparent()) {
+        opacity = CurveToSpectrum(mat.opacity, wl);
+        alpha = opacity.Average();
+    }
+    Spectrum emission(0.0f);
+    if (mat.IsEmissive()) {
+        emission = CurveToSpectrum(mat.emission, wl);
+        if (st.specular_bounce) {
+            st.L += st.beta * emission;
+            st.deep_hit_point = si.point;  // Record actual emissive surface depth
+            st.deep_hit_masked = !mat.deep || !scene.ObjectHasDeep(si.object_id);
+            st.deep_object_id = si.object_id;
+            st.deep_material_id = si.material_id;
+            st.valid_deep_hit = true;
         }
+    }
 
-        // /* Handle transparency - straight-through transmission */
-        // if (mat.IsTransparent()) {
-        //     // For non-refractive transparent surfaces (like foliage, smoke, etc.)
-        //     // This is separate from Dielectric refraction
-
-        //     Spectrum transmittance = Spectrum(1.0f) - opacity;
-
-        //     if (transmittance.MaxComponent() > 0.0f) {
-        //         // Continue ray through surface for the transmitted portion
-        //         // This requires spawning a transmission ray
-        //         // For now, we'll handle this in the BSDF sampling below
-        //     }
-        // }
-
-        /* Next Event Estimation */
-        if (mat.type != MaterialType::Metal && mat.type != MaterialType::Dielectric &&
-            !scene.Lights().empty()) {
-            int light_index = int(rng.UniformFloat() * scene.Lights().size());
-            const AreaLight& light = scene.Lights()[light_index];
-            LightSample ls = SampleLight(scene, light, rng);
-
-            // Shadow Ray setup
-            Vec3 to_light = ls.p - si.point;
-            float dist_sq = to_light.LengthSquared();
-            float dist = std::sqrt(dist_sq);
-            Vec3 wi_light = to_light / dist;
-
-            Ray shadow_ray(si.point + (wi_light * kShadowEpsilon), wi_light);
-            SurfaceInteraction shadow_si;  // dummy
-            if (!scene.Intersect(shadow_ray, 0.f, dist - 2.0f * kShadowEpsilon, &shadow_si)) {
-                float cos_light = std::fmax(0.0f, Dot(-wi_light, ls.n));
-                // Area PDF -> Solid Angle PDF: PDF_w = PDF_a * dist^2 / cos_light
-                if (cos_light > 0) {
-                    float light_pdf_w = ls.pdf * dist_sq / cos_light;
-
-                    // BSDF Evaluation
-                    float cos_surf = std::fmax(0.0f, Dot(wi_light, sd.n_shading));
-                    Spectrum f_val = EvalBSDF(mat, sd, si.wo, wi_light, wl);
-
-                    // Accumulate
-                    // Weight = 1.0 / (N_lights * PDF_w)
-                    // L += beta * f * Le * cos_surf * Weight
-                    Spectrum light_spec = CurveToSpectrum(ls.emission, wl);
-                    Spectrum direct_L = beta * f_val * light_spec * cos_surf /
-                                        (light_pdf_w * scene.InvLightCount());
-                    direct_L *= opacity;
-                    L += direct_L;
-                }
+    // Record if it's the first deep hit
+    if (!st.valid_deep_hit) {
+        // For simplicity, just have all hits update the depth
+        // and we rely on the loop finishing to define the color.
+        st.deep_hit_point = si.point;
+        st.deep_hit_masked = !mat.deep || !scene.ObjectHasDeep(si.object_id);
+        st.deep_object_id = si.object_id;
+        st.deep_material_id = si.material_id;
+        // For volumetrics, we RAY MARCH here from r.origin to si.point
+        // and AddSegment() continuously.
+    }
+
+    // /* Handle transparency - straight-through transmission */
+    // if (mat.IsTransparent()) {
+    //     // For non-refractive transparent surfaces (like foliage, smoke, etc.)
+    //     // This is separate from Dielectric refraction
+
+    //     Spectrum transmittance = Spectrum(1.0f) - opacity;
+
+    //     if (transmittance.MaxComponent() > 0.0f) {
+    //         // Continue ray through surface for the transmitted portion
+    //         // This requires spawning a transmission ray
+    //         // For now, we'll handle this in the BSDF sampling below
+    //     }
+    // }
+
+    /* Next Event Estimation */
+    if (mat.type != MaterialType::Metal && mat.type != MaterialType::Dielectric &&
+        !scene.Lights().empty()) {
+        int light_index = int(rng.UniformFloat() * scene.Lights().size());
+        const AreaLight& light = scene.Lights()[light_index];
+        LightSample ls = SampleLight(scene, light, rng);
+
+        // Shadow Ray setup
+        Vec3 to_light = ls.p - si.point;
+        float dist_sq = to_light.LengthSquared();
+        float dist = std::sqrt(dist_sq);
+        Vec3 wi_light = to_light / dist;
+
+        Ray shadow_ray(si.point + (wi_light * kShadowEpsilon), wi_light);
+        SurfaceInteraction shadow_si;  // dummy
+        if (!IntersectScene(scene, shadow_ray, 0.f, dist - 2.0f * kShadowEpsilon, &shadow_si)) {
+            float cos_light = std::fmax(0.0f, Dot(-wi_light, ls.n));
+            // Area PDF -> Solid Angle PDF: PDF_w = PDF_a * dist^2 / cos_light
+            if (cos_light > 0) {
+                float light_pdf_w = ls.pdf * dist_sq / cos_light;
+
+                // BSDF Evaluation
+                float cos_surf = std::fmax(0.0f, Dot(wi_light, sd.n_shading));
+                Spectrum f_val = EvalBSDF(mat, sd, si.wo, wi_light, wl);
+
+                // Accumulate
+                // Weight = 1.0 / (N_lights * PDF_w)
+                // L += beta * f * Le * cos_surf * Weight
+                Spectrum light_spec = CurveToSpectrum(ls.emission, wl);
+                Spectrum direct_L = st.beta * f_val * light_spec * cos_surf /
+                                    (light_pdf_w * scene.InvLightCount());
+                direct_L *= opacity;
+                st.L += direct_L;
             }
         }
+    }
 
-        /* Indirect bounce case */
-        Vec3 wi;
-        float pdf;
-        Spectrum f;
+    /* Indirect bounce case */
+    Vec3 wi;
+    float pdf;
+    Spectrum f;
 
-        /* BSDF check */
-        if (SampleBSDF(mat, sd, r, si, rng, wl, wi, pdf, f)) {
-            if (pdf > 0) {
-                float refract = Dot(wi, si.n_geom);
+    /* BSDF check */
+    if (SampleBSDF(mat, sd, st.r, si, rng, wl, wi, pdf, f)) {
+        if (pdf > 0) {
+            float refract = Dot(wi, si.n_geom);
 
-                if (!valid_deep_hit) {
-                    if (!(refract < 0.0f)) {
-                        valid_deep_hit = true;  // it's a reflection
-                    }
+            if (!st.valid_deep_hit) {
+                if (!(refract < 0.0f)) {
+                    st.valid_deep_hit = true;  // it's a reflection
                 }
+            }
 
-                float cos_theta = std::abs(refract);
-                Spectrum weight = f * cos_theta / pdf;  // Universal pdf func now
+            float cos_theta = std::abs(refract);
+            Spectrum weight = f * cos_theta / pdf;  // Universal pdf func now
 
-                // Modulate throughput by opacity for non-specular bounces
-                // For Dielectrics/Metals, opacity is typically 1.0
-                // For transparent diffuse, we need to account for absorption
-                if (mat.type == MaterialType::Lambertian) {
-                    weight *= alpha;  // Absorb based on opacity
-                }
+            // Modulate throughput by opacity for non-specular bounces
+            // For Dielectrics/Metals, opacity is typically 1.0
+            // For transparent diffuse, we need to account for absorption
+            if (mat.type == MaterialType::Lambertian) {
+                weight *= alpha;  // Absorb based on opacity
+            }
+
+            st.beta *= weight;
+            const Vec3 d_in = st.r.direction();
+            st.r = Ray(si.point + (wi * kShadowEpsilon), wi);
 
-                beta *= weight;
-                r = Ray(si.point + (wi * kShadowEpsilon), wi);
+            // If this bounce was sharp (Metal/Glass), next hit counts as specular
+            st.specular_bounce =
+                (mat.type == MaterialType::Metal || mat.type == MaterialType::Dielectric);
 
-                // If this bounce was sharp (Metal/Glass), next hit counts as specular
-                specular_bounce =
-                    (mat.type == MaterialType::Metal || mat.type == MaterialType::Dielectric);
+            // Footprints only stay meaningful through sharp bounces
+            if (st.specular_bounce && has_footprint) {
+                float eta = si.front_face ? 1.0f / mat.ior : mat.ior;
+                TransferSpecularDifferential(st, d_in, wi, si, dpdx, dpdy, eta);
+            } else {
+                st.diff.valid = false;
             }
-        } else {
-            // Absorbed (black body)
-            break;
         }
+    } else {
+        // Absorbed (black body)
+        return false;
+    }
 
-        // Russian Roulette
-        if (depth > 3) {
-            float max_beta = beta.MaxComponentValue();
-            if (max_beta < 0.001f) break;
-            float p = std::min(0.95f, max_beta);
-            if (rng.UniformFloat() > p) break;
-            beta = beta * (1.0f / p);
-        }
+    // Russian Roulette
+    if (st.depth > 3) {
+        float max_beta = st.beta.MaxComponentValue();
+        if (max_beta < 0.001f) return false;
+        float p = std::min(0.95f, max_beta);
+        if (rng.UniformFloat() > p) return false;
+        st.beta = st.beta * (1.0f / p);
     }
 
-    RGB final_rgb = SpectrumToRGB(L, wl);
-    if (valid_deep_hit) {
-        Vec3 to_hit = deep_hit_point - deep_origin;
-        float z_depth = Dot(to_hit, config.cam_w);
+    return ++st.depth < config.max_depth;
+}
+
+// Packs a finished path into the PathSample the film consumes
+SKWR_KERNEL_INLINE PathSample FinishPath(const PathState& st, const IntegratorConfig& config,
+                                         const SampledWavelengths& wl) {
+    PathSample result;
+    result.L = st.L;
+    result.aov = st.aov;
+
+    // Flat renders never read segments, so skip the conversion and bookkeeping entirely
+    if (!config.enable_deep) return result;
+
+    RGB final_rgb = SpectrumToRGB(st.L, wl);
+    float z_depth = kFarClip;
+    if (st.valid_deep_hit) {
+        Vec3 to_hit = st.deep_hit_point - st.deep_origin;
+        z_depth = Dot(to_hit, config.cam_w);
         // Ensure we don't get negative depth behind camera
         if (z_depth < 0.0f) z_depth = 0.0f;
-        AddSegment(result, z_depth, z_depth + kShadowEpsilon, final_rgb, deep_hit_alpha);
-    } else {
-        AddSegment(result, kFarClip, kFarClip + 1000.0f, final_rgb, deep_hit_alpha);
     }
-    result.L = L;
+
+    // Hits compositing doesn't need go to the far sample with the background, or nowhere
+    const bool selected = !st.deep_hit_masked && z_depth >= config.deep_min_depth &&
+                          z_depth <= config.deep_max_depth;
+    if (selected && st.valid_deep_hit) {
+        AddSegment(result, z_depth, z_depth + kShadowEpsilon, final_rgb, st.deep_hit_alpha,
+                   st.deep_object_id, st.deep_material_id);
+    } else if (selected || config.deep_flatten_excluded) {
+        AddSegment(result, kFarClip, kFarClip + 1000.0f, final_rgb, st.deep_hit_alpha);
+    }
     return result;
 }
 
+// "Bounce" loop - calculates Li: how much Radiance (L) is incoming (i)
+// by multiplying the total light by the amount lost at the end
+SKWR_KERNEL_INLINE PathSample Li(const Ray& ray, const RayDifferential& diff, const Scene& scene,
+                                 RNG& rng, const IntegratorConfig& config,
+                                 const SampledWavelengths& wl) {
+    PathState st = StartPath(ray, diff);
+    bool alive = config.max_depth > 0;
+    while (alive) {
+        SurfaceInteraction si;
+        alive = IntersectPath(st, scene, &si) && ShadeHit(st, si, scene, rng, config, wl);
+    }
+    return FinishPath(st, config, wl);
+}
+
 }  // namespace skwr
 
 #endif  // SKWR_KERNELS_PATH_KERNEL_H_
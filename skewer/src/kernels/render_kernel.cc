@@ -0,0 +1,194 @@
+// Compiled once per ISA level: CMake builds this file into one object library per level, each
+// with its own -m flags and SKWR_KERNEL_ISA set to the namespace the variant lives in
+// (isa_baseline, isa_sse42, ...). Everything the tile loop touches on the hot path is
+// header-inline so it is generated for the variant's instruction set.
+#include "kernels/render_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "core/ray.h"
+#include "core/rng.h"
+#include "core/sampling.h"
+#include "core/sampling/wavelength_sampler.h"
+#include "core/spectral/spectral_utils.h"
+#include "core/spectrum.h"
+#include "film/film.h"
+#include "film/film_tile.h"
+#include "integrators/path_sample.h"
+#include "kernels/path_kernel.h"
+#include "materials/material.h"
+#include "scene/camera.h"
+#include "scene/scene.h"
+#include "scene/surface_interaction.h"
+#include "session/render_options.h"
+
+#ifndef SKWR_KERNEL_ISA
+#error "render_kernel.cc must be compiled with SKWR_KERNEL_ISA set (see CMakeLists.txt)"
+#endif
+
+namespace skwr {
+namespace SKWR_KERNEL_ISA {
+
+namespace {
+
+// Differentials towards the next pixel in x and y, shrunk to one sample's share of the pixel
+inline RayDifferential CameraDifferential(const Camera& cam, const Ray& r, float u, float v,
+                                          int width, int height, const IntegratorConfig& config) {
+    RayDifferential diff = cam.GetRayDifferential(u, v, 1.0f / width, -1.0f / height);
+    const int frame_spp = config.total_samples > 0 ? config.total_samples
+                                                   : config.samples_per_pixel;
+    const float spp = static_cast<float>(std::max(1, frame_spp));
+    diff.Scale(r, std::max(0.125f, 1.0f / std::sqrt(spp)));
+    return diff;
+}
+
+// The tile's path for one pixel, for the sample index currently in flight
+struct WavefrontPath {
+    PathState state;
+    SampledWavelengths wl;
+};
+
+// A path's index in the tile. A type of this file rather than a plain uint32_t, so the live path
+// lists (and the std::vector code behind them) have internal linkage like the other wavefront
+// buffers instead of being weak symbols shared between ISA variants.
+struct PathIndex {
+    uint32_t value;
+    bool operator<(const PathIndex& o) const { return value < o.value; }
+};
+
+// Hits are shaded in (texture, material) order so paths running the same BSDF code and reading
+// the same texture memory go back to back; the path index keeps the order deterministic.
+struct ShadeItem {
+    uint32_t texture;
+    uint32_t material;
+    uint32_t path;
+
+    bool operator<(const ShadeItem& o) const {
+        if (texture != o.texture) return texture < o.texture;
+        if (material != o.material) return material < o.material;
+        return path < o.path;
+    }
+};
+
+// Deferred-shading version of the per-pixel loop: one sample index of every pixel in the tile
+// is traced as a wave, intersecting all live paths, then shading the hits grouped by material.
+// Each path seeds its RNG from its pixel and sample index and consumes it in the same order as Li
+// does, so the image is bit-identical to the unsorted kernel.
+void RenderTileSorted(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                      const IntegratorConfig& config) {
+    const int width = film->frame_width();
+    const int height = film->frame_height();
+    const TileBounds& bounds = tile->bounds();
+    const int tile_w = bounds.x1 - bounds.x0;
+    const size_t n = static_cast<size_t>(tile_w) * (bounds.y1 - bounds.y0);
+
+    std::vector<RNG> rngs(n);
+    std::vector<WavefrontPath> paths(n);
+    std::vector<SurfaceInteraction> hits(n);
+    std::vector<PathIndex> active, next;
+    std::vector<ShadeItem> queue;
+    active.reserve(n);
+    next.reserve(n);
+    queue.reserve(n);
+
+    for (int s = 0; s < config.samples_per_pixel; ++s) {
+        // Camera rays for the whole tile
+        active.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const int x = bounds.x0 + static_cast<int>(i) % tile_w;
+            const int y = bounds.y0 + static_cast<int>(i) / tile_w;
+            RNG& rng = rngs[i];
+            rng = MakeDeterministicPixelRNG(x, y, width, config.start_sample + s);
+            float u = (float(x) + rng.UniformFloat()) / width;
+            float v = 1.0f - (float(y) + rng.UniformFloat()) / height;
+
+            paths[i].wl = WavelengthSampler::Sample(rng.UniformFloat());
+            Ray r = cam.GetRay(u, v);
+            paths[i].state = StartPath(r, CameraDifferential(cam, r, u, v, width, height, config));
+            if (config.max_depth > 0) active.push_back({static_cast<uint32_t>(i)});
+        }
+
+        while (!active.empty()) {
+            // Traversal for every live path, in pixel order for ray coherence
+            queue.clear();
+            for (const PathIndex& p : active) {
+                const uint32_t i = p.value;
+                if (!IntersectPath(paths[i].state, scene, &hits[i])) continue;
+                const Material& mat = scene.GetMaterial(hits[i].material_id);
+                queue.push_back({mat.albedo_tex, hits[i].material_id, i});
+            }
+
+            // Shading grouped by material
+            std::sort(queue.begin(), queue.end());
+            next.clear();
+            for (const ShadeItem& item : queue) {
+                WavefrontPath& p = paths[item.path];
+                if (ShadeHit(p.state, hits[item.path], scene, rngs[item.path], config, p.wl)) {
+                    next.push_back({item.path});
+                }
+            }
+            std::sort(next.begin(), next.end());
+            active.swap(next);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            const int x = bounds.x0 + static_cast<int>(i) % tile_w;
+            const int y = bounds.y0 + static_cast<int>(i) / tile_w;
+            PathSample result = FinishPath(paths[i].state, config, paths[i].wl);
+            RGB pixel_color = SpectrumToRGB(result.L, paths[i].wl);
+
+            float weight = 1.0f;
+            tile->AddSample(x, y, pixel_color, weight);
+            if (config.enable_aovs) tile->AddAOVSample(x, y, result.aov, pixel_color, weight);
+
+            if (config.enable_deep) film->AddDeepSample(x, y, result);
+        }
+    }
+}
+
+}  // namespace
+
+void RenderTile(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                const IntegratorConfig& config) {
+    if (config.sort_shading) {
+        RenderTileSorted(scene, cam, film, tile, config);
+        return;
+    }
+
+    const int width = film->frame_width();
+    const int height = film->frame_height();
+    const TileBounds& bounds = tile->bounds();
+
+    for (int y = bounds.y0; y < bounds.y1; ++y) {
+        for (int x = bounds.x0; x < bounds.x1; ++x) {
+            for (int s = 0; s < config.samples_per_pixel; ++s) {
+                // Seeded per sample, not per pixel, so a sample's path does not depend on which
+                // samples were rendered before it and any range of a frame can be rendered alone
+                RNG rng = MakeDeterministicPixelRNG(x, y, width, config.start_sample + s);
+                float u = (float(x) + rng.UniformFloat()) / width;
+                float v = 1.0f - (float(y) + rng.UniformFloat()) / height;
+
+                SampledWavelengths wl = WavelengthSampler::Sample(rng.UniformFloat());
+
+                Ray r = cam.GetRay(u, v);
+                RayDifferential diff = CameraDifferential(cam, r, u, v, width, height, config);
+
+                PathSample result = Li(r, diff, scene, rng, config, wl);
+
+                RGB pixel_color = SpectrumToRGB(result.L, wl);
+
+                float weight = 1.0f;
+                tile->AddSample(x, y, pixel_color, weight);
+                if (config.enable_aovs) tile->AddAOVSample(x, y, result.aov, pixel_color, weight);
+
+                if (config.enable_deep) film->AddDeepSample(x, y, result);
+            }
+        }
+    }
+}
+
+}  // namespace SKWR_KERNEL_ISA
+}  // namespace skwr
@@ -0,0 +1,45 @@
+#ifndef SKWR_KERNELS_RENDER_KERNEL_H_
+#define SKWR_KERNELS_RENDER_KERNEL_H_
+
+#include "kernels/cpu_dispatch.h"
+
+namespace skwr {
+
+class Scene;
+class Camera;
+class Film;
+class FilmTile;
+struct IntegratorConfig;
+
+// Renders every sample of the pixels in tile->bounds() into the tile (deep samples go straight
+// to the film). This is the dispatch boundary for the hot path: render_kernel.cc (traversal,
+// triangle tests, spectral math, film accumulation, all inlined) is compiled once per ISA level
+// into the namespaces below. With IntegratorConfig::sort_shading the tile is traced one sample
+// index at a time as a wave, with hits shaded grouped by material.
+using RenderTileFn = void (*)(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                              const IntegratorConfig& config);
+
+namespace isa_baseline {
+void RenderTile(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                const IntegratorConfig& config);
+}
+namespace isa_sse42 {
+void RenderTile(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                const IntegratorConfig& config);
+}
+namespace isa_avx2 {
+void RenderTile(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                const IntegratorConfig& config);
+}
+namespace isa_avx512 {
+void RenderTile(const Scene& scene, const Camera& cam, Film* film, FilmTile* tile,
+                const IntegratorConfig& config);
+}
+
+// Variant compiled for the given level (levels not built into this binary are never returned
+// by ActiveIsaLevel)
+RenderTileFn SelectRenderTile(IsaLevel level);
+
+}  // namespace skwr
+
+#endif  // SKWR_KERNELS_RENDER_KERNEL_H_
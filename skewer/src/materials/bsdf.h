@@ -1,6 +1,7 @@
 #ifndef SKWR_MATERIALS_BSDF_H_
 #define SKWR_MATERIALS_BSDF_H_
 
+#include "core/kernel_inline.h"
 #include "core/rng.h"
 #include "core/spectrum.h"
 #include "core/vec3.h"
@@ -24,7 +25,7 @@ Spectrum EvalBSDF(const Material& mat, const ShadingData& sd, const Vec3& wo, co
  */
 float PdfBSDF(const Material& mat, const ShadingData& sd, const Vec3& wo, const Vec3& wi);
 
-inline float Reflectance(float cosine, float refraction_ratio) {
+SKWR_KERNEL_INLINE float Reflectance(float cosine, float refraction_ratio) {
     // Use Schlick's approximation for reflectance.
     auto r0 = (1 - refraction_ratio) / (1 + refraction_ratio);
     r0 = r0 * r0;
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include "core/color.h"
 #include "core/spectral/spectral_curve.h"
 
 namespace skwr {
@@ -12,6 +13,7 @@ enum class MaterialType : uint8_t { Lambertian, Metal, Dielectric };
 // 32-byte aligned to fit in cache?
 struct alignas(16) Material {
     SpectralCurve albedo;                          // Color (Diffuse or Specular)
+    RGB albedo_rgb = RGB(1.0f);                    // Linear RGB of albedo (for the albedo AOV)
     SpectralCurve emission;                        //
     float roughness;                               // 0.0 = Perfect Mirror, 1.0 = Matte
     float ior;                                     // Index of refraction
@@ -19,6 +21,7 @@ struct alignas(16) Material {
     SpectralCurve opacity = {{1.0f, 1.0f, 1.0f}};  // 1 = opaque, 0 = fully transparent
     // OR: texture reference later
     MaterialType type;
+    bool deep = true;  // Hits record deep segments (see IntegratorConfig::deep_flatten_excluded)
 
     // Texture references (kNoTexture = UINT32_MAX means no texture)
     uint32_t albedo_tex = UINT32_MAX;
@@ -33,6 +36,7 @@ struct alignas(16) Material {
     bool HasAlbedoTexture() const { return albedo_tex != UINT32_MAX; }
     bool HasNormalMap() const { return normal_tex != UINT32_MAX; }
     bool HasRoughnessMap() const { return roughness_tex != UINT32_MAX; }
+    bool HasAnyTexture() const { return HasAlbedoTexture() || HasNormalMap() || HasRoughnessMap(); }
 };
 
 }  // namespace skwr
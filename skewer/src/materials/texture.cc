@@ -5,63 +5,426 @@
 #include "materials/texture.h"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
+#include "core/half.h"
+#include "core/spectral/spectral_curve.h"
+#include "core/spectral/spectral_utils.h"
 #include "stb_image.h"
 
 namespace skwr {
 
-bool ImageTexture::Load(const std::string& filepath) {
-    int n;
-    stbi_set_flip_vertically_on_load(true);
-    float* raw = stbi_loadf(filepath.c_str(), &width, &height, &n, 3);
-    if (!raw) {
+namespace {
+
+// stbi_loadf's LDR conversion (gamma 2.2, scale 1), which every 8-bit texture used to go through
+const std::array<float, 256> kByteToLinear = [] {
+    std::array<float, 256> table{};
+    for (int i = 0; i < 256; ++i) table[i] = std::pow(static_cast<float>(i) / 255.0f, 2.2f);
+    return table;
+}();
+
+// Nearest table entry, so decoded 8-bit values re-encode to the same byte
+uint8_t LinearToByte(float v) {
+    auto it = std::lower_bound(kByteToLinear.begin(), kByteToLinear.end(), v);
+    if (it == kByteToLinear.end()) return 255;
+    if (it != kByteToLinear.begin() && v - *(it - 1) < *it - v) --it;
+    return static_cast<uint8_t>(it - kByteToLinear.begin());
+}
+
+uint8_t UnitToByte(float v) {
+    return static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+// Per-format texel encoding. Encode takes RGB in the float convention; Decode writes kChannels
+// floats, which for the colour formats are the same RGB the float path would have produced.
+template <TexelFormat F>
+struct TexelCodec;
+
+template <>
+struct TexelCodec<TexelFormat::RGBA8> {
+    static constexpr int kChannels = 3;
+    static void Encode(const float* rgb, uint8_t* out) {
+        for (int c = 0; c < 3; ++c) out[c] = LinearToByte(rgb[c]);
+        out[3] = 255;
+    }
+    static void Decode(const uint8_t* in, float* rgb) {
+        for (int c = 0; c < 3; ++c) rgb[c] = kByteToLinear[in[c]];
+    }
+};
+
+template <>
+struct TexelCodec<TexelFormat::RGBHalf> {
+    static constexpr int kChannels = 3;
+    static void Encode(const float* rgb, uint8_t* out) {
+        uint16_t h[3] = {FloatToHalf(rgb[0]), FloatToHalf(rgb[1]), FloatToHalf(rgb[2])};
+        std::memcpy(out, h, sizeof(h));
+    }
+    static void Decode(const uint8_t* in, float* rgb) {
+        uint16_t h[3];
+        std::memcpy(h, in, sizeof(h));
+        for (int c = 0; c < 3; ++c) rgb[c] = HalfToFloat(h[c]);
+    }
+};
+
+// Unit-length normals only need X and Y; Z is always the positive root
+template <>
+struct TexelCodec<TexelFormat::RG8Normal> {
+    static constexpr int kChannels = 3;
+    static void Encode(const float* rgb, uint8_t* out) {
+        out[0] = UnitToByte(rgb[0]);
+        out[1] = UnitToByte(rgb[1]);
+    }
+    static void Decode(const uint8_t* in, float* rgb) {
+        const float x = static_cast<float>(in[0]) * (2.0f / 255.0f) - 1.0f;
+        const float y = static_cast<float>(in[1]) * (2.0f / 255.0f) - 1.0f;
+        const float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+        rgb[0] = 0.5f * x + 0.5f;
+        rgb[1] = 0.5f * y + 0.5f;
+        rgb[2] = 0.5f * z + 0.5f;
+    }
+};
+
+// The per-hit RGBToCurve (ToLinear plus an rgb2spec table fetch) done once per texel at load
+template <>
+struct TexelCodec<TexelFormat::SpectralCoeffs> {
+    static constexpr int kChannels = 4;
+    static void Encode(const float* rgb, uint8_t* out) {
+        SpectralCurve curve = RGBToCurve(RGB(rgb[0], rgb[1], rgb[2]));
+        const float packed[4] = {curve.coeff[0], curve.coeff[1], curve.coeff[2], curve.scale};
+        std::memcpy(out, packed, sizeof(packed));
+    }
+    static void Decode(const uint8_t* in, float* out) { std::memcpy(out, in, 4 * sizeof(float)); }
+};
+
+// Byte offset of texel (x, y) of a level within its tile
+template <TexelFormat F>
+size_t TexelOffset(int x, int y) {
+    constexpr int kMask = kTextureTileSize - 1;
+    return static_cast<size_t>(((y & kMask) << kTextureTileShift) | (x & kMask)) * TexelBytes(F);
+}
+
+// Encodes one level's dense pixels into tiles; padding texels past the edge stay zero
+template <TexelFormat F>
+std::vector<uint32_t> TileLevel(const std::vector<float>& pixels, const MipLevel& level) {
+    constexpr size_t kTileWords = TexelBytes(F) * kTextureTileTexels / 4;
+    std::vector<uint32_t> out(static_cast<size_t>(level.tiles_x) * level.tiles_y * kTileWords);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(out.data());
+    for (int y = 0; y < level.height; ++y) {
+        for (int x = 0; x < level.width; ++x) {
+            const int tile = (y >> kTextureTileShift) * level.tiles_x + (x >> kTextureTileShift);
+            uint8_t* dst = bytes + tile * kTileWords * 4 + TexelOffset<F>(x, y);
+            TexelCodec<F>::Encode(&pixels[(static_cast<size_t>(y) * level.width + x) * 3], dst);
+        }
+    }
+    return out;
+}
+
+std::vector<uint32_t> TileLevel(const std::vector<float>& pixels, const MipLevel& level,
+                                TexelFormat format) {
+    switch (format) {
+        case TexelFormat::RGBA8:
+            return TileLevel<TexelFormat::RGBA8>(pixels, level);
+        case TexelFormat::RGBHalf:
+            return TileLevel<TexelFormat::RGBHalf>(pixels, level);
+        case TexelFormat::RG8Normal:
+            return TileLevel<TexelFormat::RG8Normal>(pixels, level);
+        case TexelFormat::SpectralCoeffs:
+            return TileLevel<TexelFormat::SpectralCoeffs>(pixels, level);
+    }
+    return {};
+}
+
+// Source texels (and their weights) behind one texel of the next level along one axis. Even
+// sizes are a 2-tap box. Odd sizes 2n+1 shrink to n texels of a 3-tap box whose weights
+// (n - i, n, i + 1) / (2n + 1) give every source texel, the last one included, an equal share.
+struct DownsampleTaps {
+    int first;
+    int count;
+    float weight[3];
+};
+
+DownsampleTaps TapsFor(int i, int src_size, int dst_size) {
+    if (src_size == 1) return {0, 1, {1.0f, 0.0f, 0.0f}};
+    if (src_size % 2 == 0) return {2 * i, 2, {0.5f, 0.5f, 0.0f}};
+    const float inv = 1.0f / static_cast<float>(src_size);
+    return {2 * i, 3, {(dst_size - i) * inv, dst_size * inv, (i + 1) * inv}};
+}
+
+// Separable box filter down to dw x dh (half of sw x sh, rounded down)
+std::vector<float> Downsample(const std::vector<float>& src, int sw, int sh, int dw, int dh) {
+    std::vector<float> dst(static_cast<size_t>(dw) * dh * 3);
+    for (int y = 0; y < dh; ++y) {
+        const DownsampleTaps ty = TapsFor(y, sh, dh);
+        for (int x = 0; x < dw; ++x) {
+            const DownsampleTaps tx = TapsFor(x, sw, dw);
+            float sum[3] = {0.0f, 0.0f, 0.0f};
+            for (int j = 0; j < ty.count; ++j) {
+                for (int i = 0; i < tx.count; ++i) {
+                    const float w = ty.weight[j] * tx.weight[i];
+                    const size_t s = (static_cast<size_t>(ty.first + j) * sw + tx.first + i) * 3;
+                    for (int c = 0; c < 3; ++c) sum[c] += w * src[s + c];
+                }
+            }
+            for (int c = 0; c < 3; ++c) dst[(static_cast<size_t>(y) * dw + x) * 3 + c] = sum[c];
+        }
+    }
+    return dst;
+}
+
+const char* TexelFormatName(TexelFormat format) {
+    switch (format) {
+        case TexelFormat::RGBA8:
+            return "RGBA8";
+        case TexelFormat::RGBHalf:
+            return "RGB half";
+        case TexelFormat::RG8Normal:
+            return "RG8 normal";
+        case TexelFormat::SpectralCoeffs:
+            return "spectral coefficients";
+    }
+    return "unknown";
+}
+
+}  // namespace
+
+bool ImageTexture::Load(const std::string& filepath, TextureUsage usage,
+                        TextureCache* tile_cache) {
+    int w, h, n;
+    // A process-wide stb_image setting; textures decode concurrently, so set it exactly once
+    static std::once_flag flip_once;
+    std::call_once(flip_once, [] { stbi_set_flip_vertically_on_load(true); });
+
+    std::vector<float> pixels;
+    TexelFormat fmt;
+    if (stbi_is_hdr(filepath.c_str())) {
+        float* raw = stbi_loadf(filepath.c_str(), &w, &h, &n, 3);
+        if (raw) {
+            pixels.assign(raw, raw + static_cast<size_t>(w) * h * 3);
+            stbi_image_free(raw);
+        }
+        fmt = TexelFormat::RGBHalf;
+    } else {
+        // 8-bit (and 16-bit, which stb_image reduces to 8 bits for LDR loads anyway) sources
+        unsigned char* raw = stbi_load(filepath.c_str(), &w, &h, &n, 3);
+        if (raw) {
+            const bool linear =
+                usage == TextureUsage::Normal || usage == TextureUsage::GltfRoughness;
+            pixels.resize(static_cast<size_t>(w) * h * 3);
+            for (size_t i = 0; i < pixels.size(); ++i) {
+                pixels[i] = linear ? static_cast<float>(raw[i]) / 255.0f : kByteToLinear[raw[i]];
+            }
+            stbi_image_free(raw);
+        }
+        fmt = usage == TextureUsage::Normal ? TexelFormat::RG8Normal : TexelFormat::RGBA8;
+    }
+    if (usage == TextureUsage::SpectralAlbedo) fmt = TexelFormat::SpectralCoeffs;
+    if (usage == TextureUsage::GltfRoughness) {
+        for (size_t i = 0; i < pixels.size(); i += 3) pixels[i] = pixels[i + 1];
+    }
+    if (pixels.empty()) {
         std::cerr << "[Texture] Failed to load: " << filepath << " (" << stbi_failure_reason()
                   << ")\n";
         width = 0;
         height = 0;
         return false;
     }
-    data.assign(raw, raw + width * height * 3);
-    stbi_image_free(raw);
-    std::clog << "[Texture] Loaded: " << filepath << " (" << width << "x" << height << ")\n";
+
+    Build(std::move(pixels), w, h, fmt, tile_cache);
+    std::clog << "[Texture] Loaded: " << filepath << " (" << width << "x" << height << ", "
+              << TexelFormatName(format) << ", " << levels.size() << " MIP levels, "
+              << (TileBytes() >> 10) << " KB" << (cache ? ", cached" : "") << ")\n";
     return true;
 }
 
-RGB ImageTexture::Sample(float u, float v) const {
-    if (data.empty()) return RGB(1.0f, 0.0f, 1.0f);  // Magenta = missing texture
+void ImageTexture::Build(std::vector<float> pixels, int w, int h, TexelFormat fmt,
+                         TextureCache* tile_cache) {
+    width = w;
+    height = h;
+    format = fmt;
+    cache = tile_cache;
+    cache_base = 0;
+    mapped_tiles = nullptr;
+    mapping.reset();
+    levels.clear();
+    tiles.clear();
+
+    // Only the current level is held densely; each is tiled and handed off before the next
+    const size_t tile_bytes = TexelBytes(format) * kTextureTileTexels;
+    uint32_t next_tile = 0;
+    while (true) {
+        MipLevel level;
+        level.width = w;
+        level.height = h;
+        level.tiles_x = (w + kTextureTileSize - 1) / kTextureTileSize;
+        level.tiles_y = (h + kTextureTileSize - 1) / kTextureTileSize;
+        level.first_tile = next_tile;
+        const uint32_t count = static_cast<uint32_t>(level.tiles_x * level.tiles_y);
+        next_tile += count;
+        levels.push_back(level);
+
+        std::vector<uint32_t> level_tiles = TileLevel(pixels, level, format);
+        if (cache) {
+            uint32_t first = cache->Store(level_tiles.data(), tile_bytes, count);
+            if (levels.size() == 1) cache_base = first;
+        } else {
+            tiles.insert(tiles.end(), level_tiles.begin(), level_tiles.end());
+        }
+
+        if (w == 1 && h == 1) break;
+        const int dw = std::max(1, w / 2);
+        const int dh = std::max(1, h / 2);
+        pixels = Downsample(pixels, w, h, dw, dh);
+        w = dw;
+        h = dh;
+    }
+}
+
+size_t ImageTexture::TileBytes() const {
+    return TileCount() * TexelBytes(format) * kTextureTileTexels;
+}
+
+uint32_t ImageTexture::TileCount() const {
+    uint32_t count = 0;
+    for (const MipLevel& level : levels) count += level.tiles_x * level.tiles_y;
+    return count;
+}
+
+RGB ImageTexture::Texel(int level, int x, int y) const {
+    const uint8_t* tile = TileAt(levels[level], x >> kTextureTileShift, y >> kTextureTileShift);
+    float out[4] = {1.0f, 0.0f, 1.0f, 0.0f};  // Magenta if the format is unknown
+    switch (format) {
+        case TexelFormat::RGBA8:
+            TexelCodec<TexelFormat::RGBA8>::Decode(tile + TexelOffset<TexelFormat::RGBA8>(x, y),
+                                                   out);
+            break;
+        case TexelFormat::RGBHalf:
+            TexelCodec<TexelFormat::RGBHalf>::Decode(
+                tile + TexelOffset<TexelFormat::RGBHalf>(x, y), out);
+            break;
+        case TexelFormat::RG8Normal:
+            TexelCodec<TexelFormat::RG8Normal>::Decode(
+                tile + TexelOffset<TexelFormat::RG8Normal>(x, y), out);
+            break;
+        case TexelFormat::SpectralCoeffs:
+            TexelCodec<TexelFormat::SpectralCoeffs>::Decode(
+                tile + TexelOffset<TexelFormat::SpectralCoeffs>(x, y), out);
+            break;
+    }
+    return RGB(out[0], out[1], out[2]);
+}
+
+template <TexelFormat F>
+void ImageTexture::BilinearAs(const MipLevel& l, float u, float v, float* out) const {
+    constexpr int kChannels = TexelCodec<F>::kChannels;
 
     // Repeat (tiling) wrapping
     u = u - std::floor(u);
     v = v - std::floor(v);
 
-    // Bilinear interpolation
-    float fx = u * static_cast<float>(width - 1);
-    float fy = v * static_cast<float>(height - 1);
+    float fx = u * static_cast<float>(l.width - 1);
+    float fy = v * static_cast<float>(l.height - 1);
 
     int x0 = static_cast<int>(fx);
     int y0 = static_cast<int>(fy);
-    int x1 = std::min(x0 + 1, width - 1);
-    int y1 = std::min(y0 + 1, height - 1);
+    int x1 = std::min(x0 + 1, l.width - 1);
+    int y1 = std::min(y0 + 1, l.height - 1);
 
     float tx = fx - static_cast<float>(x0);
     float ty = fy - static_cast<float>(y0);
 
-    auto fetch = [&](int x, int y) -> RGB {
-        int idx = (y * width + x) * 3;
-        return RGB(data[idx], data[idx + 1], data[idx + 2]);
-    };
+    // Decode the four taps (00, 10, 01, 11) into lanes
+    const int xs[4] = {x0, x1, x0, x1};
+    const int ys[4] = {y0, y0, y1, y1};
+    float taps[4][kChannels];
+    const int tile_x = x0 >> kTextureTileShift;
+    const int tile_y = y0 >> kTextureTileShift;
+    if (tile_x == (x1 >> kTextureTileShift) && tile_y == (y1 >> kTextureTileShift)) {
+        // Common case: all four texels share a tile, so it is looked up once
+        const uint8_t* tile = TileAt(l, tile_x, tile_y);
+        for (int i = 0; i < 4; ++i) {
+            TexelCodec<F>::Decode(tile + TexelOffset<F>(xs[i], ys[i]), taps[i]);
+        }
+    } else {
+        // Each tap is decoded before the next fetch, which may replace the previous tile
+        for (int i = 0; i < 4; ++i) {
+            const uint8_t* tile =
+                TileAt(l, xs[i] >> kTextureTileShift, ys[i] >> kTextureTileShift);
+            TexelCodec<F>::Decode(tile + TexelOffset<F>(xs[i], ys[i]), taps[i]);
+        }
+    }
+
+    // Bilinear blend as one weighted sum over the taps
+    const float w[4] = {(1.0f - tx) * (1.0f - ty), tx * (1.0f - ty), (1.0f - tx) * ty, tx * ty};
+    for (int c = 0; c < kChannels; ++c) {
+        float sum = 0.0f;
+        for (int i = 0; i < 4; ++i) sum += w[i] * taps[i][c];
+        out[c] = sum;
+    }
+}
+
+void ImageTexture::Filter(int level, float u, float v, float* out) const {
+    const MipLevel& l = levels[level];
+    switch (format) {
+        case TexelFormat::RGBA8:
+            return BilinearAs<TexelFormat::RGBA8>(l, u, v, out);
+        case TexelFormat::RGBHalf:
+            return BilinearAs<TexelFormat::RGBHalf>(l, u, v, out);
+        case TexelFormat::RG8Normal:
+            return BilinearAs<TexelFormat::RG8Normal>(l, u, v, out);
+        case TexelFormat::SpectralCoeffs:
+            return BilinearAs<TexelFormat::SpectralCoeffs>(l, u, v, out);
+    }
+}
+
+void ImageTexture::Lookup(float u, float v, const UVDifferentials& duv, float* out) const {
+    // Footprint in level-0 texels: the longer of the two per-pixel steps
+    const float w = static_cast<float>(width);
+    const float h = static_cast<float>(height);
+    const float lx2 = (duv.dudx * w) * (duv.dudx * w) + (duv.dvdx * h) * (duv.dvdx * h);
+    const float ly2 = (duv.dudy * w) * (duv.dudy * w) + (duv.dvdy * h) * (duv.dvdy * h);
+    const float footprint = std::sqrt(std::max(lx2, ly2));
+    if (!(footprint > 1.0f)) return Filter(0, u, v, out);  // Magnified (or no differentials)
+
+    const int last = static_cast<int>(levels.size()) - 1;
+    const float level = std::min(std::log2(footprint), static_cast<float>(last));
+    const int l0 = static_cast<int>(level);
+    if (l0 >= last) return Filter(last, u, v, out);
 
-    RGB c00 = fetch(x0, y0);
-    RGB c10 = fetch(x1, y0);
-    RGB c01 = fetch(x0, y1);
-    RGB c11 = fetch(x1, y1);
+    const float t = level - static_cast<float>(l0);
+    float fine[4] = {}, coarse[4] = {};
+    Filter(l0, u, v, fine);
+    Filter(l0 + 1, u, v, coarse);
+    for (int c = 0; c < 4; ++c) out[c] = (1.0f - t) * fine[c] + t * coarse[c];
+}
+
+RGB ImageTexture::Bilinear(int level, float u, float v) const {
+    float out[4] = {};
+    Filter(level, u, v, out);
+    return RGB(out[0], out[1], out[2]);
+}
+
+RGB ImageTexture::Sample(float u, float v) const {
+    if (levels.empty()) return RGB(1.0f, 0.0f, 1.0f);  // Magenta = missing texture
+    return Bilinear(0, u, v);
+}
+
+RGB ImageTexture::Sample(float u, float v, const UVDifferentials& duv) const {
+    if (levels.empty()) return RGB(1.0f, 0.0f, 1.0f);  // Magenta = missing texture
+    float out[4] = {};
+    Lookup(u, v, duv, out);
+    return RGB(out[0], out[1], out[2]);
+}
 
-    // Bilinear blend
-    RGB r0 = (1.0f - tx) * c00 + tx * c10;
-    RGB r1 = (1.0f - tx) * c01 + tx * c11;
-    return (1.0f - ty) * r0 + ty * r1;
+SpectralCurve ImageTexture::SampleCurve(float u, float v, const UVDifferentials& duv) const {
+    if (levels.empty()) return SpectralCurve{{0.0f, 0.0f, 0.0f}, 0.0f};
+    float out[4] = {};
+    Lookup(u, v, duv, out);
+    return SpectralCurve{{out[0], out[1], out[2]}, out[3]};
 }
 
 }  // namespace skwr
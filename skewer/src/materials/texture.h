@@ -1,32 +1,143 @@
 #ifndef SKWR_MATERIALS_TEXTURE_H_
 #define SKWR_MATERIALS_TEXTURE_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "core/color.h"
+#include "core/spectral/spectral_curve.h"
+#include "materials/texture_cache.h"
 
 namespace skwr {
 
 constexpr uint32_t kNoTexture = UINT32_MAX;
 
-// Image-based texture: stores linear-light RGB float data.
-// Sample() performs bilinear interpolation with repeat (tiling) wrapping.
-struct ImageTexture {
-    std::vector<float> data;  // Linear RGB, w*h*3 floats
+// How far the texture coordinates move per pixel step in x and y at a hit. All zero (no ray
+// differentials) selects the finest MIP level.
+struct UVDifferentials {
+    float dudx = 0.0f, dvdx = 0.0f;
+    float dudy = 0.0f, dvdy = 0.0f;
+};
+
+// How a texture's texels are encoded in its tiles. The colour formats decode to the same
+// convention as the float data stbi_loadf used to produce, so shading code does not care which
+// one it got; SpectralCoeffs decodes to an rgb2spec curve instead (see SampleCurve).
+enum class TexelFormat : uint8_t {
+    RGBA8,           // 8-bit source colour; decoded through a 256-entry linearisation table
+    RGBHalf,         // HDR source; three binary16 floats
+    RG8Normal,       // Tangent-space normal map; X and Y in 8 bits, Z rebuilt at fetch time
+    SpectralCoeffs,  // Albedo converted once at load: three sigmoid coefficients and a scale
+};
+
+constexpr size_t TexelBytes(TexelFormat format) {
+    switch (format) {
+        case TexelFormat::RGBA8:
+            return 4;
+        case TexelFormat::RGBHalf:
+            return 6;
+        case TexelFormat::RG8Normal:
+            return 2;
+        case TexelFormat::SpectralCoeffs:
+            return 16;
+    }
+    return 0;
+}
+
+// What a texture is sampled for; decides which format a file is stored in
+enum class TextureUsage : uint8_t {
+    Color,           // Roughness, or albedo sampled as RGB
+    Albedo,          // Albedo; the scene decides between Color and SpectralAlbedo
+    Normal,          // Tangent-space normal map (raw [0,1] data, not gamma encoded)
+    SpectralAlbedo,  // Albedo stored as rgb2spec coefficients
+    GltfRoughness,   // glTF metallic-roughness map: linear data, roughness (G) moved into R
+};
+
+// One level of a MIP chain, split into kTextureTileSize^2 tiles stored row by row
+struct MipLevel {
     int width = 0;
     int height = 0;
+    int tiles_x = 0;          // Tiles per row
+    int tiles_y = 0;          // Tile rows
+    uint32_t first_tile = 0;  // Index of this level's first tile within the texture
+};
+
+// Image-based texture: a tiled MIP chain built at load time, kept in the source's precision
+// (see TexelFormat). Tiles are either held by the texture itself or, when a TextureCache is
+// supplied, written to the cache's backing store and paged in on demand. Sample() performs
+// bilinear (finest level) or trilinear (footprint-selected) filtering with repeat (tiling)
+// wrapping.
+struct ImageTexture {
+    std::vector<MipLevel> levels;  // levels[0] is the image; each next level is half the size
+    int width = 0;                 // Size of levels[0]
+    int height = 0;
+    TexelFormat format = TexelFormat::RGBA8;
 
-    // Load from file using stb_image (linear float).
-    // Returns false on failure.
-    bool Load(const std::string& filepath);
+    std::vector<uint32_t> tiles;    // Resident tile data (only when cache is null)
+    TextureCache* cache = nullptr;  // Out-of-core tile store, shared between textures
+    uint32_t cache_base = 0;        // Cache id of this texture's tile 0
 
-    // Sample at UV coordinates with bilinear filtering and repeat wrapping.
+    // Tiles read in place from a memory-mapped asset bundle (see io/asset_bundle.h) instead of
+    // `tiles`; `mapping` keeps the pages mapped for as long as any copy of the texture lives
+    const uint8_t* mapped_tiles = nullptr;
+    std::shared_ptr<const void> mapping;
+
+    // Load from file using stb_image and build the MIP chain. 8-bit files are kept as RGBA8
+    // (RG8Normal for normal maps), HDR files as half floats, and spectral albedo as coefficients
+    // whatever the source. Returns false on failure.
+    bool Load(const std::string& filepath, TextureUsage usage = TextureUsage::Color,
+              TextureCache* tile_cache = nullptr);
+
+    // Builds the MIP chain from w*h*3 floats (in the decoded convention of the colour formats)
+    // with a 2x2 box filter, encodes every level into `fmt` and tiles it into `tiles` (or into
+    // tile_cache if given). Consumes the pixels.
+    void Build(std::vector<float> pixels, int w, int h, TexelFormat fmt,
+               TextureCache* tile_cache = nullptr);
+
+    // Single decoded texel of a level (the first three coefficients for SpectralCoeffs); x and
+    // y must be in range
+    RGB Texel(int level, int x, int y) const;
+
+    // Bilinear interpolation on one level with repeat (tiling) wrapping
+    RGB Bilinear(int level, float u, float v) const;
+
+    // Sample at UV coordinates with bilinear filtering on the finest level.
     // Callers pass si.uv.x() and si.uv.y().
     RGB Sample(float u, float v) const;
 
-    bool IsValid() const { return !data.empty(); }
+    // Trilinear lookup: picks the two levels whose texel size brackets the pixel footprint
+    RGB Sample(float u, float v, const UVDifferentials& duv) const;
+
+    // Same filtering for SpectralCoeffs textures, blending the curve coefficients directly
+    SpectralCurve SampleCurve(float u, float v, const UVDifferentials& duv) const;
+
+    bool IsValid() const { return !levels.empty(); }
+    bool IsSpectral() const { return format == TexelFormat::SpectralCoeffs; }
+
+    // Bytes of encoded texel data across all levels
+    size_t TileBytes() const;
+    uint32_t TileCount() const;
+
+    // Encoded texels of tile `id` (counted across all levels), wherever the tiles live
+    const uint8_t* TileData(uint32_t id) const {
+        if (cache) return cache->Fetch(cache_base + id);
+        const size_t offset = id * TexelBytes(format) * kTextureTileTexels;
+        if (mapped_tiles) return mapped_tiles + offset;
+        return reinterpret_cast<const uint8_t*>(tiles.data()) + offset;
+    }
+
+  private:
+    // Filtered decoded channels (three, or four for SpectralCoeffs) into out[0..3]
+    template <TexelFormat F>
+    void BilinearAs(const MipLevel& level, float u, float v, float* out) const;
+    void Filter(int level, float u, float v, float* out) const;
+    void Lookup(float u, float v, const UVDifferentials& duv, float* out) const;
+
+    const uint8_t* TileAt(const MipLevel& level, int tx, int ty) const {
+        return TileData(level.first_tile + static_cast<uint32_t>(ty * level.tiles_x + tx));
+    }
 };
 
 }  // namespace skwr
@@ -0,0 +1,148 @@
+#include "materials/texture_cache.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+
+namespace skwr {
+
+namespace {
+
+constexpr size_t kMinTileBytes = 2 * kTextureTileTexels;  // Smallest format (RG8)
+constexpr int kThreadSlots = 64;  // Direct-mapped per-thread tile table
+
+struct TileSlot {
+    uint32_t tile_id = UINT32_MAX;
+    std::shared_ptr<const uint32_t[]> tile;
+};
+
+thread_local std::array<TileSlot, kThreadSlots> t_slots;
+thread_local uint64_t t_slots_owner = UINT64_MAX;  // uid_ of the cache the slots belong to
+
+std::atomic<uint64_t> g_next_uid(0);
+
+}  // namespace
+
+TextureCache::TextureCache(size_t budget_bytes)
+    : budget_bytes_(budget_bytes),
+      // Every shard keeps at least the tile it just paged in
+      shard_budget_(std::max(budget_bytes / kShardCount, kMinTileBytes)),
+      uid_(g_next_uid.fetch_add(1)),
+      tile_offsets_(1, 0) {
+    backing_ = std::tmpfile();
+    if (!backing_) {
+        throw std::runtime_error("Cannot create texture cache scratch file");
+    }
+    std::clog << "[Texture] Cache budget: " << (budget_bytes_ >> 20) << " MB\n";
+}
+
+TextureCache::~TextureCache() {
+    if (backing_) std::fclose(backing_);
+}
+
+uint32_t TextureCache::Store(const void* data, size_t tile_bytes, uint32_t count) {
+    uint32_t first;
+    uint64_t offset;
+    {
+        std::lock_guard<std::mutex> lock(store_mutex_);
+        first = tile_count_;
+        offset = tile_offsets_.back();
+        tile_count_ += count;
+        for (uint32_t i = 0; i < count; ++i) {
+            tile_offsets_.push_back(tile_offsets_.back() + tile_bytes);
+        }
+    }
+
+    // Each caller owns its own byte range, so the writes themselves need no lock
+    const size_t bytes = tile_bytes * count;
+    const char* src = static_cast<const char*>(data);
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t n = pwrite(fileno(backing_), src + done, bytes - done,
+                           static_cast<off_t>(offset + done));
+        if (n <= 0) throw std::runtime_error("Failed to write texture cache scratch file");
+        done += static_cast<size_t>(n);
+    }
+    return first;
+}
+
+const uint8_t* TextureCache::Fetch(uint32_t tile_id) const {
+    // Switching caches (a new scene, or a worker moving between cached ones) drops the old
+    // cache's tiles, which may be all that keeps them alive once that cache is gone
+    if (t_slots_owner != uid_) {
+        ReleaseThreadTiles();
+        t_slots_owner = uid_;
+    }
+    TileSlot& slot = t_slots[tile_id % kThreadSlots];
+    if (slot.tile_id != tile_id) {
+        slot.tile = Acquire(tile_id);
+        slot.tile_id = tile_id;
+    }
+    return reinterpret_cast<const uint8_t*>(slot.tile.get());
+}
+
+void TextureCache::ReleaseThreadTiles() {
+    for (TileSlot& slot : t_slots) slot = TileSlot();
+    t_slots_owner = UINT64_MAX;
+}
+
+TextureCache::TilePtr TextureCache::Acquire(uint32_t tile_id) const {
+    Shard& shard = shards_[tile_id % kShardCount];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(tile_id);
+        if (it != shard.entries.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_pos);
+            return it->second.tile;
+        }
+    }
+
+    // Page in without holding the lock; if another thread raced us, keep its copy
+    TilePtr tile = ReadTile(tile_id);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.entries.try_emplace(tile_id);
+    if (!inserted) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_pos);
+        return it->second.tile;
+    }
+    const size_t tile_bytes = tile_offsets_[tile_id + 1] - tile_offsets_[tile_id];
+    shard.lru.push_front(tile_id);
+    it->second.tile = tile;
+    it->second.bytes = tile_bytes;
+    it->second.lru_pos = shard.lru.begin();
+    shard.bytes += tile_bytes;
+
+    while (shard.bytes > shard_budget_ && shard.lru.size() > 1) {
+        auto victim = shard.entries.find(shard.lru.back());
+        shard.bytes -= victim->second.bytes;
+        shard.entries.erase(victim);
+        shard.lru.pop_back();
+    }
+    return tile;
+}
+
+TextureCache::TilePtr TextureCache::ReadTile(uint32_t tile_id) const {
+    const uint64_t offset = tile_offsets_[tile_id];
+    const size_t bytes = tile_offsets_[tile_id + 1] - offset;
+    std::shared_ptr<uint32_t[]> tile = std::make_shared<uint32_t[]>(bytes / 4);
+    char* dst = reinterpret_cast<char*>(tile.get());
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t n = pread(fileno(backing_), dst + done, bytes - done,
+                          static_cast<off_t>(offset + done));
+        if (n <= 0) break;
+        done += static_cast<size_t>(n);
+    }
+    if (done < bytes) {
+        // Render threads cannot throw; the tile decodes as zeros (black) instead
+        std::cerr << "[Texture] Failed to page in tile " << tile_id << "\n";
+    }
+    return tile;
+}
+
+}  // namespace skwr
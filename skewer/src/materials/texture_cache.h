@@ -0,0 +1,90 @@
+#ifndef SKWR_MATERIALS_TEXTURE_CACHE_H_
+#define SKWR_MATERIALS_TEXTURE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace skwr {
+
+constexpr int kTextureTileSize = 64;  // Texels per tile edge (power of two)
+constexpr int kTextureTileShift = 6;  // log2(kTextureTileSize)
+constexpr int kTextureTileTexels = kTextureTileSize * kTextureTileSize;
+
+// Out-of-core backing store for texture tiles: square blocks of encoded texels whose size
+// depends on the owning texture's format (see TexelFormat). Tiles are written once to an
+// anonymous scratch file at load time and paged back in on first touch; resident tiles are kept
+// in sharded LRU lists and evicted once the cache holds more than its byte budget.
+//
+// Lookups go through a small per-thread table of tile pointers first, so the shard locks are
+// only taken on a miss in that table. Tiles are reference counted: an evicted tile stays alive
+// while a thread's table still points at it, so the resident size can exceed the budget by at
+// most that table's size per thread that is rendering. A thread's table only ever holds tiles of
+// the last cache it fetched from, and render threads empty it when they run out of work (see
+// ReleaseThreadTiles), so idle pool threads pin nothing.
+class TextureCache {
+  public:
+    explicit TextureCache(size_t budget_bytes);
+    ~TextureCache();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Appends count tiles of tile_bytes each (a multiple of 4) to the backing store and returns
+    // the id of the first one; the rest follow consecutively. Safe to call from several loader
+    // threads.
+    uint32_t Store(const void* data, size_t tile_bytes, uint32_t count);
+
+    // Returns the tile with the given id, paging it in if needed. The data is 4-byte aligned and
+    // stays valid until the calling thread's next Fetch.
+    const uint8_t* Fetch(uint32_t tile_id) const;
+
+    // Empties the calling thread's table, freeing any tiles only it was keeping alive. Pointers
+    // from earlier Fetch calls on this thread are invalid afterwards.
+    static void ReleaseThreadTiles();
+
+    size_t budget_bytes() const { return budget_bytes_; }
+    uint32_t TileCount() const { return tile_count_; }
+
+  private:
+    static constexpr int kShardCount = 16;
+
+    using TilePtr = std::shared_ptr<const uint32_t[]>;
+
+    struct Entry {
+        TilePtr tile;
+        size_t bytes = 0;
+        std::list<uint32_t>::iterator lru_pos;
+    };
+
+    // A slice of the resident set; tile ids map to shards round-robin
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, Entry> entries;
+        std::list<uint32_t> lru;  // Most recently used at the front
+        size_t bytes = 0;
+    };
+
+    TilePtr Acquire(uint32_t tile_id) const;
+    TilePtr ReadTile(uint32_t tile_id) const;
+
+    size_t budget_bytes_;
+    size_t shard_budget_;
+    uint64_t uid_;  // Identifies the cache that owns a thread's table
+
+    std::FILE* backing_ = nullptr;
+    std::mutex store_mutex_;
+    uint32_t tile_count_ = 0;
+    std::vector<uint64_t> tile_offsets_;  // Byte offset of every tile, plus the end of the file
+
+    mutable Shard shards_[kShardCount];
+};
+
+}  // namespace skwr
+
+#endif  // SKWR_MATERIALS_TEXTURE_CACHE_H_
@@ -3,6 +3,9 @@
 
 #include <cmath>
 
+#include "core/color.h"
+#include "core/kernel_inline.h"
+#include "core/ray.h"
 #include "core/spectral/spectral_curve.h"
 #include "core/spectral/spectral_utils.h"
 #include "core/vec3.h"
@@ -20,10 +23,55 @@ struct ShadingData {
     Vec3 n_shading;        // Shading normal (may be perturbed by normal map)
 };
 
+// Where the differential rays cross the tangent plane at the hit, relative to si.point.
+// Returns false when either offset ray runs parallel to the surface.
+SKWR_KERNEL_INLINE bool ComputeSurfaceDifferentials(const RayDifferential& d,
+                                                    const SurfaceInteraction& si, Vec3* dpdx,
+                                                    Vec3* dpdy) {
+    const Vec3& n = si.n_geom;
+    const float plane = Dot(n, si.point);
+    const float nx = Dot(n, d.rx_direction);
+    const float ny = Dot(n, d.ry_direction);
+    if (std::abs(nx) < 1e-8f || std::abs(ny) < 1e-8f) return false;
+
+    const float tx = (plane - Dot(n, d.rx_origin)) / nx;
+    const float ty = (plane - Dot(n, d.ry_origin)) / ny;
+    *dpdx = d.rx_origin + tx * d.rx_direction - si.point;
+    *dpdy = d.ry_origin + ty * d.ry_direction - si.point;
+    return true;
+}
+
+// Solves dp/dx = dp/du * du/dx + dp/dv * dv/dx (and the same for y) in the two coordinates
+// where the surface is least foreshortened. Needs si.dpdu / si.dpdv, i.e. a textured material.
+SKWR_KERNEL_INLINE UVDifferentials ComputeUVDifferentials(const SurfaceInteraction& si,
+                                                          const Vec3& dpdx, const Vec3& dpdy) {
+    const Vec3& n = si.n_geom;
+    int a = 0, b = 1;
+    if (std::abs(n.x()) > std::abs(n.y()) && std::abs(n.x()) > std::abs(n.z())) {
+        a = 1;
+        b = 2;
+    } else if (std::abs(n.y()) > std::abs(n.z())) {
+        a = 0;
+        b = 2;
+    }
+
+    UVDifferentials duv;
+    const float det = si.dpdu[a] * si.dpdv[b] - si.dpdv[a] * si.dpdu[b];
+    if (std::abs(det) < 1e-12f) return duv;
+    const float inv_det = 1.0f / det;
+    duv.dudx = (si.dpdv[b] * dpdx[a] - si.dpdv[a] * dpdx[b]) * inv_det;
+    duv.dvdx = (si.dpdu[a] * dpdx[b] - si.dpdu[b] * dpdx[a]) * inv_det;
+    duv.dudy = (si.dpdv[b] * dpdy[a] - si.dpdv[a] * dpdy[b]) * inv_det;
+    duv.dvdy = (si.dpdu[a] * dpdy[b] - si.dpdu[b] * dpdy[a]) * inv_det;
+    return duv;
+}
+
 // Resolve per-hit shading data for the given material and surface interaction.
-// Uses si.uv, si.dpdu, si.dpdv for texture lookup and normal-map transform.
-inline ShadingData ResolveShadingData(const Material& mat, const SurfaceInteraction& si,
-                                      const Scene& scene) {
+// Uses si.uv, si.dpdu, si.dpdv for texture lookup and normal-map transform; duv picks the MIP
+// level (the default selects the finest).
+SKWR_KERNEL_INLINE ShadingData ResolveShadingData(const Material& mat, const SurfaceInteraction& si,
+                                                  const Scene& scene,
+                                                  const UVDifferentials& duv = {}) {
     ShadingData sd;
     sd.albedo = mat.albedo;
     sd.roughness = mat.roughness;
@@ -37,20 +85,22 @@ inline ShadingData ResolveShadingData(const Material& mat, const SurfaceInteract
     float v = si.uv.y();
 
     // Albedo texture overrides flat material color.
+    // Coefficient textures were converted at load; plain ones go through rgb2spec per hit
     if (mat.HasAlbedoTexture()) {
-        RGB color = scene.GetTexture(mat.albedo_tex).Sample(u, v);
-        sd.albedo = RGBToCurve(color);
+        const ImageTexture& tex = scene.GetTexture(mat.albedo_tex);
+        sd.albedo =
+            tex.IsSpectral() ? tex.SampleCurve(u, v, duv) : RGBToCurve(tex.Sample(u, v, duv));
     }
 
     // Roughness texture overrides flat roughness value.
     if (mat.HasRoughnessMap()) {
-        RGB color = scene.GetTexture(mat.roughness_tex).Sample(u, v);
+        RGB color = scene.GetTexture(mat.roughness_tex).Sample(u, v, duv);
         sd.roughness = color.r();
     }
 
     // Normal map: perturb shading normal via TBN transform.
     if (mat.HasNormalMap()) {
-        RGB color = scene.GetTexture(mat.normal_tex).Sample(u, v);
+        RGB color = scene.GetTexture(mat.normal_tex).Sample(u, v, duv);
 
         // Convert [0,1] -> [-1,1] tangent-space normal
         Vec3 n_ts(2.0f * color.r() - 1.0f, 2.0f * color.g() - 1.0f, 2.0f * color.b() - 1.0f);
@@ -72,6 +122,16 @@ inline ShadingData ResolveShadingData(const Material& mat, const SurfaceInteract
     return sd;
 }
 
+// Linear RGB reflectance at the hit, for the albedo AOV. Mirrors the albedo choice made by
+// ResolveShadingData but skips the spectral round trip (coefficient textures have to make it).
+SKWR_KERNEL_INLINE RGB ResolveAlbedoRGB(const Material& mat, const SurfaceInteraction& si,
+                                        const Scene& scene, const UVDifferentials& duv = {}) {
+    if (!mat.HasAlbedoTexture()) return mat.albedo_rgb;
+    const ImageTexture& tex = scene.GetTexture(mat.albedo_tex);
+    if (tex.IsSpectral()) return CurveToRGB(tex.SampleCurve(si.uv.x(), si.uv.y(), duv));
+    return ToLinear(tex.Sample(si.uv.x(), si.uv.y(), duv));
+}
+
 }  // namespace skwr
 
 #endif  // SKWR_MATERIALS_TEXTURE_LOOKUP_H_
@@ -0,0 +1,50 @@
+#include "scene/animation.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace skwr {
+
+// The keys either side of frame and how far frame is from the first towards the second
+template <typename Key>
+static void BracketKeys(const std::vector<Key>& keys, int frame, const Key** a, const Key** b,
+                        float* t) {
+    auto next = std::upper_bound(keys.begin(), keys.end(), frame,
+                                 [](int f, const Key& key) { return f < key.frame; });
+    if (next == keys.begin() || next == keys.end()) {
+        *a = *b = (next == keys.begin()) ? &keys.front() : &keys.back();
+        *t = 0.0f;
+        return;
+    }
+    *a = &*(next - 1);
+    *b = &*next;
+    *t = static_cast<float>(frame - (*a)->frame) / static_cast<float>((*b)->frame - (*a)->frame);
+}
+
+static Vec3 Lerp(const Vec3& a, const Vec3& b, float t) { return a + (b - a) * t; }
+
+CameraKey CameraAt(const AnimationConfig& animation, const CameraKey& still, int frame) {
+    if (animation.camera.empty()) return still;
+
+    const CameraKey *a, *b;
+    float t;
+    BracketKeys(animation.camera, frame, &a, &b, &t);
+    CameraKey pose;
+    pose.frame = frame;
+    pose.look_from = Lerp(a->look_from, b->look_from, t);
+    pose.look_at = Lerp(a->look_at, b->look_at, t);
+    pose.vfov = a->vfov + (b->vfov - a->vfov) * t;
+    return pose;
+}
+
+Affine3 MotionAt(const std::vector<MotionKey>& keys, int frame) {
+    if (keys.empty()) return Affine3{};
+
+    const MotionKey *a, *b;
+    float t;
+    BracketKeys(keys, frame, &a, &b, &t);
+    return Affine3::FromSRT(Lerp(a->translate, b->translate, t), Lerp(a->rotate, b->rotate, t),
+                            Lerp(a->scale, b->scale, t));
+}
+
+}  // namespace skwr
@@ -0,0 +1,47 @@
+#ifndef SKWR_SCENE_ANIMATION_H_
+#define SKWR_SCENE_ANIMATION_H_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "core/transform.h"
+#include "core/vec3.h"
+
+namespace skwr {
+
+// Keyframes: frames between two keys interpolate linearly, frames outside the keys hold the
+// nearest one. Key lists are sorted by frame.
+
+struct CameraKey {
+    int frame = 0;
+    Vec3 look_from;
+    Vec3 look_at;
+    float vfov = 90.0f;
+};
+
+// Motion of an object, applied on top of its placement in the scene file (world space)
+struct MotionKey {
+    int frame = 0;
+    Vec3 translate = Vec3(0.0f, 0.0f, 0.0f);
+    Vec3 rotate = Vec3(0.0f, 0.0f, 0.0f);  // Degrees
+    Vec3 scale = Vec3(1.0f, 1.0f, 1.0f);
+};
+
+// A frame sequence: frames [frame_start, frame_start + frame_count) of one scene
+struct AnimationConfig {
+    int frame_start = 0;
+    int frame_count = 0;  // 0 = a still
+    std::vector<CameraKey> camera;
+    std::map<uint32_t, std::vector<MotionKey>> objects;  // By object id
+};
+
+// The camera at frame; still when there are no camera keys
+CameraKey CameraAt(const AnimationConfig& animation, const CameraKey& still, int frame);
+
+// The object's motion transform at frame (Scale -> Rotate -> Translate, like FromSRT)
+Affine3 MotionAt(const std::vector<MotionKey>& keys, int frame);
+
+}  // namespace skwr
+
+#endif  // SKWR_SCENE_ANIMATION_H_
@@ -40,6 +40,19 @@ class Camera {
                    Normalize(lower_left_corner_ + (horizontal_ * s) + (vertical_ * t) - origin_));
     }
 
+    // Offset rays for the pixel one step (ds, dt) away in each direction, for texture filtering
+    RayDifferential GetRayDifferential(float s, float t, float ds, float dt) const {
+        Ray rx = GetRay(s + ds, t);
+        Ray ry = GetRay(s, t + dt);
+        RayDifferential d;
+        d.rx_origin = rx.origin();
+        d.rx_direction = rx.direction();
+        d.ry_origin = ry.origin();
+        d.ry_direction = ry.direction();
+        d.valid = true;
+        return d;
+    }
+
     Vec3 GetW() const { return w_; }
 
   private:
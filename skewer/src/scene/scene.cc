@@ -1,16 +1,23 @@
 #include "scene/scene.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "accelerators/bvh.h"
+#include "core/parallel.h"
+#include "core/transform.h"
 #include "core/vec3.h"
-#include "geometry/intersect_sphere.h"
-#include "geometry/intersect_triangle.h"
+#include "geometry/boundbox.h"
 #include "geometry/mesh.h"
 #include "geometry/sphere.h"
 #include "geometry/triangle.h"
 #include "materials/material.h"
-#include "scene/surface_interaction.h"
 
 namespace skwr {
 
@@ -30,23 +37,72 @@ void Scene::Build() {
         }
     }
 
-    // Bake one Triangle per mesh face, capturing final vertex positions,
-    // edges, normals, and material_id from the fully-prepared Mesh objects.
-    for (uint32_t mesh_id = 0; mesh_id < (uint32_t)meshes_.size(); ++mesh_id) {
-        const Mesh& mesh_ref = meshes_[mesh_id];
+    FlattenEmissiveInstances();
+    BakeTriangles(meshes_, &triangles_);
+
+    if (!triangles_.empty()) {
+        std::cout << "Building BVH for " << triangles_.size() << " triangles...\n";
+        bvh_.Build(triangles_);
+    }
+    BuildInstances();
+
+    for (uint32_t i = 0; i < (uint32_t)triangles_.size(); ++i) {
+        const Material& mat = materials_[triangles_[i].material_id];
+        if (mat.IsEmissive()) {
+            AreaLight light;
+            light.type = AreaLight::Triangle;
+            light.primitive_index = i;
+            light.emission = mat.emission;
+            lights_.push_back(light);
+        }
+    }
+    inv_light_count_ = 1.0f / lights_.size();
+
+    FinishTextureLoads();
+}
+
+// Bake one Triangle per mesh face, capturing final vertex positions,
+// edges, normals, and material_id from the fully-prepared Mesh objects.
+void Scene::BakeTriangles(const std::vector<Mesh>& meshes,
+                          std::vector<Triangle>* triangles) const {
+    // Exclusive prefix sum over face counts gives every mesh its slot range up front, so chunks
+    // of faces can be baked in parallel straight into place, in the same order as a serial bake
+    std::vector<size_t> first_triangle(meshes.size() + 1, 0);
+    for (size_t m = 0; m < meshes.size(); ++m) {
+        first_triangle[m + 1] = first_triangle[m] + meshes[m].indices.size() / 3;
+    }
+    triangles->resize(first_triangle.back());
+
+    struct BakeRange {
+        uint32_t mesh_id;
+        size_t begin, end;  // Faces of the mesh
+    };
+    constexpr size_t kFacesPerRange = 16384;
+    std::vector<BakeRange> ranges;
+    for (uint32_t mesh_id = 0; mesh_id < (uint32_t)meshes.size(); ++mesh_id) {
+        const size_t faces = first_triangle[mesh_id + 1] - first_triangle[mesh_id];
+        for (size_t f = 0; f < faces; f += kFacesPerRange) {
+            ranges.push_back({mesh_id, f, std::min(faces, f + kFacesPerRange)});
+        }
+    }
+
+    ParallelFor(static_cast<int>(ranges.size()), load_threads_, [&](int r) {
+        const BakeRange& range = ranges[r];
+        const Mesh& mesh_ref = meshes[range.mesh_id];
         const Material& mat = materials_[mesh_ref.material_id];
 
-        for (size_t i = 0; i < mesh_ref.indices.size(); i += 3) {
-            uint32_t i0 = mesh_ref.indices[i];
-            uint32_t i1 = mesh_ref.indices[i + 1];
-            uint32_t i2 = mesh_ref.indices[i + 2];
+        for (size_t face = range.begin; face < range.end; ++face) {
+            uint32_t i0 = mesh_ref.indices[3 * face];
+            uint32_t i1 = mesh_ref.indices[3 * face + 1];
+            uint32_t i2 = mesh_ref.indices[3 * face + 2];
 
-            Triangle t;
+            Triangle& t = (*triangles)[first_triangle[range.mesh_id] + face];
             t.p0 = mesh_ref.p[i0];
             t.e1 = mesh_ref.p[i1] - t.p0;
             t.e2 = mesh_ref.p[i2] - t.p0;
             t.material_id = mesh_ref.material_id;
-            t.needs_tangent_frame = mat.HasNormalMap();
+            t.object_id = mesh_ref.object_id;
+            t.needs_tangent_frame = mat.HasAnyTexture();
 
             if (!mesh_ref.n.empty()) {
                 t.n0 = mesh_ref.n[i0];
@@ -64,85 +120,132 @@ void Scene::Build() {
             } else {
                 t.uv0 = t.uv1 = t.uv2 = Vec3(0.0f, 0.0f, 0.0f);
             }
-
-            triangles_.push_back(t);
         }
-    }
+    });
+}
 
-    if (!triangles_.empty()) {
-        std::cout << "Building BVH for " << triangles_.size() << " triangles...\n";
-        bvh_.Build(triangles_);
+// Lights are sampled from world-space triangles, so every placement of a prototype that emits
+// becomes an ordinary mesh
+void Scene::FlattenEmissiveInstances() {
+    std::vector<bool> emissive(prototypes_.size(), false);
+    for (size_t p = 0; p < prototypes_.size(); ++p) {
+        for (const Mesh& mesh : prototypes_[p].meshes) {
+            if (materials_[mesh.material_id].IsEmissive()) emissive[p] = true;
+        }
     }
 
-    for (uint32_t i = 0; i < (uint32_t)triangles_.size(); ++i) {
-        const Material& mat = materials_[triangles_[i].material_id];
-        if (mat.IsEmissive()) {
-            AreaLight light;
-            light.type = AreaLight::Triangle;
-            light.primitive_index = i;
-            light.emission = mat.emission;
-            lights_.push_back(light);
+    std::vector<Instance> kept;
+    for (const Instance& inst : instances_) {
+        if (!emissive[inst.prototype_id]) {
+            kept.push_back(inst);
+            continue;
+        }
+        for (const Mesh& src : prototypes_[inst.prototype_id].meshes) {
+            Mesh mesh = src;
+            mesh.object_id = inst.object_id;
+            for (Vec3& p : mesh.p) p = inst.to_world.Point(p);
+            for (Vec3& n : mesh.n) n = Normalize(inst.to_object.TransposedVector(n));
+            meshes_.push_back(std::move(mesh));
         }
     }
-    inv_light_count_ = 1.0f / lights_.size();
+    instances_ = std::move(kept);
 }
 
-bool Scene::Intersect(const Ray& r, float t_min, float t_max, SurfaceInteraction* si) const {
-    bool hit_anything = false;
-    float closest_t = t_max;
-    for (const auto& sphere : spheres_) {
-        if (IntersectSphere(r, sphere, t_min, closest_t, si)) {
-            hit_anything = true;
-            closest_t = si->t;
-        }
-    }
+// Bottom-level BVH per placed prototype, then the top-level BVH over the instances
+void Scene::BuildInstances() {
+    std::vector<bool> used(prototypes_.size(), false);
+    for (const Instance& inst : instances_) used[inst.prototype_id] = true;
 
-    if (IntersectBVH(r, t_min, closest_t, si)) {
-        hit_anything = true;
+    size_t prototype_triangles = 0;
+    for (size_t p = 0; p < prototypes_.size(); ++p) {
+        Prototype& proto = prototypes_[p];
+        proto.triangles.clear();
+        if (!used[p]) continue;
+        BakeTriangles(proto.meshes, &proto.triangles);
+        proto.bvh.Build(proto.triangles);
+        prototype_triangles += proto.triangles.size();
     }
 
-    return hit_anything;
+    // Instances of prototypes without triangles never hit anything
+    std::erase_if(instances_, [this](const Instance& inst) {
+        return prototypes_[inst.prototype_id].triangles.empty();
+    });
+    UpdateInstances();
+    if (!instances_.empty()) {
+        std::cout << "Built top-level BVH for " << instances_.size() << " instances of "
+                  << prototype_triangles << " prototype triangles\n";
+    }
 }
 
-bool Scene::IntersectBVH(const Ray& r, float t_min, float t_max, SurfaceInteraction* si) const {
-    if (bvh_.IsEmpty()) return false;
-
-    bool hit_anything = false;
-    float closest_t = t_max;
+void Scene::UpdateInstances() {
+    // World bounds from the eight transformed corners of each prototype's root box
+    std::vector<BoundBox> bounds;
+    bounds.reserve(instances_.size());
+    for (const Instance& inst : instances_) {
+        const BoundBox& local = prototypes_[inst.prototype_id].bvh.GetNodes()[0].bounds;
+        BoundBox world;
+        for (int corner = 0; corner < 8; ++corner) {
+            const Vec3 p((corner & 1) ? local.max().x() : local.min().x(),
+                         (corner & 2) ? local.max().y() : local.min().y(),
+                         (corner & 4) ? local.max().z() : local.min().z());
+            world.Expand(inst.to_world.Point(p));
+        }
+        bounds.push_back(world);
+    }
 
-    const Vec3& inv_dir = r.inv_direction();
-    const int dir_is_neg[3] = {inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0};
+    std::vector<Instance> placed = std::move(instances_);
+    instances_.clear();
+    for (uint32_t i : tlas_.Build(bounds)) instances_.push_back(placed[i]);
+}
 
-    int nodes_to_visit[64];
-    int to_visit_offset = 0;
+void Scene::MakeObjectMovable(uint32_t object_id) {
+    bool has_meshes = false;
+    for (const Mesh& mesh : meshes_) {
+        if (mesh.object_id != object_id) continue;
+        if (materials_[mesh.material_id].IsEmissive()) {
+            throw std::runtime_error("Object " + std::to_string(object_id) +
+                                     " emits light and cannot be animated");
+        }
+        has_meshes = true;
+    }
+    const bool has_instances =
+        std::any_of(instances_.begin(), instances_.end(),
+                    [object_id](const Instance& inst) { return inst.object_id == object_id; });
+    if (!has_meshes && !has_instances) {
+        throw std::runtime_error("Object " + std::to_string(object_id) +
+                                 " has no meshes to animate");
+    }
+    if (!has_meshes) return;  // Already instanced
 
-    nodes_to_visit[0] = 0;
-    while (to_visit_offset >= 0) {
-        int current_node_idx = nodes_to_visit[to_visit_offset--];
-        const BVHNode& node = bvh_.GetNodes()[current_node_idx];
+    std::vector<Mesh> moving;
+    std::vector<Mesh> still;
+    for (Mesh& mesh : meshes_) {
+        (mesh.object_id == object_id ? moving : still).push_back(std::move(mesh));
+    }
+    meshes_ = std::move(still);
+    AddInstance(AddPrototype(std::move(moving)), Affine3{}, object_id);
+}
 
-        if (node.bounds.Intersect(r, t_min, closest_t)) {
-            if (node.tri_count > 0) {
-                for (uint32_t i = 0; i < node.tri_count; ++i) {
-                    const Triangle& tri = triangles_[node.left_first + i];
-                    if (IntersectTriangle(r, tri, t_min, closest_t, si)) {
-                        hit_anything = true;
-                        closest_t = si->t;
-                    }
-                }
-            } else {
-                int axis = node.bounds.LongestAxis();
-                if (dir_is_neg[axis]) {
-                    nodes_to_visit[++to_visit_offset] = node.left_first;
-                    nodes_to_visit[++to_visit_offset] = node.left_first + 1;
-                } else {
-                    nodes_to_visit[++to_visit_offset] = node.left_first + 1;
-                    nodes_to_visit[++to_visit_offset] = node.left_first;
-                }
-            }
-        }
+size_t Scene::SetObjectMotion(uint32_t object_id, const Affine3& motion) {
+    size_t moved = 0;
+    for (Instance& inst : instances_) {
+        if (inst.object_id != object_id) continue;
+        inst.to_world = motion * inst.placement;
+        inst.to_object = inst.to_world.Inverse();
+        moved++;
     }
-    return hit_anything;
+    return moved;
+}
+
+uint32_t Scene::AddPrototype(std::vector<Mesh>&& meshes) {
+    prototypes_.push_back(Prototype{std::move(meshes), {}, {}});
+    return static_cast<uint32_t>(prototypes_.size() - 1);
+}
+
+void Scene::AddInstance(uint32_t prototype_id, const Affine3& object_to_world,
+                        uint32_t object_id) {
+    instances_.push_back(
+        {object_to_world, object_to_world.Inverse(), object_to_world, prototype_id, object_id});
 }
 
 uint32_t Scene::AddSphere(const Sphere& s) {
@@ -165,4 +268,71 @@ uint32_t Scene::AddTexture(ImageTexture&& t) {
     return static_cast<uint32_t>(textures_.size() - 1);
 }
 
+uint32_t Scene::LoadTexture(const std::string& filepath, TextureUsage usage) {
+    if (usage == TextureUsage::Albedo) {
+        usage = spectral_albedo_textures_ ? TextureUsage::SpectralAlbedo : TextureUsage::Color;
+    }
+    const std::string path = std::filesystem::path(filepath).lexically_normal().string();
+    const auto key = std::make_pair(path, usage);
+    auto it = texture_ids_.find(key);
+    if (it != texture_ids_.end()) return it->second;
+
+    // Reserve the slot now; FinishTextureLoads moves the decoded texture into it
+    const uint32_t id = static_cast<uint32_t>(textures_.size());
+    textures_.emplace_back();
+    texture_ids_.emplace(key, id);
+
+    auto job = std::make_unique<PendingTexture>();
+    job->id = id;
+    job->path = path;
+    job->usage = usage;
+    PendingTexture* p = job.get();
+    TextureCache* cache = texture_cache_.get();
+    if (!load_pool_) load_pool_ = std::make_unique<ThreadPool>(load_threads_);
+    load_pool_->Submit([p, cache] { p->loaded = p->texture.Load(p->path, p->usage, cache); });
+    pending_textures_.push_back(std::move(job));
+    return id;
+}
+
+void Scene::FinishTextureLoads() {
+    if (!load_pool_) return;
+    load_pool_->Wait();
+    load_pool_.reset();
+
+    std::vector<bool> failed(textures_.size(), false);
+    bool any_failed = false;
+    for (auto& job : pending_textures_) {
+        if (job->loaded) {
+            textures_[job->id] = std::move(job->texture);
+        } else {
+            failed[job->id] = true;
+            any_failed = true;
+        }
+    }
+    pending_textures_.clear();
+    if (!any_failed) return;
+
+    // Materials fall back to their flat values, as if the map had never been named
+    auto drop = [&](uint32_t& tex) {
+        if (tex != kNoTexture && failed[tex]) tex = kNoTexture;
+    };
+    for (Material& m : materials_) {
+        drop(m.albedo_tex);
+        drop(m.normal_tex);
+        drop(m.roughness_tex);
+    }
+    for (auto& entry : texture_ids_) drop(entry.second);
+}
+
+void Scene::SetTextureCacheBudget(size_t budget_bytes) {
+    if (!textures_.empty()) {
+        throw std::runtime_error("Texture cache budget must be set before textures are loaded");
+    }
+    if (budget_bytes == 0) {
+        texture_cache_.reset();
+        return;
+    }
+    texture_cache_ = std::make_unique<TextureCache>(budget_bytes);
+}
+
 }  // namespace skwr
@@ -3,15 +3,23 @@
 
 #include <sys/types.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "accelerators/bvh.h"
+#include "core/thread_pool.h"
+#include "core/transform.h"
 #include "geometry/mesh.h"
 #include "geometry/sphere.h"
 #include "geometry/triangle.h"
 #include "materials/material.h"
 #include "materials/texture.h"
+#include "materials/texture_cache.h"
 #include "scene/light.h"
 
 namespace skwr {
@@ -29,34 +37,127 @@ class Scene {
     uint32_t AddMesh(Mesh&& m);             // Returns mesh_id (index in the meshes_ vector)
     uint32_t AddTexture(ImageTexture&& t);  // Returns texture_id
 
+    // Geometry placed more than once: the meshes stay in object space under their own BVH, and
+    // each AddInstance places it with its own transform and object id. Returns prototype_id.
+    // Instances of prototypes with emissive materials are flattened into world-space meshes at
+    // Build() time, since lights are sampled from world-space triangles.
+    uint32_t AddPrototype(std::vector<Mesh>&& meshes);
+    void AddInstance(uint32_t prototype_id, const Affine3& object_to_world, uint32_t object_id);
+    size_t InstanceCount() const { return instances_.size(); }
+
+    // Animation. MakeObjectMovable turns an object's meshes into a prototype placed once, so it
+    // can move between renders without its BVH being rebuilt; call it before Build(). The other
+    // meshes keep their order but are renumbered. Throws std::runtime_error if the object has no
+    // meshes or instances, or emits light (lights are baked in world space).
+    void MakeObjectMovable(uint32_t object_id);
+    // Places every instance of the object at motion * (its transform when added) and returns how
+    // many moved. Call UpdateInstances() once the frame's motions are all set.
+    size_t SetObjectMotion(uint32_t object_id, const Affine3& motion);
+    // Rebuilds the top-level BVH over the instances' current placements. Prototype BVHs are
+    // kept, so this costs about as much as there are instances.
+    void UpdateInstances();
+
+    // Queues an image texture for decoding on the loader threads, once per path and usage;
+    // later calls return the same texture_id. TextureUsage::Albedo resolves to SpectralAlbedo or
+    // Color (see SetSpectralAlbedoTextures). The texture is only usable after
+    // FinishTextureLoads, which also resets references to files that failed to load.
+    uint32_t LoadTexture(const std::string& filepath, TextureUsage usage = TextureUsage::Color);
+
+    // Waits for queued textures and moves them into place. Build() calls this once geometry is
+    // done, so decoding overlaps triangle baking and the BVH build.
+    void FinishTextureLoads();
+
+    // Threads used for texture decoding, OBJ conversion and triangle baking (0 = all hardware
+    // threads). Set before anything is loaded.
+    void SetLoadThreads(int num_threads) { load_threads_ = num_threads; }
+    int LoadThreads() const { return load_threads_; }
+
+    // Pages texture tiles through a cache of at most budget_bytes instead of keeping them all
+    // resident; 0 keeps every texture in memory. Must be called before any texture is loaded.
+    void SetTextureCacheBudget(size_t budget_bytes);
+
+    // Converts albedo textures to rgb2spec coefficients at load time (4x the memory of RGBA8)
+    // instead of running RGBToCurve on every albedo lookup. Set before materials load.
+    void SetSpectralAlbedoTextures(bool enable) { spectral_albedo_textures_ = enable; }
+
+    // Objects record deep segments unless turned off here (materials have their own flag)
+    void SetObjectDeep(uint32_t object_id, bool deep) {
+        if (object_id >= object_no_deep_.size()) object_no_deep_.resize(object_id + 1, 0);
+        object_no_deep_[object_id] = deep ? 0 : 1;
+    }
+    bool ObjectHasDeep(uint32_t object_id) const {
+        return object_id >= object_no_deep_.size() || !object_no_deep_[object_id];
+    }
+
     const Material& GetMaterial(uint32_t id) const { return materials_[id]; }
     const ImageTexture& GetTexture(uint32_t id) const { return textures_[id]; }
     const Mesh& GetMesh(uint32_t id) const { return meshes_[id]; }
     Mesh& GetMutableMesh(uint32_t id) { return meshes_[id]; }
     size_t MeshCount() const { return meshes_.size(); }
+    size_t TextureCount() const { return textures_.size(); }
     const std::vector<Sphere>& Spheres() const { return spheres_; }
     const std::vector<Triangle>& Triangles() const { return triangles_; }
     const std::vector<Material>& Materials() const { return materials_; }
     const std::vector<AreaLight>& Lights() const { return lights_; }
     const float& InvLightCount() const { return inv_light_count_; }
 
-    void Build();  // Construct the BVH from the shapes list
+    void Build();  // Construct the BVH from the shapes list and finish texture loads
+
+    // Object-space meshes with their own (bottom-level) BVH
+    struct Prototype {
+        std::vector<Mesh> meshes;
+        std::vector<Triangle> triangles;
+        BVH bvh;
+    };
+
+    struct Instance {
+        Affine3 to_world;
+        Affine3 to_object;
+        Affine3 placement;  // to_world before any SetObjectMotion
+        uint32_t prototype_id;
+        uint32_t object_id;
+    };
 
-    // THE CRITICAL HOT-PATH FUNCTION
-    // The Integrator calls this millions of times.
-    // rn loops through linearly, but when BVH is implemented, should be faster
-    bool Intersect(const Ray& r, float t_min, float t_max, SurfaceInteraction* si) const;
-    bool IntersectBVH(const Ray& r, float t_min, float t_max, SurfaceInteraction* si) const;
+    // What the traversal reads. The hot path itself, IntersectScene, is a free function in
+    // scene/scene_intersect.h so kernel ISA variants can each compile a private copy of it.
+    const BVH& WorldBVH() const { return bvh_; }
+    const BVH& InstanceBVH() const { return tlas_; }
+    const std::vector<Instance>& Instances() const { return instances_; }
+    const Prototype& GetPrototype(uint32_t id) const { return prototypes_[id]; }
 
   private:
+    // A texture decode in flight; owned here so the loader task can write into it
+    struct PendingTexture {
+        uint32_t id;
+        std::string path;
+        TextureUsage usage;
+        ImageTexture texture;
+        bool loaded = false;
+    };
+
+    void BakeTriangles(const std::vector<Mesh>& meshes, std::vector<Triangle>* triangles) const;
+    void FlattenEmissiveInstances();
+    void BuildInstances();
+
     std::vector<Sphere> spheres_;
     std::vector<Material> materials_;
     std::vector<ImageTexture> textures_;
+    std::map<std::pair<std::string, TextureUsage>, uint32_t> texture_ids_;  // By normalised path
+    std::unique_ptr<TextureCache> texture_cache_;
+    bool spectral_albedo_textures_ = false;
     std::vector<Mesh> meshes_;
     std::vector<Triangle> triangles_;
     std::vector<AreaLight> lights_;
     BVH bvh_;
+    std::vector<Prototype> prototypes_;
+    std::vector<Instance> instances_;  // In tlas_ leaf order after Build()
+    BVH tlas_;                         // Top-level BVH over instance world bounds
     float inv_light_count_;
+    std::vector<uint8_t> object_no_deep_;  // By object id; ids past the end have deep on
+
+    int load_threads_ = 0;
+    std::vector<std::unique_ptr<PendingTexture>> pending_textures_;
+    std::unique_ptr<ThreadPool> load_pool_;  // Last: its tasks use the members above
 };
 
 }  // namespace skwr
@@ -0,0 +1,149 @@
+#ifndef SKWR_SCENE_SCENE_INTERSECT_H_
+#define SKWR_SCENE_SCENE_INTERSECT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "accelerators/bvh.h"
+#include "core/kernel_inline.h"
+#include "core/ray.h"
+#include "core/vec3.h"
+#include "geometry/intersect_sphere.h"
+#include "geometry/intersect_triangle.h"
+#include "geometry/triangle.h"
+#include "scene/scene.h"
+#include "scene/surface_interaction.h"
+
+// Traversal lives in a header so every kernel ISA variant (see kernels/render_kernel.cc) compiles
+// its own copy of it instead of calling into a baseline build of scene.cc.
+
+namespace skwr {
+
+// Closest hit against one triangle BVH; used for the world BVH and for instance prototypes
+SKWR_KERNEL_INLINE bool IntersectTriangleBVH(const BVH& bvh, const std::vector<Triangle>& triangles,
+                                             const Ray& r, float t_min, float t_max,
+                                             SurfaceInteraction* si) {
+    if (bvh.IsEmpty()) return false;
+
+    bool hit_anything = false;
+    float closest_t = t_max;
+
+    const Vec3& inv_dir = r.inv_direction();
+    const int dir_is_neg[3] = {inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0};
+
+    int nodes_to_visit[64];
+    int to_visit_offset = 0;
+
+    nodes_to_visit[0] = 0;
+    while (to_visit_offset >= 0) {
+        int current_node_idx = nodes_to_visit[to_visit_offset--];
+        const BVHNode& node = bvh.GetNodes()[current_node_idx];
+
+        if (node.bounds.Intersect(r, t_min, closest_t)) {
+            if (node.tri_count > 0) {
+                for (uint32_t i = 0; i < node.tri_count; ++i) {
+                    const Triangle& tri = triangles[node.left_first + i];
+                    if (IntersectTriangle(r, tri, t_min, closest_t, si)) {
+                        hit_anything = true;
+                        closest_t = si->t;
+                    }
+                }
+            } else {
+                int axis = node.bounds.LongestAxis();
+                if (dir_is_neg[axis]) {
+                    nodes_to_visit[++to_visit_offset] = node.left_first;
+                    nodes_to_visit[++to_visit_offset] = node.left_first + 1;
+                } else {
+                    nodes_to_visit[++to_visit_offset] = node.left_first + 1;
+                    nodes_to_visit[++to_visit_offset] = node.left_first;
+                }
+            }
+        }
+    }
+    return hit_anything;
+}
+
+// Two-level traversal: the top-level BVH finds candidate instances, and each is tested by
+// moving the ray into its object space. The object-space direction is not renormalised, so hit
+// distances stay in world units and t_max carries over between instances.
+SKWR_KERNEL_INLINE bool IntersectInstances(const Scene& scene, const Ray& r, float t_min,
+                                           float t_max, SurfaceInteraction* si) {
+    const BVH& tlas = scene.InstanceBVH();
+    if (tlas.IsEmpty()) return false;
+
+    const std::vector<Scene::Instance>& instances = scene.Instances();
+    const Scene::Instance* hit_instance = nullptr;
+    float closest_t = t_max;
+
+    const Vec3& inv_dir = r.inv_direction();
+    const int dir_is_neg[3] = {inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0};
+
+    int nodes_to_visit[64];
+    int to_visit_offset = 0;
+
+    nodes_to_visit[0] = 0;
+    while (to_visit_offset >= 0) {
+        const BVHNode& node = tlas.GetNodes()[nodes_to_visit[to_visit_offset--]];
+        if (!node.bounds.Intersect(r, t_min, closest_t)) continue;
+
+        if (node.tri_count > 0) {
+            for (uint32_t i = 0; i < node.tri_count; ++i) {
+                const Scene::Instance& inst = instances[node.left_first + i];
+                const Scene::Prototype& proto = scene.GetPrototype(inst.prototype_id);
+                Ray local(inst.to_object.Point(r.origin()), inst.to_object.Vector(r.direction()));
+                if (IntersectTriangleBVH(proto.bvh, proto.triangles, local, t_min, closest_t,
+                                         si)) {
+                    hit_instance = &inst;
+                    closest_t = si->t;
+                }
+            }
+        } else if (dir_is_neg[node.bounds.LongestAxis()]) {
+            nodes_to_visit[++to_visit_offset] = node.left_first;
+            nodes_to_visit[++to_visit_offset] = node.left_first + 1;
+        } else {
+            nodes_to_visit[++to_visit_offset] = node.left_first + 1;
+            nodes_to_visit[++to_visit_offset] = node.left_first;
+        }
+    }
+    if (!hit_instance) return false;
+
+    // Only the closest hit is brought back to world space. Normals go through the inverse
+    // transpose, which keeps their side relative to the ray, so front_face still holds.
+    si->point = r.at(si->t);
+    si->wo = -Normalize(r.direction());
+    si->n_geom = Normalize(hit_instance->to_object.TransposedVector(si->n_geom));
+    si->dpdu = hit_instance->to_world.Vector(si->dpdu);
+    si->dpdv = hit_instance->to_world.Vector(si->dpdv);
+    si->object_id = hit_instance->object_id;
+    return true;
+}
+
+// THE CRITICAL HOT-PATH FUNCTION
+// The Integrator calls this millions of times: closest hit over spheres, the world BVH and
+// instances.
+SKWR_KERNEL_INLINE bool IntersectScene(const Scene& scene, const Ray& r, float t_min,
+                                       float t_max, SurfaceInteraction* si) {
+    bool hit_anything = false;
+    float closest_t = t_max;
+    for (const auto& sphere : scene.Spheres()) {
+        if (IntersectSphere(r, sphere, t_min, closest_t, si)) {
+            hit_anything = true;
+            closest_t = si->t;
+        }
+    }
+
+    if (IntersectTriangleBVH(scene.WorldBVH(), scene.Triangles(), r, t_min, closest_t, si)) {
+        hit_anything = true;
+        closest_t = si->t;
+    }
+
+    if (IntersectInstances(scene, r, t_min, closest_t, si)) {
+        hit_anything = true;
+    }
+
+    return hit_anything;
+}
+
+}  // namespace skwr
+
+#endif  // SKWR_SCENE_SCENE_INTERSECT_H_
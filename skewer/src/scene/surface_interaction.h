@@ -19,6 +19,7 @@ struct SurfaceInteraction {
     float t;          // Distance along ray
     bool front_face;  // Is normal pointing at ray? (Is it the outside face?)
     uint32_t material_id;
+    uint32_t object_id;
 
     // UV and tangent frame
     Vec3 uv;          // Surface UV (z unused)
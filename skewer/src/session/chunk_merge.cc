@@ -0,0 +1,85 @@
+#include "session/chunk_merge.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include "film/film.h"
+#include "film/image_buffer.h"
+#include "io/image_io.h"
+
+namespace skwr {
+
+std::string ChunkFlatPath(const std::string& exr_path) {
+    std::filesystem::path path(exr_path);
+    path.replace_extension(".flat.exr");
+    return path.string();
+}
+
+void MergeChunks(const std::vector<std::string>& chunk_paths, const std::string& ppm_path,
+                 const std::string& exr_path, int num_threads) {
+    if (chunk_paths.empty()) throw std::runtime_error("No chunks to merge");
+
+    std::unique_ptr<Film> film;
+    std::vector<SampleRange> ranges;
+    size_t deep_chunks = 0;
+    for (const std::string& path : chunk_paths) {
+        const ChunkImageBuffer chunk = ImageIO::LoadChunkEXR(ChunkFlatPath(path));
+        const SampleRange& range = chunk.GetRange();
+        if (!ranges.empty() && range.total != ranges.front().total) {
+            throw std::runtime_error(path + " is from a frame of " + std::to_string(range.total) +
+                                     " samples, not " + std::to_string(ranges.front().total));
+        }
+        if (!film) {
+            const FrameWindow& w = chunk.GetFrameWindow();
+            film = std::make_unique<Film>(
+                w.frame_width, w.frame_height,
+                TileBounds{w.x0, w.y0, w.x0 + chunk.GetWidth(), w.y0 + chunk.GetHeight()});
+        }
+        film->AddChunk(chunk);
+        ranges.push_back(range);
+
+        if (std::filesystem::exists(path)) {
+            film->AddDeepChunk(ImageIO::LoadEXR(path));
+            deep_chunks++;
+        }
+        std::clog << "[Merge] " << path << ": samples [" << range.start << ", " << range.end
+                  << ")\n";
+    }
+    if (deep_chunks != 0 && deep_chunks != chunk_paths.size()) {
+        throw std::runtime_error("Only " + std::to_string(deep_chunks) + " of " +
+                                 std::to_string(chunk_paths.size()) + " chunks have deep files");
+    }
+
+    // Overlapping ranges would count their samples twice
+    std::sort(ranges.begin(), ranges.end(),
+              [](const SampleRange& a, const SampleRange& b) { return a.start < b.start; });
+    int merged_samples = 0;
+    int covered_to = 0;
+    for (const SampleRange& range : ranges) {
+        if (range.start < covered_to) {
+            throw std::runtime_error("Chunks overlap at sample " + std::to_string(range.start));
+        }
+        if (range.start > covered_to) {
+            std::cerr << "[Merge] Warning: samples [" << covered_to << ", " << range.start
+                      << ") are missing\n";
+        }
+        merged_samples += range.end - range.start;
+        covered_to = range.end;
+    }
+    if (covered_to < ranges.front().total) {
+        std::cerr << "[Merge] Warning: samples [" << covered_to << ", " << ranges.front().total
+                  << ") are missing\n";
+    }
+
+    film->WriteImage(ppm_path);
+    if (deep_chunks > 0) {
+        ImageIO::SaveEXR(*film->CreateDeepBuffer(merged_samples, num_threads), exr_path);
+    }
+    std::clog << "[Merge] " << chunk_paths.size() << " chunks, " << merged_samples
+              << " samples per pixel\n";
+}
+
+}  // namespace skwr
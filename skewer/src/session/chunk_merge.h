@@ -0,0 +1,24 @@
+#ifndef SKWR_SESSION_CHUNK_MERGE_H_
+#define SKWR_SESSION_CHUNK_MERGE_H_
+
+#include <string>
+#include <vector>
+
+namespace skwr {
+
+// A chunk render is named by its deep EXR path; the flat accumulators are written next to it
+// ("frame.c0.exr" -> "frame.c0.flat.exr"), whether or not the deep file exists
+std::string ChunkFlatPath(const std::string& exr_path);
+
+// Merges chunk renders of one frame into the finished outputs: the colour image as a PPM at
+// ppm_path and, when the chunks have deep files, the deep EXR at exr_path. The chunks' sample
+// ranges must not overlap; ranges missing from the frame only log a warning, and the result is
+// normalised by the samples actually merged. Chunks covering the whole frame give the image of a
+// single-process render (see Film::AddChunk). Throws std::runtime_error on chunks that do not
+// fit together or cannot be read.
+void MergeChunks(const std::vector<std::string>& chunk_paths, const std::string& ppm_path,
+                 const std::string& exr_path, int num_threads = 0);
+
+}  // namespace skwr
+
+#endif  // SKWR_SESSION_CHUNK_MERGE_H_
@@ -3,6 +3,7 @@
 
 #include <string>
 
+#include "core/constants.h"
 #include "core/vec3.h"
 
 namespace skwr {
@@ -12,26 +13,65 @@ enum class IntegratorType {
     Normals,
 };
 
+// Post-render denoiser strength (see film/denoiser.h)
+enum class DenoiseStrength {
+    Off,
+    Low,
+    Medium,
+    High,
+};
+
 struct IntegratorConfig {
     int max_depth;
     int samples_per_pixel;
-    int start_sample;
+    int start_sample;  // Index of the first sample rendered; each sample index seeds its own RNG
+    // Samples per pixel of the whole frame when only [start_sample, start_sample +
+    // samples_per_pixel) is rendered here; 0 = samples_per_pixel. Sizes the ray footprints, so
+    // chunks of a frame trace the same rays as one full render.
+    int total_samples = 0;
     int num_threads = 0;  // 0 = auto-detect (hardware_concurrency)
     bool enable_deep = false;
+    bool enable_aovs = false;  // Albedo / normal / depth / id passes from the first hit
+    bool sort_shading = false;  // Shade each tile's hits grouped by material (same image)
+    // Deep selection: samples whose first hit has deep turned off (per material or object) or
+    // lies outside [deep_min_depth, deep_max_depth] are merged into the far background sample,
+    // or dropped when deep_flatten_excluded is false
+    float deep_min_depth = 0.0f;
+    float deep_max_depth = kInfinity;
+    bool deep_flatten_excluded = true;
     Vec3 cam_w;
 };
 
+// Pixel rectangle [x0, x1) x [y0, y1) of the frame; an empty one stands for the whole frame
+struct CropWindow {
+    int x0 = 0, y0 = 0;
+    int x1 = 0, y1 = 0;
+
+    bool IsEmpty() const { return x1 <= x0 || y1 <= y0; }
+};
+
 struct ImageConfig {
     int width;
     int height;
+    // Region render: only these pixels are traced and stored, and the outputs hold just them
+    // (EXRs with the crop as data window inside the full display window)
+    CropWindow crop;
     std::string outfile;
     std::string exrfile;
+    std::string aovfile;  // Multi-channel EXR with beauty + AOVs (when enable_aovs)
+    std::string chunkfile;  // Flat accumulator EXR of a chunk render (RenderOptions::chunk)
 };
 
 struct RenderOptions {
     ImageConfig image_config;
     IntegratorConfig integrator_config;
     IntegratorType integrator_type;
+    DenoiseStrength denoise = DenoiseStrength::Off;
+    int deep_memory_mb = 0;    // Cap on deep segment memory (0 = grow as needed)
+    bool stream_deep = false;  // Write the deep EXR band by band while rendering
+    // Chunk render: save the un-normalised sums of this sample range (image_config.chunkfile,
+    // plus exrfile with deep) for a later merge, instead of finished images. No denoise or AOVs.
+    bool chunk = false;
 };
 
 }  // namespace skwr
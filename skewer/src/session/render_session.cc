@@ -1,10 +1,18 @@
 #include "session/render_session.h"
 
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "core/spectral/spectral_utils.h"
+#include "core/thread_pool.h"
 #include "core/vec3.h"
+#include "film/denoiser.h"
 #include "film/film.h"
 #include "film/image_buffer.h"
 #include "integrators/integrator.h"
@@ -12,8 +20,11 @@
 #include "integrators/path_trace.h"
 #include "io/image_io.h"
 #include "io/scene_loader.h"
+#include "kernels/cpu_dispatch.h"
+#include "scene/animation.h"
 #include "scene/camera.h"
 #include "scene/scene.h"
+#include "session/chunk_merge.h"
 #include "session/render_options.h"
 
 namespace skwr {
@@ -30,46 +41,147 @@ static std::unique_ptr<Integrator> CreateIntegrator(IntegratorType type) {
     }
 }
 
-RenderSession::RenderSession() { skwr::InitSpectralModel(); }
+struct RenderSession::Sequence {
+    std::shared_ptr<Scene> scene;
+    std::shared_ptr<const PreparedScene> prepared;  // Shares scene
+    RenderOptions options;
+};
+
+// path with tag inserted before the extension of its file name
+static std::string InsertBeforeExtension(const std::string& path, const std::string& tag) {
+    const size_t slash = path.find_last_of("/\\");
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + "." + tag;
+    }
+    return path.substr(0, dot) + "." + tag + path.substr(dot);
+}
+
+std::string ViewPath(const std::string& path, const std::string& view) {
+    return InsertBeforeExtension(path, view);
+}
+
+std::string FramePath(const std::string& path, int frame) {
+    std::string number = std::to_string(frame);
+    if (frame >= 0 && number.size() < 4) number.insert(0, 4 - number.size(), '0');
+    return InsertBeforeExtension(path, number);
+}
+
+// Writes a finished film's outputs; Save() and the background saves of RenderSequence share it
+static void SaveFilm(const Film& film, const RenderOptions& options, bool write_aovs,
+                     const SampleRange& range, int deep_norm_samples) {
+    const int num_threads = options.integrator_config.num_threads;
+    const bool write_deep = options.integrator_config.enable_deep && !options.stream_deep;
+    if (options.chunk) {
+        ImageIO::SaveChunkEXR(*film.CreateChunkBuffer(range), options.image_config.chunkfile);
+        if (write_deep) {
+            std::unique_ptr<DeepImageBuffer> buf = film.CreateDeepBuffer(0, num_threads);
+            ImageIO::SaveEXR(*buf, options.image_config.exrfile, &range);
+        }
+        return;
+    }
+
+    if (!options.image_config.outfile.empty()) film.WriteImage(options.image_config.outfile);
+    if (write_deep) {
+        std::unique_ptr<DeepImageBuffer> buf =
+            film.CreateDeepBuffer(deep_norm_samples, num_threads);
+        ImageIO::SaveEXR(*buf, options.image_config.exrfile);
+    }
+    if (write_aovs) ImageIO::SaveAOVEXR(*film.CreateAOVBuffer(), options.image_config.aovfile);
+}
+
+RenderSession::RenderSession() {
+    skwr::InitSpectralModel();
+    // Pick the kernel ISA variant once, up front
+    skwr::ActiveIsaLevel();
+}
 RenderSession::~RenderSession() = default;
 
 /**
  * Load a scene from a JSON config file.
  * Sets up everything: scene geometry, materials, camera, film, and integrator.
  */
-void RenderSession::LoadSceneFromFile(const std::string& scene_file, int thread_override) {
+void RenderSession::LoadSceneFromFile(const std::string& scene_file, int thread_override,
+                                      const std::function<void(RenderOptions&)>& adjust) {
     std::cout << "[Session] Loading scene from: " << scene_file << "\n";
 
-    // 1. Create scene and load from JSON
-    scene_ = std::make_unique<Scene>();
-    SceneConfig config = LoadSceneFile(scene_file, *scene_);
+    // 1. Load from JSON and build the BVH acceleration structure. The scene stays writable here
+    // (it is not shared with anyone else), so an animation can move its instances.
+    auto scene = std::make_shared<Scene>();
+    auto prepared = std::make_shared<PreparedScene>();
+    prepared->config = LoadSceneFile(scene_file, *scene, thread_override);
+    scene->Build();
+    prepared->scene = scene;
 
-    // 2. Build BVH acceleration structure
-    scene_->Build();
+    // 2. Apply thread override if specified
+    RenderOptions options = prepared->config.render_options;
+    if (thread_override > 0) options.integrator_config.num_threads = thread_override;
+    if (adjust) adjust(options);
 
-    // 3. Apply thread override if specified
-    if (thread_override > 0) {
-        config.render_options.integrator_config.num_threads = thread_override;
+    std::unique_ptr<Sequence> sequence;
+    if (!prepared->config.views.empty() || prepared->config.animation.frame_count > 0) {
+        sequence = std::make_unique<Sequence>(Sequence{scene, prepared, options});
+    }
+    SetScene(std::move(prepared), options);
+    sequence_ = std::move(sequence);
+}
+
+void RenderSession::SetScene(std::shared_ptr<const PreparedScene> prepared,
+                             const RenderOptions& options) {
+    const SceneConfig& config = prepared->config;
+
+    // Checked before anything changes, so a bad crop leaves the session as it was
+    const ImageConfig& image = options.image_config;
+    TileBounds window{0, 0, image.width, image.height};
+    if (!image.crop.IsEmpty()) {
+        const CropWindow& c = image.crop;
+        if (c.x0 < 0 || c.y0 < 0 || c.x1 > image.width || c.y1 > image.height) {
+            throw std::runtime_error("Crop window [" + std::to_string(c.x0) + ", " +
+                                     std::to_string(c.y0) + ", " + std::to_string(c.x1) + ", " +
+                                     std::to_string(c.y1) + "] is outside the " +
+                                     std::to_string(image.width) + "x" +
+                                     std::to_string(image.height) + " frame");
+        }
+        window = {c.x0, c.y0, c.x1, c.y1};
     }
 
-    // 4. Store render options
-    options_ = config.render_options;
+    scene_ = prepared->scene;
 
-    // 5. Create camera (aspect ratio derived from image dimensions)
+    // 3. Store render options. An integrator of the same type is kept, with its threads
+    const bool keep_integrator = integrator_ && options_.integrator_type == options.integrator_type;
+    options_ = options;
+
+    // 4. Create camera (aspect ratio derived from image dimensions)
     float aspect = static_cast<float>(options_.image_config.width) /
                    static_cast<float>(options_.image_config.height);
     camera_ =
         std::make_unique<Camera>(config.look_from, config.look_at, config.vup, config.vfov, aspect);
 
-    // 6. Create film and integrator
-    film_ = std::make_unique<Film>(options_.image_config.width, options_.image_config.height);
-    integrator_ = CreateIntegrator(options_.integrator_type);
+    // 5. Create film and integrator. The denoiser is guided by the AOVs, so it turns them on too
+    // Chunks are summed with other chunks before anything is resolved, so neither applies
+    if (options_.chunk) {
+        options_.integrator_config.enable_aovs = false;
+        options_.denoise = DenoiseStrength::Off;
+    }
+    write_aovs_ = options_.integrator_config.enable_aovs;
+    if (options_.denoise != DenoiseStrength::Off) options_.integrator_config.enable_aovs = true;
+    film_ = std::make_unique<Film>(image.width, image.height, window);
+    if (options_.integrator_config.enable_aovs) film_->EnableAOVs();
+    if (options_.integrator_config.enable_deep) {
+        film_->EnableDeep(static_cast<size_t>(options_.deep_memory_mb) << 20);
+    }
+    if (!keep_integrator) integrator_ = CreateIntegrator(options_.integrator_type);
     // GetW() returns the backward-facing basis vector (look_from - look_at).
     // Negate it so cam_w points forward for correct depth projection.
     options_.integrator_config.cam_w = -camera_->GetW();
 
     std::cout << "[Session] Ready: " << options_.image_config.width << "x"
-              << options_.image_config.height
+              << options_.image_config.height;
+    if (!image.crop.IsEmpty()) {
+        std::cout << " (crop " << film_->width() << "x" << film_->height() << " at "
+                  << window.x0 << "," << window.y0 << ")";
+    }
+    std::cout
               << " | Samples: " << options_.integrator_config.samples_per_pixel
               << " | Max Depth: " << options_.integrator_config.max_depth << "\n";
 }
@@ -85,23 +197,154 @@ void RenderSession::Render() {
 
     std::cout << "[Session] Starting Render...\n";
 
+    const bool stream_deep = options_.integrator_config.enable_deep && options_.stream_deep;
+    if (stream_deep) StartDeepStream();
+
     integrator_->Render(*scene_, *camera_, film_.get(), options_.integrator_config);
 
+    if (stream_deep) FinishDeepStream();
+
     std::cout << "[Session] Render Complete.\n";
+
+    if (options_.denoise != DenoiseStrength::Off) {
+        std::cout << "[Session] Denoising (" << DenoiseStrengthName(options_.denoise) << ")...\n";
+        Denoise(film_.get(), options_.denoise, options_.integrator_config.num_threads);
+    }
 }
 
 /**
  * Convert film to image or deep buffer
  */
 void RenderSession::Save() const {
-    if (film_) {
-        film_->WriteImage(options_.image_config.outfile);
-        if (options_.integrator_config.enable_deep) {
-            std::unique_ptr<DeepImageBuffer> buf =
-                film_->CreateDeepBuffer(options_.integrator_config.samples_per_pixel);
-            ImageIO::SaveEXR(*buf, options_.image_config.exrfile);
+    if (film_) SaveFilm(*film_, options_, write_aovs_, ChunkRange(), DeepNormSamples());
+}
+
+void RenderSession::RenderSequence() {
+    if (!sequence_) {
+        std::cerr << "[Error] No camera list or animation loaded.\n";
+        return;
+    }
+
+    const SceneConfig& config = sequence_->prepared->config;
+    const AnimationConfig& animation = config.animation;
+    const bool animated = animation.frame_count > 0;
+    const CameraKey still{0, config.look_from, config.look_at, config.vfov};
+    if (!save_pool_) save_pool_ = std::make_unique<ThreadPool>(1);
+
+    // A still is one frame, and the single camera one unnamed view
+    for (int i = 0; i < (animated ? animation.frame_count : 1); ++i) {
+        const int frame = animation.frame_start + i;
+
+        if (animated) {
+            // Per-frame deltas: move the animated instances, then rebuild the top-level BVH
+            const auto setup_start = std::chrono::steady_clock::now();
+            if (!animation.objects.empty()) {
+                for (const auto& [object_id, keys] : animation.objects) {
+                    sequence_->scene->SetObjectMotion(object_id, MotionAt(keys, frame));
+                }
+                sequence_->scene->UpdateInstances();
+            }
+            const std::chrono::duration<double, std::milli> setup =
+                std::chrono::steady_clock::now() - setup_start;
+            std::cout << "[Session] Frame " << frame << " (" << (i + 1) << "/"
+                      << animation.frame_count << "), scene updated in " << setup.count()
+                      << " ms\n";
+        }
+
+        std::vector<ViewConfig> views = config.views;
+        if (views.empty()) {
+            const CameraKey pose = CameraAt(animation, still, frame);
+            ViewConfig view;
+            view.look_from = pose.look_from;
+            view.look_at = pose.look_at;
+            view.vup = config.vup;
+            view.vfov = pose.vfov;
+            views.push_back(view);
         }
+
+        for (const ViewConfig& view : views) {
+            RenderOptions options = sequence_->options;
+            ImageConfig& image = options.image_config;
+            if (!view.name.empty()) {
+                std::cout << "[Session] Camera " << view.name << "\n";
+                auto view_path = [&](const std::string& own, const std::string& path) {
+                    return !own.empty() ? own : path.empty() ? path : ViewPath(path, view.name);
+                };
+                image.outfile = view_path(view.outfile, image.outfile);
+                // A chunk is named by its own deep path, not the view's, so chunks never collide
+                image.exrfile = view_path(options.chunk ? "" : view.exrfile, image.exrfile);
+                image.aovfile = view_path(view.aovfile, image.aovfile);
+            }
+            if (animated) {
+                if (!image.outfile.empty()) image.outfile = FramePath(image.outfile, frame);
+                if (!image.exrfile.empty()) image.exrfile = FramePath(image.exrfile, frame);
+                if (!image.aovfile.empty()) image.aovfile = FramePath(image.aovfile, frame);
+            }
+            // Kept next to the view's and frame's deep file, where --merge looks for it
+            if (options.chunk) image.chunkfile = ChunkFlatPath(image.exrfile);
+            RenderView(view, options);
+        }
+    }
+    save_pool_->Wait();
+}
+
+void RenderSession::RenderView(const ViewConfig& view, const RenderOptions& options) {
+    // SetScene only reads the camera from the config
+    auto prepared = std::make_shared<PreparedScene>();
+    prepared->scene = sequence_->scene;
+    prepared->config.look_from = view.look_from;
+    prepared->config.look_at = view.look_at;
+    prepared->config.vup = view.vup;
+    prepared->config.vfov = view.vfov;
+    SetScene(std::move(prepared), options);
+    Render();
+
+    // The previous save has had this whole render to finish; waiting for it keeps at most two
+    // films alive. This one is written while the next view or frame renders.
+    save_pool_->Wait();
+    std::shared_ptr<const Film> film = std::move(film_);
+    save_pool_->Submit([film, options = options_, write_aovs = write_aovs_, range = ChunkRange(),
+                        norm = DeepNormSamples()] {
+        SaveFilm(*film, options, write_aovs, range, norm);
+    });
+}
+
+SampleRange RenderSession::ChunkRange() const {
+    const IntegratorConfig& c = options_.integrator_config;
+    const int total = c.total_samples > 0 ? c.total_samples : c.samples_per_pixel;
+    return {c.start_sample, c.start_sample + c.samples_per_pixel, total};
+}
+
+int RenderSession::DeepNormSamples() const {
+    return options_.chunk ? 0 : options_.integrator_config.samples_per_pixel;
+}
+
+void RenderSession::StartDeepStream() {
+    std::cout << "[Session] Streaming deep output to " << options_.image_config.exrfile << "\n";
+    const SampleRange range = ChunkRange();
+    const FrameWindow window = film_->frame_window();
+    deep_writer_ = std::make_unique<DeepEXRBandWriter>(
+        options_.image_config.exrfile, film_->width(), film_->height(), Film::kBandHeight,
+        options_.chunk ? &range : nullptr, &window);
+    film_->SetBandCallback([this](int band) { SubmitDeepBand(band); });
+}
+
+void RenderSession::SubmitDeepBand(int band) {
+    // Resolving runs on the rendering thread that finished the band; only the ordered write and
+    // the release are serialised
+    std::unique_ptr<DeepImageBuffer> rows = film_->CreateDeepBand(band, DeepNormSamples());
+    std::lock_guard<std::mutex> lock(deep_writer_mutex_);
+    const int written = deep_writer_->Submit(band, std::move(rows));
+    film_->ReleaseDeepBands(written);
+}
+
+void RenderSession::FinishDeepStream() {
+    // Integrators that bypass MergeTile never complete a band, so whatever is left goes out now
+    for (int band = 0; band < deep_writer_->BandCount(); ++band) {
+        if (!deep_writer_->HasBand(band)) SubmitDeepBand(band);
     }
+    film_->SetBandCallback(nullptr);
+    deep_writer_.reset();  // Closes the file
 }
 
 }  // namespace skwr
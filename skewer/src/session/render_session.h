@@ -1,7 +1,9 @@
 #ifndef SKWR_SESSION_RENDER_SESSION_H_
 #define SKWR_SESSION_RENDER_SESSION_H_
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "film/film.h"
@@ -11,7 +13,9 @@
  * The entry point to the engine
  * Orchestrates Scene + Integrator + Film
  *
- * Scenes are loaded from JSON config files via LoadSceneFromFile().
+ * Scenes are loaded from JSON config files via LoadSceneFromFile(), or handed over already built
+ * via SetScene() so one scene can serve many renders (see apps/worker). Scene files with several
+ * cameras or an "animation" block render all their views and frames with RenderSequence().
  */
 
 namespace skwr {
@@ -21,6 +25,15 @@ class Scene;
 class Camera;
 class Integrator;
 class Film;
+class DeepEXRBandWriter;
+class ThreadPool;
+struct PreparedScene;
+struct ViewConfig;
+
+// path with a view name inserted before its extension: "out.exr", "left" -> "out.left.exr"
+std::string ViewPath(const std::string& path, const std::string& view);
+// path with the frame number inserted before its extension: "out.exr", 7 -> "out.0007.exr"
+std::string FramePath(const std::string& path, int frame);
 
 class RenderSession {
   public:
@@ -30,17 +43,51 @@ class RenderSession {
     // SETUP: Load scene from a JSON config file.
     // Populates scene, camera, film, and integrator from the config.
     // Optional thread_override: if > 0, overrides the thread count from JSON.
-    void LoadSceneFromFile(const std::string& scene_file, int thread_override = 0);
+    // Optional adjust: edits the file's render options (crop, chunk, ...) before anything uses
+    // them, so a sequence renders every view and frame with the edited options.
+    // Throws std::runtime_error if the resulting crop window does not fit in the image.
+    void LoadSceneFromFile(const std::string& scene_file, int thread_override = 0,
+                           const std::function<void(RenderOptions&)>& adjust = nullptr);
+
+    // SETUP: Render a scene that is already loaded and built, with the given options in place of
+    // the ones from its file. Sets up camera, film, and integrator; the scene itself is shared,
+    // never modified. May be called again between renders. Throws std::runtime_error if the
+    // crop window does not fit in the image.
+    void SetScene(std::shared_ptr<const PreparedScene> prepared, const RenderOptions& options);
 
     // EXECUTE: Run the integrator on the scene
     void Render();
 
-    // OUTPUT: Write the rendered image to disk
+    // OUTPUT: Write the rendered image to disk (the flat image is skipped if outfile is empty).
+    // Chunk renders write their accumulators instead (see RenderOptions::chunk).
     void Save() const;
 
+    // SEQUENCE: Whether the scene last loaded by LoadSceneFromFile has a "cameras" list or an
+    // "animation" block, to be rendered with RenderSequence() instead of Render() and Save()
+    bool HasSequence() const { return sequence_ != nullptr; }
+    // Renders and saves every view of every frame, each view to its ViewPath outputs and each
+    // frame to its FramePath ones. The scene is loaded and built once and the views render back
+    // to back against it: per frame only the animated objects' instances move (rebuilding just
+    // the top-level BVH), and the integrator keeps its render threads. Each render's outputs are
+    // written in the background while the next one renders.
+    void RenderSequence();
+
   private:
+    // Renders one camera of the sequence's scene and queues its outputs on the save thread
+    void RenderView(const ViewConfig& view, const RenderOptions& options);
+
+    // Streaming deep output (RenderOptions::stream_deep): each band of scanlines is resolved and
+    // written as soon as its last tile is merged, then its deep bins are freed
+    void StartDeepStream();
+    void SubmitDeepBand(int band);
+    void FinishDeepStream();
+    // The sample range this render covers, recorded in chunk outputs
+    SampleRange ChunkRange() const;
+    // Samples the deep output is divided by: 0 (raw sums) for chunks
+    int DeepNormSamples() const;
+
     // The 'World' (Geometry, Lights, Accelerators)
-    std::unique_ptr<Scene> scene_;
+    std::shared_ptr<const Scene> scene_;
     std::unique_ptr<Camera> camera_;
 
     // The 'Canvas' (Where pixels end up)
@@ -50,6 +97,15 @@ class RenderSession {
     std::unique_ptr<Integrator> integrator_;
 
     RenderOptions options_;
+    bool write_aovs_ = false;  // AOVs can be on just for the denoiser without being saved
+
+    std::unique_ptr<DeepEXRBandWriter> deep_writer_;
+    std::mutex deep_writer_mutex_;
+
+    // The loaded animation; the session owns its scene outright, so it may move instances
+    struct Sequence;
+    std::unique_ptr<Sequence> sequence_;
+    std::unique_ptr<ThreadPool> save_pool_;  // One thread writing finished frames
 };
 
 }  // namespace skwr
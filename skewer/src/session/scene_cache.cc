@@ -0,0 +1,61 @@
+#include "session/scene_cache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace skwr {
+
+uint64_t HashFileContents(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open scene file: " + path);
+    }
+
+    uint64_t hash = 14695981039346656037ull;
+    std::vector<char> buf(1 << 16);
+    while (file.read(buf.data(), static_cast<std::streamsize>(buf.size())) || file.gcount() > 0) {
+        const std::streamsize n = file.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            hash ^= static_cast<unsigned char>(buf[i]);
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+SceneCache::SceneCache(size_t capacity, Loader loader)
+    : capacity_(std::max<size_t>(capacity, 1)), loader_(std::move(loader)) {}
+
+std::shared_ptr<const PreparedScene> SceneCache::Get(const std::string& path) {
+    const uint64_t hash = HashFileContents(path);
+
+    auto it = by_path_.find(path);
+    if (it != by_path_.end() && it->second->hash == hash) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        hits_++;
+        return entries_.front().scene;
+    }
+
+    // Loaded before anything is dropped, so a failed load leaves the cache as it was (a changed
+    // file keeps its stale scene until a reload succeeds)
+    misses_++;
+    if (it != by_path_.end()) std::clog << "[SceneCache] " << path << " changed, reloading\n";
+    std::shared_ptr<const PreparedScene> scene = loader_(path);
+    if (it != by_path_.end()) {
+        entries_.erase(it->second);
+        by_path_.erase(it);
+    } else if (entries_.size() == capacity_) {
+        std::clog << "[SceneCache] Evicting " << entries_.back().path << "\n";
+        by_path_.erase(entries_.back().path);
+        entries_.pop_back();
+    }
+    entries_.push_front({path, hash, scene});
+    by_path_[path] = entries_.begin();
+    return scene;
+}
+
+}  // namespace skwr
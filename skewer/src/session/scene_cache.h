@@ -0,0 +1,55 @@
+#ifndef SKWR_SESSION_SCENE_CACHE_H_
+#define SKWR_SESSION_SCENE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace skwr {
+
+struct PreparedScene;
+
+// FNV-1a hash of a file's bytes. Throws std::runtime_error if the file cannot be read.
+uint64_t HashFileContents(const std::string& path);
+
+// Least-recently-used cache of built scenes, keyed by scene path and the hash of the scene file's
+// contents: a path whose file changed is reloaded, and its stale scene dropped once the reload
+// succeeds. Only the scene file itself is hashed, so edits to the meshes or textures it references
+// go unnoticed until the entry is evicted. Not thread-safe.
+class SceneCache {
+  public:
+    using Loader = std::function<std::shared_ptr<const PreparedScene>(const std::string& path)>;
+
+    // Holds at most capacity scenes (at least one)
+    SceneCache(size_t capacity, Loader loader);
+
+    // The scene for path, from the cache or freshly loaded. Scenes handed out stay alive after
+    // eviction for as long as the caller holds them.
+    std::shared_ptr<const PreparedScene> Get(const std::string& path);
+
+    size_t Size() const { return entries_.size(); }
+    size_t Hits() const { return hits_; }
+    size_t Misses() const { return misses_; }
+
+  private:
+    struct Entry {
+        std::string path;
+        uint64_t hash;
+        std::shared_ptr<const PreparedScene> scene;
+    };
+
+    size_t capacity_;
+    Loader loader_;
+    std::list<Entry> entries_;  // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> by_path_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+}  // namespace skwr
+
+#endif  // SKWR_SESSION_SCENE_CACHE_H_
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "geometry/mesh.h"
+#include "io/asset_bundle.h"
+#include "materials/material.h"
+#include "materials/texture.h"
+#include "scene/scene.h"
+
+namespace skwr {
+
+static ImageTexture MakeTexture(int w, int h) {
+    std::vector<float> pixels;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            pixels.push_back(float(x) / w);
+            pixels.push_back(float(y) / h);
+            pixels.push_back(float((x + y) % 5) / 4.0f);
+        }
+    }
+    ImageTexture tex;
+    tex.Build(pixels, w, h, TexelFormat::RGBA8);
+    return tex;
+}
+
+static Mesh MakeTriangle(uint32_t material_id) {
+    Mesh mesh;
+    mesh.p = {Vec3(0.0f, 0.0f, 0.0f), Vec3(1.0f, 0.0f, 0.0f), Vec3(0.0f, 2.0f, 0.5f)};
+    mesh.uv = {Vec3(0.0f, 0.0f, 0.0f), Vec3(1.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f)};
+    mesh.indices = {0, 1, 2};
+    mesh.material_id = material_id;
+    return mesh;
+}
+
+TEST(AssetBundleTest, RoundTripRemapsIdsAndSamplesMappedTiles) {
+    const std::string path = "test_bundle.skb";
+
+    Scene source;
+    const uint32_t tex_id = source.AddTexture(MakeTexture(100, 70));
+    Material textured{};
+    textured.roughness = 0.25f;
+    textured.albedo_tex = tex_id;
+    source.AddMesh(MakeTriangle(source.AddMaterial(textured)));
+    ASSERT_TRUE(WriteBundle(path, source));
+
+    // A scene that already holds a material and a texture: bundle ids must shift past them
+    Scene target;
+    target.AddTexture(MakeTexture(8, 8));
+    target.AddMaterial(Material{});
+    ASSERT_TRUE(LoadBundle(path, target));
+    std::filesystem::remove(path);  // The mapping stays valid until the texture goes away
+
+    ASSERT_EQ(target.MeshCount(), 1u);
+    const Mesh& mesh = target.GetMesh(0);
+    EXPECT_EQ(mesh.material_id, 1u);
+    EXPECT_TRUE(mesh.n.empty());
+    ASSERT_EQ(mesh.p.size(), 3u);
+    EXPECT_FLOAT_EQ(mesh.p[2].y(), 2.0f);
+    EXPECT_FLOAT_EQ(mesh.uv[1].x(), 1.0f);
+
+    const Material& mat = target.GetMaterial(1);
+    EXPECT_FLOAT_EQ(mat.roughness, 0.25f);
+    ASSERT_EQ(mat.albedo_tex, 1u);
+    EXPECT_EQ(mat.normal_tex, kNoTexture);
+
+    const ImageTexture& original = source.GetTexture(tex_id);
+    const ImageTexture& mapped = target.GetTexture(mat.albedo_tex);
+    EXPECT_NE(mapped.mapped_tiles, nullptr);
+    EXPECT_TRUE(mapped.tiles.empty());
+    ASSERT_EQ(mapped.levels.size(), original.levels.size());
+    UVDifferentials duv;
+    duv.dudx = 0.05f;
+    duv.dvdy = 0.05f;
+    for (float u : {0.1f, 0.55f, 0.93f}) {
+        RGB a = original.Sample(u, 1.0f - u, duv);
+        RGB b = mapped.Sample(u, 1.0f - u, duv);
+        EXPECT_EQ(a.r(), b.r());
+        EXPECT_EQ(a.g(), b.g());
+        EXPECT_EQ(a.b(), b.b());
+    }
+}
+
+TEST(AssetBundleTest, RejectsTruncatedFileWithoutTouchingScene) {
+    const std::string path = "test_bundle_truncated.skb";
+    Scene source;
+    source.AddTexture(MakeTexture(64, 64));
+    source.AddMesh(MakeTriangle(source.AddMaterial(Material{})));
+    ASSERT_TRUE(WriteBundle(path, source));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    Scene target;
+    EXPECT_FALSE(LoadBundle(path, target));
+    EXPECT_EQ(target.MeshCount(), 0u);
+    EXPECT_EQ(target.TextureCount(), 0u);
+    EXPECT_TRUE(target.Materials().empty());
+    std::filesystem::remove(path);
+}
+
+}  // namespace skwr
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "core/rng.h"
+#include "film/denoiser.h"
+#include "film/film.h"
+#include "film/film_tile.h"
+
+namespace skwr {
+
+// Renders a synthetic 64x64 frame: left half albedo 0.2, right half albedo 0.8, flat lighting of
+// 1.0 plus per-sample noise, one object facing the camera at a fixed depth.
+static void FillNoisyFrame(Film* film, int spp) {
+    RNG rng(1234, 0);
+    auto tile = std::make_unique<FilmTile>();
+    for (int i = 0; i < film->TileCount(); ++i) {
+        tile->Reset(film->GetTileBounds(i), true);
+        const TileBounds& b = tile->bounds();
+        for (int y = b.y0; y < b.y1; ++y) {
+            for (int x = b.x0; x < b.x1; ++x) {
+                AOVSample aov;
+                float a = x < film->width() / 2 ? 0.2f : 0.8f;
+                aov.albedo = RGB(a);
+                aov.normal = Vec3(0.0f, 0.0f, 1.0f);
+                aov.depth = 5.0f;
+                aov.object_id = 0;
+                aov.material_id = x < film->width() / 2 ? 0 : 1;
+                for (int s = 0; s < spp; ++s) {
+                    RGB L(a * (0.5f + rng.UniformFloat()));
+                    tile->AddSample(x, y, L);
+                    tile->AddAOVSample(x, y, aov, L);
+                }
+            }
+        }
+        film->MergeTile(*tile);
+    }
+}
+
+// Mean squared error of one half against the expected value of its albedo
+static float HalfError(const std::vector<RGB>& colors, int width, int height, bool left) {
+    float expected = left ? 0.2f : 0.8f;
+    float err = 0.0f;
+    int count = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = left ? 0 : width / 2; x < (left ? width / 2 : width); ++x) {
+            float d = colors[y * width + x].g() - expected;
+            err += d * d;
+            count++;
+        }
+    }
+    return err / count;
+}
+
+TEST(DenoiserTest, ReducesNoiseWithoutBleedingAcrossAlbedoEdges) {
+    Film film(64, 64);
+    film.EnableAOVs();
+    FillNoisyFrame(&film, 4);
+
+    std::vector<RGB> before = film.ResolveColors();
+    Denoise(&film, DenoiseStrength::Medium, 2);
+    std::vector<RGB> after = film.ResolveColors();
+
+    EXPECT_LT(HalfError(after, 64, 64, true), 0.5f * HalfError(before, 64, 64, true));
+    EXPECT_LT(HalfError(after, 64, 64, false), 0.5f * HalfError(before, 64, 64, false));
+
+    // The pixels either side of the edge keep their own albedo's brightness
+    for (int y = 0; y < 64; ++y) {
+        EXPECT_LT(after[y * 64 + 31].g(), 0.35f);
+        EXPECT_GT(after[y * 64 + 32].g(), 0.6f);
+    }
+}
+
+TEST(DenoiserTest, OffLeavesFilmUntouched) {
+    Film film(16, 16);
+    film.EnableAOVs();
+    FillNoisyFrame(&film, 2);
+
+    std::vector<RGB> before = film.ResolveColors();
+    Denoise(&film, DenoiseStrength::Off, 1);
+    std::vector<RGB> after = film.ResolveColors();
+    for (size_t i = 0; i < before.size(); ++i) EXPECT_EQ(before[i].g(), after[i].g());
+}
+
+}  // namespace skwr
@@ -0,0 +1,436 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "film/film.h"
+#include "film/film_tile.h"
+#include "film/image_buffer.h"
+#include "integrators/path_sample.h"
+
+namespace skwr {
+
+TEST(FilmTest, TilesCoverEveryPixelOnce) {
+    // Deliberately not a multiple of the tile size in either direction
+    Film film(FilmTile::kSize * 2 + 5, FilmTile::kSize + 1);
+    std::vector<int> hits(film.width() * film.height(), 0);
+
+    for (int i = 0; i < film.TileCount(); ++i) {
+        TileBounds b = film.GetTileBounds(i);
+        EXPECT_LE(b.x1 - b.x0, FilmTile::kSize);
+        EXPECT_LE(b.y1 - b.y0, FilmTile::kSize);
+        for (int y = b.y0; y < b.y1; ++y) {
+            for (int x = b.x0; x < b.x1; ++x) hits[y * film.width() + x]++;
+        }
+    }
+
+    EXPECT_EQ(film.TileCount(), 3 * 2);
+    for (int h : hits) EXPECT_EQ(h, 1);
+}
+
+TEST(FilmTest, MergeOrderDoesNotChangeResult) {
+    auto render = [](Film* film, bool reverse) {
+        auto tile = std::make_unique<FilmTile>();
+        const int n = film->TileCount();
+        for (int k = 0; k < n; ++k) {
+            int i = reverse ? n - 1 - k : k;
+            tile->Reset(film->GetTileBounds(i));
+            const TileBounds& b = tile->bounds();
+            for (int y = b.y0; y < b.y1; ++y) {
+                for (int x = b.x0; x < b.x1; ++x) {
+                    for (int s = 0; s < 3; ++s) tile->AddSample(x, y, RGB(0.1f * s, x, y));
+                }
+            }
+            film->MergeTile(*tile);
+        }
+    };
+
+    Film forward(40, 40), backward(40, 40);
+    render(&forward, false);
+    render(&backward, true);
+
+    std::vector<RGB> a = forward.ResolveColors();
+    std::vector<RGB> b = backward.ResolveColors();
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].r(), b[i].r());
+        EXPECT_EQ(a[i].g(), b[i].g());
+        EXPECT_EQ(a[i].b(), b[i].b());
+    }
+    EXPECT_FLOAT_EQ(a[0].r(), 0.1f);
+}
+
+TEST(FilmTest, AOVsAverageShadingAndKeepNearestIds) {
+    Film film(4, 4);
+    film.EnableAOVs();
+
+    auto tile = std::make_unique<FilmTile>();
+    tile->Reset(film.GetTileBounds(0), true);
+
+    AOVSample near_hit;
+    near_hit.albedo = RGB(1.0f, 0.0f, 0.0f);
+    near_hit.normal = Vec3(0.0f, 1.0f, 0.0f);
+    near_hit.depth = 2.0f;
+    near_hit.object_id = 7;
+    near_hit.material_id = 3;
+
+    AOVSample far_hit = near_hit;
+    far_hit.albedo = RGB(0.0f, 0.0f, 1.0f);
+    far_hit.depth = 5.0f;
+    far_hit.object_id = 9;
+
+    AOVSample miss;  // defaults describe an escaped ray
+
+    tile->AddSample(1, 2, RGB(0.0f));
+    tile->AddAOVSample(1, 2, far_hit, RGB(0.0f));
+    tile->AddSample(1, 2, RGB(0.0f));
+    tile->AddAOVSample(1, 2, near_hit, RGB(0.0f));
+    tile->AddSample(3, 3, RGB(0.0f));
+    tile->AddAOVSample(3, 3, miss, RGB(0.0f));
+    film.MergeTile(*tile);
+
+    std::unique_ptr<AOVImageBuffer> buf = film.CreateAOVBuffer();
+    const AOVImagePixel& p = buf->GetPixel(1, 2);
+    EXPECT_FLOAT_EQ(p.albedo_r, 0.5f);
+    EXPECT_FLOAT_EQ(p.albedo_b, 0.5f);
+    EXPECT_FLOAT_EQ(p.n_y, 1.0f);
+    EXPECT_FLOAT_EQ(p.z, 2.0f);
+    EXPECT_EQ(p.object_id, 7u);
+    EXPECT_EQ(p.material_id, 3u);
+
+    const AOVImagePixel& bg = buf->GetPixel(3, 3);
+    EXPECT_EQ(bg.object_id, kNoHitId);
+    EXPECT_FLOAT_EQ(bg.albedo_g, 0.0f);
+}
+
+TEST(FilmTest, ChunksMergeIntoTheSingleFilmImage) {
+    // Samples [begin, end) of every pixel, with values whose float sums would round differently
+    // depending on how the range is split
+    auto render = [](Film* film, int begin, int end) {
+        auto tile = std::make_unique<FilmTile>();
+        for (int i = 0; i < film->TileCount(); ++i) {
+            tile->Reset(film->GetTileBounds(i));
+            const TileBounds& b = tile->bounds();
+            for (int y = b.y0; y < b.y1; ++y) {
+                for (int x = b.x0; x < b.x1; ++x) {
+                    for (int s = begin; s < end; ++s) {
+                        tile->AddSample(x, y, RGB(0.1f * s + x, 1e4f / (s + 1), 1.0f / (y + 3)));
+                    }
+                }
+            }
+            film->MergeTile(*tile);
+        }
+    };
+
+    Film full(37, 5);
+    render(&full, 0, 11);
+
+    Film first(37, 5), second(37, 5);
+    render(&first, 0, 4);
+    render(&second, 4, 11);
+    std::unique_ptr<ChunkImageBuffer> a = first.CreateChunkBuffer({0, 4, 11});
+    std::unique_ptr<ChunkImageBuffer> b = second.CreateChunkBuffer({4, 11, 11});
+    EXPECT_EQ(b->GetRange().start, 4);
+    EXPECT_EQ(a->GetPixel(36, 4).sample_count, 4u);
+    EXPECT_DOUBLE_EQ(b->GetPixel(0, 0).weight, 7.0);
+
+    Film merged(37, 5);
+    merged.AddChunk(*b);
+    merged.AddChunk(*a);
+    std::vector<RGB> expected = full.ResolveColors();
+    std::vector<RGB> actual = merged.ResolveColors();
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(actual[i].r(), expected[i].r());
+        EXPECT_EQ(actual[i].g(), expected[i].g());
+        EXPECT_EQ(actual[i].b(), expected[i].b());
+    }
+
+    EXPECT_THROW(merged.AddChunk(ChunkImageBuffer(4, 4, {0, 1, 1})), std::runtime_error);
+}
+
+TEST(FilmTest, CropWindowHoldsOnlyItsPixels) {
+    auto render = [](Film* film) {
+        auto tile = std::make_unique<FilmTile>();
+        for (int i = 0; i < film->TileCount(); ++i) {
+            tile->Reset(film->GetTileBounds(i));
+            const TileBounds& b = tile->bounds();
+            for (int y = b.y0; y < b.y1; ++y) {
+                for (int x = b.x0; x < b.x1; ++x) tile->AddSample(x, y, RGB(x, y, 1.0f));
+            }
+            film->MergeTile(*tile);
+        }
+    };
+
+    Film full(FilmTile::kSize * 2 + 5, FilmTile::kSize + 7);
+    render(&full);
+
+    const TileBounds window{5, 3, FilmTile::kSize + 9, FilmTile::kSize + 6};
+    Film crop(full.width(), full.height(), window);
+    render(&crop);
+    EXPECT_EQ(crop.width(), window.x1 - window.x0);
+    EXPECT_EQ(crop.height(), window.y1 - window.y0);
+    EXPECT_EQ(crop.TileCount(), 2 * 2);
+    EXPECT_EQ(crop.GetTileBounds(0).x0, window.x0);
+    EXPECT_EQ(crop.GetTileBounds(3).y1, window.y1);
+
+    // Samples outside the window are dropped; inside it the pixels match the full render's
+    crop.AddSample(0, 0, RGB(100.0f, 100.0f, 100.0f));
+    std::vector<RGB> expected = full.ResolveColors();
+    std::vector<RGB> actual = crop.ResolveColors();
+    ASSERT_EQ(actual.size(), static_cast<size_t>(crop.width() * crop.height()));
+    for (int y = 0; y < crop.height(); ++y) {
+        for (int x = 0; x < crop.width(); ++x) {
+            const RGB& e = expected[(window.y0 + y) * full.width() + window.x0 + x];
+            const RGB& a = actual[y * crop.width() + x];
+            EXPECT_EQ(a.r(), e.r());
+            EXPECT_EQ(a.g(), e.g());
+        }
+    }
+
+    std::unique_ptr<ChunkImageBuffer> chunk = crop.CreateChunkBuffer({0, 1, 1});
+    const FrameWindow fw = chunk->GetFrameWindow();
+    EXPECT_EQ(fw.frame_width, full.width());
+    EXPECT_EQ(fw.x0, window.x0);
+    EXPECT_EQ(fw.y0, window.y0);
+    EXPECT_THROW(full.AddChunk(*chunk), std::runtime_error);
+}
+
+static PathSample MakeDeepSample(float z, float alpha) {
+    PathSample s;
+    s.segments.push_back(DeepSegment{z, z + 0.01f, RGB(alpha), alpha});
+    return s;
+}
+
+TEST(FilmTest, DeepSegmentsAreSortedByDepth) {
+    Film film(3, 2);
+    EXPECT_FALSE(film.HasDeep());
+    film.EnableDeep();
+    EXPECT_TRUE(film.HasDeep());
+
+    film.AddDeepSample(2, 1, MakeDeepSample(5.0f, 1.0f));
+    film.AddDeepSample(2, 1, MakeDeepSample(1.0f, 1.0f));
+    film.AddDeepSample(2, 1, MakeDeepSample(1.0f, 0.0f));  // Empty, skipped
+
+    std::unique_ptr<DeepImageBuffer> buf = film.CreateDeepBuffer(4);
+    EXPECT_EQ(buf->GetPixel(0, 0).count, 0u);
+    DeepPixelView p = buf->GetPixel(2, 1);
+    ASSERT_EQ(p.count, 2u);
+    EXPECT_FLOAT_EQ(p[0].z_front, 1.0f);
+    EXPECT_FLOAT_EQ(p[0].alpha, 0.25f);
+    EXPECT_FLOAT_EQ(p[1].z_front, 5.0f);
+    EXPECT_FLOAT_EQ(p[1].alpha, 0.25f);
+}
+
+TEST(FilmTest, DeepExportSortsLongListsAndCountsAfterMerging) {
+    Film film(FilmTile::kSize + 3, 3);
+    film.EnableDeep();
+
+    // More bins than the insertion sort handles, added out of order, on every pixel
+    const int depths = 50;
+    for (int y = 0; y < film.height(); ++y) {
+        for (int x = 0; x < film.width(); ++x) {
+            for (int i = 0; i < depths; ++i) {
+                film.AddDeepSample(x, y, MakeDeepSample(float((i * 17) % depths) + 1.0f, 1.0f));
+            }
+        }
+    }
+    // A transparent emitter contributes no coverage and is dropped by the merge, so the count
+    // written for the pixel has to come from the merged list
+    PathSample ghost;
+    ghost.segments.push_back(DeepSegment{100.0f, 100.01f, RGB(1.0f), 0.0f});
+    film.AddDeepSample(1, 1, ghost);
+
+    std::unique_ptr<DeepImageBuffer> buf = film.CreateDeepBuffer(depths, 3);
+    for (int y = 0; y < film.height(); ++y) {
+        for (int x = 0; x < film.width(); ++x) {
+            DeepPixelView p = buf->GetPixel(x, y);
+            ASSERT_EQ(p.count, static_cast<size_t>(depths));
+            for (int i = 0; i < depths; ++i) {
+                EXPECT_FLOAT_EQ(p[i].z_front, float(i) + 1.0f);
+                EXPECT_FLOAT_EQ(p[i].alpha, 1.0f / depths);
+            }
+        }
+    }
+}
+
+TEST(FilmTest, DeepSamplesConsolidateIntoDepthBins) {
+    Film film(1, 1);
+    film.EnableDeep(1);  // One chunk, far fewer nodes than samples
+
+    // Jittered hits on two surfaces, with every sample inside the tolerance of its surface
+    const int n = 2 * DeepSegmentPool::kChunkSize;
+    for (int i = 0; i < n; ++i) {
+        const float jitter = 0.004f * float(i % 7) / 7.0f;
+        film.AddDeepSample(0, 0, MakeDeepSample((i % 4 ? 10.0f : 20.0f) + jitter, 1.0f));
+    }
+
+    std::unique_ptr<DeepImageBuffer> buf = film.CreateDeepBuffer(n);
+    DeepPixelView p = buf->GetPixel(0, 0);
+    ASSERT_EQ(p.count, 2u);
+    EXPECT_NEAR(p[0].z_front, 10.0f, 0.01f);
+    EXPECT_NEAR(p[0].alpha, 0.75f, 1e-4f);
+    EXPECT_NEAR(p[1].z_front, 20.0f, 0.01f);
+    EXPECT_NEAR(p[1].alpha, 0.25f, 1e-4f);
+}
+
+TEST(FilmTest, DeepBinsKeepObjectsApartAndCountTheirSamples) {
+    Film film(1, 1);
+    film.EnableDeep();
+
+    // Two objects touching at the same depth, e.g. an edge shared by two meshes
+    auto sample = [](uint32_t object_id) {
+        PathSample s = MakeDeepSample(10.0f, 1.0f);
+        s.segments[0].object_id = object_id;
+        s.segments[0].material_id = 100 + object_id;
+        return s;
+    };
+    for (int i = 0; i < 3; ++i) film.AddDeepSample(0, 0, sample(1));
+    film.AddDeepSample(0, 0, sample(2));
+
+    std::unique_ptr<DeepImageBuffer> buf = film.CreateDeepBuffer(4);
+    DeepPixelView p = buf->GetPixel(0, 0);
+    ASSERT_EQ(p.count, 2u);
+    const size_t first = p[0].object_id == 1 ? 0 : 1;
+    EXPECT_EQ(p[first].object_id, 1u);
+    EXPECT_EQ(p[first].material_id, 101u);
+    EXPECT_EQ(p[first].sample_count, 3u);
+    EXPECT_FLOAT_EQ(p[first].alpha, 0.75f);
+    EXPECT_EQ(p[1 - first].object_id, 2u);
+    EXPECT_EQ(p[1 - first].sample_count, 1u);
+    EXPECT_FLOAT_EQ(p[1 - first].alpha, 0.25f);
+}
+
+TEST(FilmTest, DeepMemoryCapFoldsIntoExistingBins) {
+    // More pixels than one chunk has nodes
+    Film film(300, 300);
+    film.EnableDeep(1);  // Rounds up to a single chunk
+    const int pixels = film.width() * film.height();
+    ASSERT_GT(pixels, static_cast<int>(DeepSegmentPool::kChunkSize));
+
+    // The second pass is at a depth of its own, so it needs a new bin per pixel
+    for (float z : {1.0f, 2.0f}) {
+        for (int i = 0; i < pixels; ++i) {
+            film.AddDeepSample(i % film.width(), i / film.width(), MakeDeepSample(z, 1.0f));
+        }
+    }
+
+    // Pixels that got a bin before the cap keep both samples; the rest had nothing to fold into
+    std::unique_ptr<DeepImageBuffer> buf = film.CreateDeepBuffer(2);
+    int stored = 0;
+    for (int i = 0; i < pixels; ++i) {
+        DeepPixelView p = buf->GetPixel(i % film.width(), i / film.width());
+        if (p.count == 0) continue;
+        ASSERT_EQ(p.count, 1u);
+        EXPECT_FLOAT_EQ(p[0].alpha, 1.0f);
+        stored++;
+    }
+    // Each band starts a fresh block, so a few nodes per band boundary go unused
+    EXPECT_LE(stored, static_cast<int>(DeepSegmentPool::kChunkSize));
+    EXPECT_GT(stored, static_cast<int>(DeepSegmentPool::kChunkSize -
+                                       film.BandCount() * DeepSegmentPool::kBlockSize));
+}
+
+TEST(FilmTest, DeepBandsResolveAsTheyCompleteAndFreeTheirBins) {
+    Film film(FilmTile::kSize + 7, Film::kBandHeight * 2 + 5);
+    film.EnableDeep();
+    ASSERT_EQ(film.BandCount(), 3);
+
+    std::vector<int> completed;
+    film.SetBandCallback([&](int band) { completed.push_back(band); });
+
+    // Tiles in reverse order, so the bottom band completes first
+    auto tile = std::make_unique<FilmTile>();
+    for (int i = film.TileCount() - 1; i >= 0; --i) {
+        tile->Reset(film.GetTileBounds(i));
+        const TileBounds& b = tile->bounds();
+        for (int y = b.y0; y < b.y1; ++y) {
+            for (int x = b.x0; x < b.x1; ++x) {
+                tile->AddSample(x, y, RGB(1.0f));
+                film.AddDeepSample(x, y, MakeDeepSample(float(y + 1), 1.0f));
+            }
+        }
+        film.MergeTile(*tile);
+    }
+    EXPECT_EQ(completed, (std::vector<int>{2, 1, 0}));
+
+    std::unique_ptr<DeepImageBuffer> whole = film.CreateDeepBuffer(1);
+    std::unique_ptr<DeepImageBuffer> last = film.CreateDeepBand(2, 1);
+    ASSERT_EQ(last->GetHeight(), 5);
+    for (int y = 0; y < last->GetHeight(); ++y) {
+        for (int x = 0; x < film.width(); ++x) {
+            DeepPixelView a = last->GetPixel(x, y);
+            DeepPixelView b = whole->GetPixel(x, y + 2 * Film::kBandHeight);
+            ASSERT_EQ(a.count, 1u);
+            ASSERT_EQ(b.count, 1u);
+            EXPECT_EQ(a[0].z_front, b[0].z_front);
+        }
+    }
+
+    film.ReleaseDeepBands(2);
+    std::unique_ptr<DeepImageBuffer> after = film.CreateDeepBuffer(1);
+    EXPECT_EQ(after->GetPixel(3, Film::kBandHeight).count, 0u);
+    EXPECT_EQ(after->GetPixel(3, 2 * Film::kBandHeight).count, 1u);
+}
+
+TEST(FilmTest, DeepPoolFreesChunksOfReleasedBands) {
+    DeepSegmentPool pool;
+    // Fill three chunks per band for bands 0 and 1, then start band 2
+    const uint32_t per_band = 3 * DeepSegmentPool::kChunkSize;
+    for (int band = 0; band < 2; ++band) {
+        for (uint32_t i = 0; i < per_band; ++i) {
+            const uint32_t n = pool.Allocate(band);
+            ASSERT_NE(n, DeepSegmentPool::kNoNode);
+            pool[n].z_front = float(band);
+        }
+    }
+    const uint32_t later = pool.Allocate(2);
+    const size_t chunk_bytes = DeepSegmentPool::kChunkSize * sizeof(DeepSegmentNode);
+    EXPECT_EQ(pool.ReservedBytes(), 7 * chunk_bytes);
+
+    pool.ReleaseBands(0);
+    EXPECT_EQ(pool.ReservedBytes(), 4 * chunk_bytes);
+    pool.ReleaseBands(1);
+    EXPECT_EQ(pool.ReservedBytes(), chunk_bytes);  // Band 2's chunk stays
+    pool[later].z_front = 2.0f;
+}
+
+TEST(FilmTest, DeepChunksMergeLikeOneRender) {
+    // Four samples: three on a surface at depth 2, one on a surface at depth 5
+    auto render = [](Film* film, int begin, int end) {
+        film->EnableDeep();
+        for (int s = begin; s < end; ++s) {
+            film->AddDeepSample(1, 0, MakeDeepSample(s == 3 ? 5.0f : 2.0f, 1.0f));
+        }
+    };
+
+    Film full(2, 1);
+    render(&full, 0, 4);
+    Film first(2, 1), second(2, 1);
+    render(&first, 0, 2);
+    render(&second, 2, 4);
+
+    // Chunks keep the raw sums
+    std::unique_ptr<DeepImageBuffer> raw = first.CreateDeepBuffer(0);
+    ASSERT_EQ(raw->GetPixel(1, 0).count, 1u);
+    EXPECT_FLOAT_EQ(raw->GetPixel(1, 0)[0].alpha, 2.0f);
+
+    Film merged(2, 1);
+    merged.AddDeepChunk(*raw);
+    merged.AddDeepChunk(*second.CreateDeepBuffer(0));
+    std::unique_ptr<DeepImageBuffer> expected = full.CreateDeepBuffer(4);
+    std::unique_ptr<DeepImageBuffer> actual = merged.CreateDeepBuffer(4);
+    DeepPixelView e = expected->GetPixel(1, 0);
+    DeepPixelView a = actual->GetPixel(1, 0);
+    ASSERT_EQ(a.count, e.count);
+    for (size_t i = 0; i < e.count; ++i) {
+        EXPECT_FLOAT_EQ(a[i].z_front, e[i].z_front);
+        EXPECT_FLOAT_EQ(a[i].alpha, e[i].alpha);
+        EXPECT_FLOAT_EQ(a[i].r, e[i].r);
+        EXPECT_EQ(a[i].sample_count, e[i].sample_count);
+    }
+    EXPECT_FLOAT_EQ(a[0].alpha, 0.75f);
+    EXPECT_EQ(a[0].sample_count, 3u);
+}
+
+}  // namespace skwr
@@ -0,0 +1,282 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "core/spectral/spectral_utils.h"
+#include "core/vec3.h"
+#include "io/gltf_loader.h"
+#include "materials/material.h"
+#include "scene/scene.h"
+
+using json = nlohmann::json;
+
+namespace skwr {
+
+static void WriteFile(const std::string& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary) << contents;
+}
+
+template <typename T>
+static void Append(std::vector<uint8_t>* buf, std::initializer_list<T> values) {
+    for (T v : values) {
+        const size_t at = buf->size();
+        buf->resize(at + sizeof(T));
+        std::memcpy(buf->data() + at, &v, sizeof(T));
+    }
+}
+
+static std::string DataURI(const std::vector<uint8_t>& bytes) {
+    static const char* kDigits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out = "data:application/octet-stream;base64,";
+    for (size_t i = 0; i < bytes.size(); i += 3) {
+        uint32_t bits = bytes[i] << 16;
+        if (i + 1 < bytes.size()) bits |= bytes[i + 1] << 8;
+        if (i + 2 < bytes.size()) bits |= bytes[i + 2];
+        for (size_t k = 0; k < 4; ++k) {
+            out.push_back(i + k <= bytes.size() ? kDigits[(bits >> (18 - 6 * k)) & 63] : '=');
+        }
+    }
+    return out;
+}
+
+// 12-byte header, a space-padded JSON chunk and a zero-padded BIN chunk
+static std::string MakeGlb(const json& doc, std::vector<uint8_t> bin) {
+    std::string text = doc.dump();
+    text.resize((text.size() + 3) / 4 * 4, ' ');
+    bin.resize((bin.size() + 3) / 4 * 4, 0);
+    std::vector<uint8_t> out;
+    const uint32_t total = static_cast<uint32_t>(12 + 8 + text.size() + 8 + bin.size());
+    Append<uint32_t>(&out, {0x46546C67u, 2u, total});
+    Append<uint32_t>(&out, {static_cast<uint32_t>(text.size()), 0x4E4F534Au});
+    out.insert(out.end(), text.begin(), text.end());
+    Append<uint32_t>(&out, {static_cast<uint32_t>(bin.size()), 0x004E4942u});
+    out.insert(out.end(), bin.begin(), bin.end());
+    return std::string(out.begin(), out.end());
+}
+
+// One triangle (positions only), the document a test then breaks or extends
+static json TriangleDoc() {
+    std::vector<uint8_t> buf;
+    Append<float>(&buf, {0, 0, 0, 1, 0, 0, 0, 1, 0});
+    json doc;
+    doc["asset"] = {{"version", "2.0"}};
+    doc["buffers"] = {{{"byteLength", buf.size()}, {"uri", DataURI(buf)}}};
+    doc["bufferViews"] = {{{"buffer", 0}, {"byteLength", buf.size()}}};
+    doc["accessors"] = {{{"bufferView", 0}, {"componentType", 5126}, {"type", "VEC3"},
+                         {"count", 3}}};
+    doc["meshes"] = {{{"primitives", {{{"attributes", {{"POSITION", 0}}}}}}}};
+    doc["nodes"] = {{{"mesh", 0}}};
+    doc["scenes"] = {{{"nodes", {0}}}};
+    return doc;
+}
+
+static void ExpectVec3(const Vec3& v, float x, float y, float z) {
+    EXPECT_NEAR(v.x(), x, 1e-5f);
+    EXPECT_NEAR(v.y(), y, 1e-5f);
+    EXPECT_NEAR(v.z(), z, 1e-5f);
+}
+
+TEST(GLTFLoaderTest, ReadsStridedAndNormalizedAccessorsFromADataURI) {
+    // Interleaved position + normal (stride 24), normalized ushort UVs, ubyte indices
+    std::vector<uint8_t> buf;
+    Append<float>(&buf, {0, 0, 0, 0, 0, 2, 1, 0, 0, 0, 0, 2, 0, 1, 0, 0, 0, 2});
+    Append<uint16_t>(&buf, {0, 0, 65535, 0, 0, 65535});
+    Append<uint8_t>(&buf, {2, 1, 0, 0});
+
+    json doc;
+    doc["asset"] = {{"version", "2.0"}};
+    doc["buffers"] = {{{"byteLength", buf.size()}, {"uri", DataURI(buf)}}};
+    doc["bufferViews"] = {
+        {{"buffer", 0}, {"byteOffset", 0}, {"byteLength", 72}, {"byteStride", 24}},
+        {{"buffer", 0}, {"byteOffset", 72}, {"byteLength", 12}},
+        {{"buffer", 0}, {"byteOffset", 84}, {"byteLength", 3}},
+    };
+    doc["accessors"] = {
+        {{"bufferView", 0}, {"componentType", 5126}, {"type", "VEC3"}, {"count", 3}},
+        {{"bufferView", 0},
+         {"byteOffset", 12},
+         {"componentType", 5126},
+         {"type", "VEC3"},
+         {"count", 3}},
+        {{"bufferView", 1},
+         {"componentType", 5123},
+         {"normalized", true},
+         {"type", "VEC2"},
+         {"count", 3}},
+        {{"bufferView", 2}, {"componentType", 5121}, {"type", "SCALAR"}, {"count", 3}},
+    };
+    doc["meshes"] = {{{"primitives",
+                       {{{"attributes", {{"POSITION", 0}, {"NORMAL", 1}, {"TEXCOORD_0", 2}}},
+                         {"indices", 3}}}}}};
+    // TRS node: scale by 2, then move by (1, 2, 3); used once, so baked into the vertices
+    doc["nodes"] = {{{"mesh", 0}, {"translation", {1, 2, 3}}, {"scale", {2, 2, 2}}}};
+    doc["scenes"] = {{{"nodes", {0}}}};
+
+    const std::string path = "test_gltf_accessors.gltf";
+    WriteFile(path, doc.dump());
+    Scene scene;
+    ASSERT_TRUE(LoadGLTF(path, scene));
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(scene.MeshCount(), 1u);
+    EXPECT_EQ(scene.InstanceCount(), 0u);
+    const Mesh& mesh = scene.GetMesh(0);
+    ASSERT_EQ(mesh.p.size(), 3u);
+    ExpectVec3(mesh.p[0], 1, 2, 3);
+    ExpectVec3(mesh.p[1], 3, 2, 3);
+    ExpectVec3(mesh.p[2], 1, 4, 3);
+    ASSERT_EQ(mesh.n.size(), 3u);
+    ExpectVec3(mesh.n[1], 0, 0, 1);  // Renormalized after the transform
+    ASSERT_EQ(mesh.uv.size(), 3u);
+    ExpectVec3(mesh.uv[0], 0, 1, 0);  // v flipped to the bottom-up texture convention
+    ExpectVec3(mesh.uv[1], 1, 1, 0);
+    ExpectVec3(mesh.uv[2], 0, 0, 0);
+    EXPECT_EQ(mesh.indices, (std::vector<uint32_t>{2, 1, 0}));
+
+    // No materials in the file: the grey Lambertian fallback
+    EXPECT_EQ(scene.GetMaterial(mesh.material_id).type, MaterialType::Lambertian);
+}
+
+TEST(GLTFLoaderTest, InstancesAMeshSharedByNodesOfAGlb) {
+    std::vector<uint8_t> bin;
+    Append<float>(&bin, {0, 0, 0, 1, 0, 0, 0, 1, 0});
+
+    json doc = TriangleDoc();
+    doc["buffers"] = {{{"byteLength", bin.size()}}};  // No uri: the GLB's BIN chunk
+    // A matrix node with a TRS child, and a rotated node: three placements of mesh 0
+    doc["nodes"] = {
+        {{"mesh", 0},
+         {"matrix", {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 5, 0, 0, 1}},
+         {"children", {2}}},
+        {{"mesh", 0}, {"rotation", {0, 0, 0.70710678f, 0.70710678f}}},
+        {{"mesh", 0}, {"translation", {0, 0, 1}}},
+    };
+    doc["scenes"] = {{{"nodes", {0, 1}}}};
+
+    const std::string path = "test_gltf_instances.glb";
+    WriteFile(path, MakeGlb(doc, bin));
+    Scene scene;
+    ASSERT_TRUE(LoadGLTF(path, scene));
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(scene.MeshCount(), 0u);
+    ASSERT_EQ(scene.InstanceCount(), 3u);
+    // Where each instance puts the vertex (1, 0, 0), in any order
+    const Vec3 expected[3] = {Vec3(6, 0, 0), Vec3(6, 0, 1), Vec3(0, 1, 0)};
+    for (const Vec3& e : expected) {
+        int matches = 0;
+        for (const Scene::Instance& inst : scene.Instances()) {
+            if ((inst.to_world.Point(Vec3(1, 0, 0)) - e).Length() < 1e-5f) matches++;
+        }
+        EXPECT_EQ(matches, 1) << e;
+    }
+}
+
+TEST(GLTFLoaderTest, MapsPBRMaterials) {
+    InitSpectralModel();
+
+    json doc = TriangleDoc();
+    doc["materials"] = {
+        {{"pbrMetallicRoughness",
+          {{"baseColorFactor", {0.8, 0.2, 0.2, 1.0}},
+           {"metallicFactor", 0.0},
+           {"baseColorTexture", {{"index", 0}}}}}},
+        {{"pbrMetallicRoughness", {{"metallicFactor", 1.0}, {"roughnessFactor", 0.6}}}},
+        {{"extensions",
+          {{"KHR_materials_transmission", {{"transmissionFactor", 1.0}}},
+           {"KHR_materials_ior", {{"ior", 1.33}}}}}},
+        {{"pbrMetallicRoughness", {{"metallicFactor", 0.0}}},
+         {"emissiveFactor", {1.0, 1.0, 1.0}},
+         {"extensions", {{"KHR_materials_emissive_strength", {{"emissiveStrength", 4.0}}}}}},
+    };
+    doc["textures"] = {{{"source", 0}}};
+    doc["images"] = {{{"uri", "test_gltf_albedo.ppm"}}};
+    json& prims = doc["meshes"][0]["primitives"];
+    const json prim = prims[0];
+    prims = json::array();
+    for (int m = 0; m < 4; ++m) {
+        prims.push_back(prim);
+        prims.back()["material"] = m;
+    }
+    prims.push_back(prim);  // No material
+
+    const std::string path = "test_gltf_materials.gltf";
+    WriteFile(path, doc.dump());
+    WriteFile("test_gltf_albedo.ppm", std::string("P6 1 1 255\n") + "\x80\x40\x20");
+    Scene scene;
+    ASSERT_TRUE(LoadGLTF(path, scene));
+    scene.FinishTextureLoads();
+    std::filesystem::remove(path);
+    std::filesystem::remove("test_gltf_albedo.ppm");
+
+    ASSERT_EQ(scene.MeshCount(), 5u);
+    const Material& diffuse = scene.GetMaterial(scene.GetMesh(0).material_id);
+    const Material& metal = scene.GetMaterial(scene.GetMesh(1).material_id);
+    const Material& glass = scene.GetMaterial(scene.GetMesh(2).material_id);
+    const Material& emitter = scene.GetMaterial(scene.GetMesh(3).material_id);
+    const Material& fallback = scene.GetMaterial(scene.GetMesh(4).material_id);
+
+    EXPECT_EQ(diffuse.type, MaterialType::Lambertian);
+    EXPECT_NEAR(diffuse.albedo_rgb.r(), ToLinear(0.8f), 1e-5f);
+    ASSERT_NE(diffuse.albedo_tex, kNoTexture);
+    EXPECT_EQ(scene.GetTexture(diffuse.albedo_tex).width, 1);
+    EXPECT_EQ(metal.type, MaterialType::Metal);
+    EXPECT_NEAR(metal.roughness, 0.3f, 1e-6f);
+    EXPECT_EQ(glass.type, MaterialType::Dielectric);
+    EXPECT_NEAR(glass.ior, 1.33f, 1e-6f);
+    EXPECT_EQ(emitter.type, MaterialType::Lambertian);
+    EXPECT_GT(emitter.emission.scale, 1.0f);
+    EXPECT_EQ(diffuse.emission.scale, 0.0f);
+    EXPECT_EQ(fallback.type, MaterialType::Lambertian);
+    EXPECT_NE(scene.GetMesh(4).material_id, scene.GetMesh(0).material_id);
+}
+
+TEST(GLTFLoaderTest, RejectsBadIndices) {
+    auto loads = [](const json& doc) {
+        const std::string path = "test_gltf_bad.gltf";
+        WriteFile(path, doc.dump());
+        Scene scene;
+        const bool ok = LoadGLTF(path, scene);
+        std::filesystem::remove(path);
+        return ok;
+    };
+    ASSERT_TRUE(loads(TriangleDoc()));
+
+    json doc = TriangleDoc();
+    doc["nodes"][0]["mesh"] = -1;
+    EXPECT_FALSE(loads(doc));
+    doc["nodes"][0]["mesh"] = 3;
+    EXPECT_FALSE(loads(doc));
+
+    doc = TriangleDoc();
+    doc["meshes"][0]["primitives"][0]["attributes"]["POSITION"] = 7;
+    EXPECT_FALSE(loads(doc));
+
+    doc = TriangleDoc();
+    doc["accessors"][0]["count"] = 4;  // Runs past the end of the buffer view
+    EXPECT_FALSE(loads(doc));
+
+    // Indices past the vertex count
+    std::vector<uint8_t> buf;
+    Append<float>(&buf, {0, 0, 0, 1, 0, 0, 0, 1, 0});
+    Append<uint8_t>(&buf, {0, 1, 9, 0});
+    doc = TriangleDoc();
+    doc["buffers"][0] = {{"byteLength", buf.size()}, {"uri", DataURI(buf)}};
+    doc["bufferViews"].push_back({{"buffer", 0}, {"byteOffset", 36}, {"byteLength", 3}});
+    doc["accessors"].push_back(
+        {{"bufferView", 1}, {"componentType", 5121}, {"type", "SCALAR"}, {"count", 3}});
+    doc["meshes"][0]["primitives"][0]["indices"] = 1;
+    EXPECT_FALSE(loads(doc));
+
+    doc = TriangleDoc();
+    doc["buffers"][0]["uri"] = "data:application/octet-stream;base64,@@@@";
+    EXPECT_FALSE(loads(doc));
+}
+
+}  // namespace skwr
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <memory>
 #include <vector>
 
 #include "film/image_buffer.h"
@@ -40,6 +41,9 @@ class ImageIOTest : public ::testing::Test {
                         s.z_back = 12.0f + i * 5.0f;
                         s.r = static_cast<float>(x) / w, s.g = static_cast<float>(y) / h,
                         s.b = static_cast<float>(i) / count, s.alpha = 0.5f;
+                        s.object_id = x;
+                        s.material_id = 100 + y;
+                        s.sample_count = i + 1;
                         samples.push_back(s);
                     }
                     expectedBuffer->SetPixel(x, y, samples);
@@ -78,6 +82,9 @@ TEST_F(ImageIOTest, SaveAndLoadEXR) {
                 EXPECT_FLOAT_EQ(loadedPixel[i].r, expectedPixel[i].r);
                 EXPECT_FLOAT_EQ(loadedPixel[i].g, expectedPixel[i].g);
                 EXPECT_FLOAT_EQ(loadedPixel[i].b, expectedPixel[i].b);
+                EXPECT_EQ(loadedPixel[i].object_id, expectedPixel[i].object_id);
+                EXPECT_EQ(loadedPixel[i].material_id, expectedPixel[i].material_id);
+                EXPECT_EQ(loadedPixel[i].sample_count, expectedPixel[i].sample_count);
             }
         }
     }
@@ -88,4 +95,85 @@ TEST_F(ImageIOTest, SaveAndLoadEXR) {
     // }
 }
 
+TEST_F(ImageIOTest, StreamedBandsMatchOneShotSave) {
+    const std::string streamedFilename = "test_output_streamed.exr";
+    const int w = expectedBuffer->GetWidth();
+    const int bandHeight = 2;
+
+    // Copies rows [y0, y0 + bandHeight) of the expected buffer into a buffer of their own
+    auto band = [&](int y0) {
+        Imf::Array2D<unsigned int> counts(bandHeight, w);
+        size_t total = 0;
+        for (int y = 0; y < bandHeight; ++y) {
+            for (int x = 0; x < w; ++x) {
+                counts[y][x] = static_cast<unsigned int>(expectedBuffer->GetPixel(x, y0 + y).count);
+                total += counts[y][x];
+            }
+        }
+        auto rows = std::make_unique<DeepImageBuffer>(w, bandHeight, total, counts);
+        for (int y = 0; y < bandHeight; ++y) {
+            for (int x = 0; x < w; ++x) {
+                DeepPixelView p = expectedBuffer->GetPixel(x, y0 + y);
+                rows->SetPixel(x, y, std::vector<DeepSample>(p.data, p.data + p.count));
+            }
+        }
+        return rows;
+    };
+
+    {
+        DeepEXRBandWriter writer(streamedFilename, w, expectedBuffer->GetHeight(), bandHeight);
+        ASSERT_EQ(writer.BandCount(), 2);
+        // The bottom band finishes first and has to wait for the top one
+        EXPECT_EQ(writer.Submit(1, band(2)), 0);
+        EXPECT_EQ(writer.Submit(0, band(0)), 2);
+    }
+
+    DeepImageBuffer loadedBuffer = ImageIO::LoadEXR(streamedFilename);
+    ASSERT_EQ(loadedBuffer.GetHeight(), expectedBuffer->GetHeight());
+    for (int y = 0; y < expectedBuffer->GetHeight(); ++y) {
+        for (int x = 0; x < w; ++x) {
+            DeepPixelView expectedPixel = expectedBuffer->GetPixel(x, y);
+            DeepPixelView loadedPixel = loadedBuffer.GetPixel(x, y);
+            ASSERT_EQ(loadedPixel.count, expectedPixel.count) << "Mismatch at " << x << "," << y;
+            for (size_t i = 0; i < expectedPixel.count; ++i) {
+                EXPECT_FLOAT_EQ(loadedPixel[i].z_front, expectedPixel[i].z_front);
+                EXPECT_FLOAT_EQ(loadedPixel[i].alpha, expectedPixel[i].alpha);
+                EXPECT_FLOAT_EQ(loadedPixel[i].r, expectedPixel[i].r);
+            }
+        }
+    }
+    std::filesystem::remove(streamedFilename);
+}
+
+TEST(ImageIOChunkTest, ChunkEXRKeepsSumsBitExact) {
+    const std::string filename = "test_output_chunk.exr";
+    ChunkImageBuffer chunk(3, 2, {16, 48, 64});
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            // Values a float channel could not hold
+            chunk.SetPixel(x, y, {1.0 / 3.0 + x, 1e-300 * y, 12345.678901234567, 32.0 + y, 32u});
+        }
+    }
+    ImageIO::SaveChunkEXR(chunk, filename);
+
+    ChunkImageBuffer loaded = ImageIO::LoadChunkEXR(filename);
+    EXPECT_EQ(loaded.GetRange().start, 16);
+    EXPECT_EQ(loaded.GetRange().end, 48);
+    EXPECT_EQ(loaded.GetRange().total, 64);
+    ASSERT_EQ(loaded.GetWidth(), 3);
+    ASSERT_EQ(loaded.GetHeight(), 2);
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            const ChunkImagePixel& e = chunk.GetPixel(x, y);
+            const ChunkImagePixel& a = loaded.GetPixel(x, y);
+            EXPECT_EQ(a.r, e.r);
+            EXPECT_EQ(a.g, e.g);
+            EXPECT_EQ(a.b, e.b);
+            EXPECT_EQ(a.weight, e.weight);
+            EXPECT_EQ(a.sample_count, e.sample_count);
+        }
+    }
+    std::filesystem::remove(filename);
+}
+
 }  // namespace skwr
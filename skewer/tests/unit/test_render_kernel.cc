@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "core/spectral/spectral_utils.h"
+#include "film/film.h"
+#include "film/film_tile.h"
+#include "film/image_buffer.h"
+#include "geometry/mesh.h"
+#include "geometry/sphere.h"
+#include "kernels/render_kernel.h"
+#include "materials/material.h"
+#include "materials/texture.h"
+#include "scene/camera.h"
+#include "scene/scene.h"
+#include "session/render_options.h"
+
+namespace skwr {
+
+static Material MakeMaterial(MaterialType type, const RGB& albedo) {
+    Material m{};
+    m.type = type;
+    m.albedo = RGBToCurve(albedo);
+    m.albedo_rgb = albedo;
+    m.emission = RGBToCurve(RGB(0.0f));
+    m.roughness = 0.2f;
+    m.ior = 1.5f;
+    m.dispersion = 0.0f;
+    return m;
+}
+
+// Square in the XZ plane at height y, facing +Y, with uvs over [0, 1]
+static Mesh MakeFloor(float y, float half, uint32_t material_id, uint32_t object_id) {
+    Mesh mesh;
+    mesh.p = {Vec3(-half, y, -half), Vec3(-half, y, half), Vec3(half, y, half),
+              Vec3(half, y, -half)};
+    mesh.uv = {Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f), Vec3(1.0f, 1.0f, 0.0f),
+               Vec3(1.0f, 0.0f, 0.0f)};
+    mesh.indices = {0, 1, 2, 0, 2, 3};
+    mesh.material_id = material_id;
+    mesh.object_id = object_id;
+    return mesh;
+}
+
+// A textured floor, a metal and a glass sphere and a quad light: several materials, so the
+// sorted kernel's shading order really differs from pixel order
+static void BuildScene(Scene* scene) {
+    std::vector<float> pixels;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            const float c = ((x + y) % 2 == 0) ? 0.8f : 0.1f;
+            pixels.insert(pixels.end(), {c, 0.5f * c, 0.3f});
+        }
+    }
+    ImageTexture checker;
+    checker.Build(pixels, 8, 8, TexelFormat::RGBHalf);
+
+    Material floor = MakeMaterial(MaterialType::Lambertian, RGB(1.0f));
+    floor.albedo_tex = scene->AddTexture(std::move(checker));
+    const uint32_t floor_id = scene->AddMaterial(floor);
+    const uint32_t metal = scene->AddMaterial(MakeMaterial(MaterialType::Metal, RGB(0.8f)));
+    const uint32_t glass = scene->AddMaterial(MakeMaterial(MaterialType::Dielectric, RGB(1.0f)));
+    Material light = MakeMaterial(MaterialType::Lambertian, RGB(0.0f));
+    light.emission = RGBToCurve(RGB(15.0f));
+    const uint32_t light_id = scene->AddMaterial(light);
+
+    scene->AddMesh(MakeFloor(0.0f, 2.0f, floor_id, 0));
+    scene->AddSphere(Sphere{Vec3(-0.7f, 0.6f, 0.0f), 0.6f, metal, 1});
+    scene->AddSphere(Sphere{Vec3(0.7f, 0.6f, 0.3f), 0.6f, glass, 2});
+    Mesh lamp = MakeFloor(3.0f, 0.5f, light_id, 3);
+    lamp.indices = {0, 2, 1, 0, 3, 2};  // Facing down
+    scene->AddMesh(std::move(lamp));
+    scene->Build();
+}
+
+struct KernelRender {
+    std::vector<TilePixel> pixels;
+    std::vector<AOVPixel> aovs;
+    std::unique_ptr<DeepImageBuffer> deep;
+};
+
+// Renders every tile of a 40x36 frame (one full tile and three partial ones) with the baseline
+// kernel, keeping each tile's sums before they are merged into the film
+static KernelRender RenderFrame(const Scene& scene, bool sort_shading) {
+    const int width = 40;
+    const int height = 36;
+    const Camera cam(Vec3(0.0f, 1.5f, 5.0f), Vec3(0.0f, 0.8f, 0.0f), Vec3(0.0f, 1.0f, 0.0f),
+                     45.0f, float(width) / height);
+
+    IntegratorConfig config{};
+    config.max_depth = 6;
+    config.samples_per_pixel = 3;
+    config.start_sample = 0;
+    config.enable_aovs = true;
+    config.enable_deep = true;
+    config.sort_shading = sort_shading;
+    config.cam_w = -cam.GetW();
+
+    Film film(width, height);
+    film.EnableAOVs();
+    film.EnableDeep();
+
+    KernelRender out;
+    auto tile = std::make_unique<FilmTile>();
+    for (int t = 0; t < film.TileCount(); ++t) {
+        const TileBounds bounds = film.GetTileBounds(t);
+        tile->Reset(bounds, true);
+        isa_baseline::RenderTile(scene, cam, &film, tile.get(), config);
+        for (int y = bounds.y0; y < bounds.y1; ++y) {
+            for (int x = bounds.x0; x < bounds.x1; ++x) {
+                out.pixels.push_back(tile->At(x, y));
+                out.aovs.push_back(tile->AOVAt(x, y));
+            }
+        }
+        film.MergeTile(*tile);
+    }
+    out.deep = film.CreateDeepBuffer(config.samples_per_pixel, 1);
+    return out;
+}
+
+TEST(RenderKernelTest, SortedShadingIsBitIdenticalToUnsorted) {
+    InitSpectralModel();
+    Scene scene;
+    BuildScene(&scene);
+
+    const KernelRender unsorted = RenderFrame(scene, false);
+    const KernelRender sorted = RenderFrame(scene, true);
+
+    ASSERT_EQ(sorted.pixels.size(), unsorted.pixels.size());
+    size_t lit = 0;
+    for (size_t i = 0; i < unsorted.pixels.size(); ++i) {
+        const TilePixel& a = unsorted.pixels[i];
+        const TilePixel& b = sorted.pixels[i];
+        EXPECT_EQ(b.color_sum.r, a.color_sum.r) << "pixel " << i;
+        EXPECT_EQ(b.color_sum.g, a.color_sum.g) << "pixel " << i;
+        EXPECT_EQ(b.color_sum.b, a.color_sum.b) << "pixel " << i;
+        EXPECT_EQ(b.weight_sum, a.weight_sum) << "pixel " << i;
+        EXPECT_EQ(b.sample_count, a.sample_count) << "pixel " << i;
+        if (a.color_sum.r + a.color_sum.g + a.color_sum.b > 0.0) ++lit;
+
+        const AOVPixel& p = unsorted.aovs[i];
+        const AOVPixel& q = sorted.aovs[i];
+        EXPECT_EQ(q.albedo_sum.r(), p.albedo_sum.r()) << "pixel " << i;
+        EXPECT_EQ(q.albedo_sum.g(), p.albedo_sum.g()) << "pixel " << i;
+        EXPECT_EQ(q.albedo_sum.b(), p.albedo_sum.b()) << "pixel " << i;
+        for (int k = 0; k < 3; ++k) EXPECT_EQ(q.normal_sum[k], p.normal_sum[k]) << "pixel " << i;
+        EXPECT_EQ(q.lum_sum, p.lum_sum) << "pixel " << i;
+        EXPECT_EQ(q.lum_sq_sum, p.lum_sq_sum) << "pixel " << i;
+        EXPECT_EQ(q.depth, p.depth) << "pixel " << i;
+        EXPECT_EQ(q.object_id, p.object_id) << "pixel " << i;
+        EXPECT_EQ(q.material_id, p.material_id) << "pixel " << i;
+    }
+    // Much of the frame is lit (the rest is sky), so the sums compared are not all zero
+    EXPECT_GT(lit, unsorted.pixels.size() / 4);
+
+    ASSERT_EQ(sorted.deep->GetWidth(), unsorted.deep->GetWidth());
+    ASSERT_EQ(sorted.deep->GetHeight(), unsorted.deep->GetHeight());
+    for (int y = 0; y < unsorted.deep->GetHeight(); ++y) {
+        for (int x = 0; x < unsorted.deep->GetWidth(); ++x) {
+            const DeepPixelView a = unsorted.deep->GetPixel(x, y);
+            const DeepPixelView b = sorted.deep->GetPixel(x, y);
+            ASSERT_EQ(b.count, a.count) << "deep pixel " << x << "," << y;
+            for (size_t s = 0; s < a.count; ++s) {
+                EXPECT_EQ(b[s].z_front, a[s].z_front);
+                EXPECT_EQ(b[s].z_back, a[s].z_back);
+                EXPECT_EQ(b[s].r, a[s].r);
+                EXPECT_EQ(b[s].g, a[s].g);
+                EXPECT_EQ(b[s].b, a[s].b);
+                EXPECT_EQ(b[s].alpha, a[s].alpha);
+                EXPECT_EQ(b[s].object_id, a[s].object_id);
+                EXPECT_EQ(b[s].material_id, a[s].material_id);
+                EXPECT_EQ(b[s].sample_count, a[s].sample_count);
+            }
+        }
+    }
+}
+
+}  // namespace skwr
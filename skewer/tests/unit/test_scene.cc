@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "core/ray.h"
+#include "core/sampling/wavelength_sampler.h"
+#include "core/transform.h"
+#include "geometry/mesh.h"
+#include "kernels/path_kernel.h"
+#include "materials/material.h"
+#include "scene/animation.h"
+#include "scene/scene.h"
+#include "scene/scene_intersect.h"
+#include "scene/surface_interaction.h"
+#include "session/render_options.h"
+
+namespace skwr {
+
+// Unit quad in the XY plane facing +Z, as one mesh
+static Mesh MakeQuad(uint32_t material_id) {
+    Mesh mesh;
+    mesh.p = {Vec3(-0.5f, -0.5f, 0.0f), Vec3(0.5f, -0.5f, 0.0f), Vec3(0.5f, 0.5f, 0.0f),
+              Vec3(-0.5f, 0.5f, 0.0f)};
+    mesh.indices = {0, 1, 2, 0, 2, 3};
+    mesh.material_id = material_id;
+    return mesh;
+}
+
+TEST(SceneTest, AffineInverseUndoesTransform) {
+    Affine3 a = Affine3::FromSRT(Vec3(1.0f, -2.0f, 3.0f), Vec3(30.0f, 45.0f, -60.0f),
+                                 Vec3(2.0f, 0.5f, 1.5f));
+    Affine3 id = a.Inverse() * a;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) EXPECT_NEAR(id.m[r][c], (r == c) ? 1.0f : 0.0f, 1e-5f);
+    }
+
+    // FromSRT matches ApplyTransform
+    std::vector<Vec3> v = {Vec3(0.3f, -0.7f, 1.1f)};
+    ApplyTransform(v, Vec3(1.0f, -2.0f, 3.0f), Vec3(30.0f, 45.0f, -60.0f), Vec3(2.0f, 0.5f, 1.5f));
+    Vec3 p = a.Point(Vec3(0.3f, -0.7f, 1.1f));
+    for (int k = 0; k < 3; ++k) EXPECT_NEAR(p[k], v[0][k], 1e-5f);
+}
+
+TEST(SceneTest, InstancesHitLikeFlattenedCopies) {
+    const Affine3 placements[2] = {
+        Affine3::FromSRT(Vec3(-1.0f, 0.0f, -3.0f), Vec3(0.0f, 30.0f, 0.0f),
+                         Vec3(1.0f, 1.0f, 1.0f)),
+        Affine3::FromSRT(Vec3(1.0f, 0.5f, -5.0f), Vec3(20.0f, 0.0f, 10.0f),
+                         Vec3(3.0f, 3.0f, 3.0f)),
+    };
+
+    Scene instanced;
+    const uint32_t mat = instanced.AddMaterial(Material{});
+    std::vector<Mesh> proto;
+    proto.push_back(MakeQuad(mat));
+    const uint32_t proto_id = instanced.AddPrototype(std::move(proto));
+    instanced.AddInstance(proto_id, placements[0], 7);
+    instanced.AddInstance(proto_id, placements[1], 8);
+    instanced.Build();
+    EXPECT_EQ(instanced.InstanceCount(), 2u);
+
+    Scene flat;
+    flat.AddMaterial(Material{});
+    for (int i = 0; i < 2; ++i) {
+        Mesh mesh = MakeQuad(0);
+        for (Vec3& p : mesh.p) p = placements[i].Point(p);
+        mesh.object_id = 7 + i;
+        flat.AddMesh(std::move(mesh));
+    }
+    flat.Build();
+
+    int hits = 0;
+    for (int y = -8; y <= 8; ++y) {
+        for (int x = -8; x <= 8; ++x) {
+            Ray r(Vec3(0.0f, 0.0f, 0.0f), Vec3(x * 0.05f, y * 0.05f, -1.0f));
+            SurfaceInteraction a, b;
+            const bool hit_a = IntersectScene(instanced, r, 1e-4f, 1e30f, &a);
+            const bool hit_b = IntersectScene(flat, r, 1e-4f, 1e30f, &b);
+            ASSERT_EQ(hit_a, hit_b);
+            if (!hit_a) continue;
+            hits++;
+            EXPECT_NEAR(a.t, b.t, 1e-4f);
+            EXPECT_EQ(a.object_id, b.object_id);
+            EXPECT_EQ(a.front_face, b.front_face);
+            for (int k = 0; k < 3; ++k) {
+                EXPECT_NEAR(a.point[k], b.point[k], 1e-4f);
+                EXPECT_NEAR(a.n_geom[k], b.n_geom[k], 1e-4f);
+            }
+        }
+    }
+    EXPECT_GT(hits, 20);
+}
+
+TEST(SceneTest, MovedObjectsHitLikeRebuiltScenes) {
+    const Affine3 motions[2] = {
+        Affine3::FromSRT(Vec3(0.0f, 0.0f, -3.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(2.0f, 2.0f, 2.0f)),
+        Affine3::FromSRT(Vec3(0.5f, -0.2f, -4.0f), Vec3(10.0f, 40.0f, 0.0f),
+                         Vec3(3.0f, 3.0f, 3.0f)),
+    };
+
+    Scene moving;
+    const uint32_t mat = moving.AddMaterial(Material{});
+    Mesh quad = MakeQuad(mat);
+    quad.object_id = 4;
+    moving.AddMesh(std::move(quad));
+    moving.MakeObjectMovable(4);
+    EXPECT_EQ(moving.MeshCount(), 0u);
+    EXPECT_THROW(moving.MakeObjectMovable(5), std::runtime_error);
+    moving.Build();
+    ASSERT_EQ(moving.InstanceCount(), 1u);
+
+    for (const Affine3& motion : motions) {
+        EXPECT_EQ(moving.SetObjectMotion(4, motion), 1u);
+        moving.UpdateInstances();
+
+        Scene rebuilt;
+        rebuilt.AddMaterial(Material{});
+        Mesh mesh = MakeQuad(0);
+        for (Vec3& p : mesh.p) p = motion.Point(p);
+        mesh.object_id = 4;
+        rebuilt.AddMesh(std::move(mesh));
+        rebuilt.Build();
+
+        int hits = 0;
+        for (int y = -8; y <= 8; ++y) {
+            for (int x = -8; x <= 8; ++x) {
+                Ray r(Vec3(0.0f, 0.0f, 0.0f), Vec3(x * 0.05f, y * 0.05f, -1.0f));
+                SurfaceInteraction a, b;
+                const bool hit_a = IntersectScene(moving, r, 1e-4f, 1e30f, &a);
+                const bool hit_b = IntersectScene(rebuilt, r, 1e-4f, 1e30f, &b);
+                ASSERT_EQ(hit_a, hit_b);
+                if (!hit_a) continue;
+                hits++;
+                EXPECT_NEAR(a.t, b.t, 1e-4f);
+                EXPECT_EQ(a.object_id, 4u);
+            }
+        }
+        EXPECT_GT(hits, 20);
+    }
+}
+
+TEST(SceneTest, AnimationKeysInterpolateAndHold) {
+    AnimationConfig animation;
+    animation.camera = {{10, Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 0.0f, -1.0f), 40.0f},
+                        {20, Vec3(10.0f, 0.0f, 0.0f), Vec3(0.0f, 0.0f, -1.0f), 60.0f}};
+    const CameraKey still{0, Vec3(5.0f, 5.0f, 5.0f), Vec3(0.0f, 0.0f, 0.0f), 90.0f};
+
+    EXPECT_FLOAT_EQ(CameraAt(animation, still, 15).look_from.x(), 5.0f);
+    EXPECT_FLOAT_EQ(CameraAt(animation, still, 15).vfov, 50.0f);
+    EXPECT_FLOAT_EQ(CameraAt(animation, still, 0).look_from.x(), 0.0f);  // Holds the first key
+    EXPECT_FLOAT_EQ(CameraAt(animation, still, 30).vfov, 60.0f);         // and the last
+    EXPECT_FLOAT_EQ(CameraAt(AnimationConfig{}, still, 15).vfov, 90.0f);
+
+    std::vector<MotionKey> keys(2);
+    keys[0].frame = 0;
+    keys[1].frame = 4;
+    keys[1].translate = Vec3(0.0f, 8.0f, 0.0f);
+    const Vec3 p = MotionAt(keys, 1).Point(Vec3(1.0f, 0.0f, 0.0f));
+    EXPECT_NEAR(p.x(), 1.0f, 1e-6f);
+    EXPECT_NEAR(p.y(), 2.0f, 1e-6f);
+    EXPECT_NEAR(MotionAt({}, 3).Point(p).y(), 2.0f, 1e-6f);
+}
+
+TEST(SceneTest, DeepSelectionFlattensOrOmitsExcludedHits) {
+    Scene scene;
+    scene.SetObjectDeep(3, false);
+    EXPECT_FALSE(scene.ObjectHasDeep(3));
+    EXPECT_TRUE(scene.ObjectHasDeep(2));
+    EXPECT_TRUE(scene.ObjectHasDeep(100));
+
+    IntegratorConfig config{};
+    config.enable_deep = true;
+    config.cam_w = Vec3(0.0f, 0.0f, -1.0f);
+    config.deep_max_depth = 10.0f;
+    const SampledWavelengths wl = WavelengthSampler::Sample(0.5f);
+
+    auto finish = [&](float z, bool masked) {
+        PathState st = StartPath(Ray(Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 0.0f, -1.0f)));
+        st.valid_deep_hit = true;
+        st.deep_hit_point = Vec3(0.0f, 0.0f, -z);
+        st.deep_hit_masked = masked;
+        return FinishPath(st, config, wl);
+    };
+
+    PathSample kept = finish(4.0f, false);
+    ASSERT_EQ(kept.segments.size(), 1u);
+    EXPECT_FLOAT_EQ(kept.segments[0].z_front, 4.0f);
+
+    // Outside the depth window, or masked: merged into the far sample
+    EXPECT_EQ(finish(20.0f, false).segments[0].z_front, kFarClip);
+    EXPECT_EQ(finish(4.0f, true).segments[0].z_front, kFarClip);
+
+    config.deep_flatten_excluded = false;
+    EXPECT_TRUE(finish(20.0f, false).segments.empty());
+    EXPECT_TRUE(finish(4.0f, true).segments.empty());
+    EXPECT_EQ(finish(4.0f, false).segments.size(), 1u);
+}
+
+}  // namespace skwr
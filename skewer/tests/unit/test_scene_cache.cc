@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "io/scene_loader.h"
+#include "session/scene_cache.h"
+
+namespace skwr {
+
+static void WriteFile(const std::string& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary) << contents;
+}
+
+TEST(SceneCacheTest, ReusesScenesUntilEvictedOrChanged) {
+    const std::string a = "test_scene_cache_a.json";
+    const std::string b = "test_scene_cache_b.json";
+    const std::string c = "test_scene_cache_c.json";
+    WriteFile(a, "{\"a\": 1}");
+    WriteFile(b, "{\"b\": 1}");
+    WriteFile(c, "{\"c\": 1}");
+
+    // Stand-in for PrepareSceneFile: each load makes a distinct scene and is counted
+    std::map<std::string, int> loads;
+    SceneCache cache(2, [&](const std::string& path) {
+        loads[path]++;
+        return std::make_shared<const PreparedScene>();
+    });
+
+    std::shared_ptr<const PreparedScene> first = cache.Get(a);
+    EXPECT_EQ(cache.Get(a), first);
+    EXPECT_EQ(loads[a], 1);
+    EXPECT_EQ(cache.Hits(), 1u);
+
+    // b then a are used, so c evicts b, the least recently used
+    cache.Get(b);
+    cache.Get(a);
+    cache.Get(c);
+    EXPECT_EQ(cache.Size(), 2u);
+    cache.Get(a);
+    EXPECT_EQ(loads[a], 1);
+    cache.Get(b);
+    EXPECT_EQ(loads[b], 2);
+
+    // Same path, new contents: reloaded, and the old scene stays valid for its holder
+    WriteFile(a, "{\"a\": 2}");
+    std::shared_ptr<const PreparedScene> second = cache.Get(a);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(loads[a], 2);
+    EXPECT_EQ(cache.Size(), 2u);
+
+    EXPECT_THROW(cache.Get("test_scene_cache_missing.json"), std::runtime_error);
+    EXPECT_EQ(cache.Size(), 2u);
+
+    EXPECT_NE(HashFileContents(a), HashFileContents(b));
+    for (const std::string& path : {a, b, c}) std::filesystem::remove(path);
+}
+
+TEST(SceneCacheTest, FailedReloadKeepsTheCachedScene) {
+    const std::string a = "test_scene_cache_reload.json";
+    WriteFile(a, "{\"a\": 1}");
+
+    bool fail = false;
+    SceneCache cache(1, [&](const std::string&) {
+        if (fail) throw std::runtime_error("bad scene");
+        return std::make_shared<const PreparedScene>();
+    });
+    std::shared_ptr<const PreparedScene> first = cache.Get(a);
+
+    // The edit breaks the scene: the reload throws and the old entry is still there
+    WriteFile(a, "{\"a\": 2}");
+    fail = true;
+    EXPECT_THROW(cache.Get(a), std::runtime_error);
+    EXPECT_EQ(cache.Size(), 1u);
+
+    // Once the file loads again it replaces the stale scene
+    fail = false;
+    std::shared_ptr<const PreparedScene> second = cache.Get(a);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(cache.Get(a), second);
+    EXPECT_EQ(cache.Size(), 1u);
+    std::filesystem::remove(a);
+}
+
+}  // namespace skwr
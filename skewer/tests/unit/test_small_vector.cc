@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "core/small_vector.h"
+#include "integrators/path_sample.h"
+
+namespace skwr {
+
+TEST(SmallVectorTest, StaysInlineUpToCapacity) {
+    SmallVector<int, 4> v;
+    for (int i = 0; i < 4; ++i) v.push_back(i);
+
+    EXPECT_EQ(v.size(), 4u);
+    EXPECT_FALSE(v.spilled());
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(v[i], i);
+}
+
+TEST(SmallVectorTest, SpillsToHeapPreservingContents) {
+    SmallVector<int, 4> v;
+    for (int i = 0; i < 11; ++i) v.push_back(i * 3);
+
+    EXPECT_TRUE(v.spilled());
+    EXPECT_EQ(v.size(), 11u);
+    EXPECT_GE(v.capacity(), 11u);
+    int expected = 0;
+    for (int value : v) {
+        EXPECT_EQ(value, expected);
+        expected += 3;
+    }
+
+    SmallVector<int, 4> copy = v;
+    ASSERT_EQ(copy.size(), v.size());
+    for (size_t i = 0; i < v.size(); ++i) EXPECT_EQ(copy[i], v[i]);
+}
+
+TEST(SmallVectorTest, PathSampleSegmentsAreInline) {
+    PathSample sample;
+    EXPECT_TRUE(sample.segments.empty());
+    sample.segments.push_back({1.0f, 2.0f, RGB(0.5f), 1.0f});
+    EXPECT_FALSE(sample.segments.spilled());
+    EXPECT_FLOAT_EQ(sample.segments[0].z_back, 2.0f);
+}
+
+}  // namespace skwr
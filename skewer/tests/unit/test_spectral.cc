@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "core/sampling/wavelength_sampler.h"
+#include "core/spectral/cie_data.h"
+#include "core/spectral/spectral_utils.h"
+
+namespace skwr {
+
+TEST(SpectralTest, CIETableMatchesTabulatedValues) {
+    // Exact table entries come back unchanged
+    EXPECT_FLOAT_EQ(CIE_Y(555.0f), 1.0f);
+    EXPECT_FLOAT_EQ(CIE_X(600.0f), 1.0622f);
+    EXPECT_FLOAT_EQ(CIE_Z(445.0f), 1.7826f);
+
+    // Between entries the curves are linearly interpolated
+    EXPECT_FLOAT_EQ(CIE_Y(557.5f), 0.5f * (1.0f + 0.995f));
+
+    // Outside the table the curves clamp to the (near zero) end points
+    EXPECT_FLOAT_EQ(CIE_Y(300.0f), CIE_Y(kCIELambdaMin));
+    EXPECT_FLOAT_EQ(CIE_Y(900.0f), CIE_Y(kCIELambdaMax));
+}
+
+TEST(SpectralTest, CIEYIntegralMatchesTable) {
+    // Trapezoidal integral of the interpolated curve over the whole table
+    double sum = 0.0;
+    for (int i = 0; i + 1 < kCIESampleCount; ++i) {
+        sum += 0.5 * (kCIE_Y[i] + kCIE_Y[i + 1]) * kCIELambdaStep;
+    }
+    EXPECT_NEAR(sum, kCIE_Y_Integral, 1e-3);
+}
+
+TEST(SpectralTest, UnitSpectrumHasUnitLuminance) {
+    // Averaging the estimator over stratified hero wavelengths must converge to Y = 1
+    const int kStrata = 4096;
+    const Spectrum white(1.0f);
+    double luminance = 0.0;
+    for (int i = 0; i < kStrata; ++i) {
+        SampledWavelengths wl = WavelengthSampler::Sample((i + 0.5f) / kStrata);
+        luminance += SpectrumToRGB(white, wl).Luminance();
+    }
+    EXPECT_NEAR(luminance / kStrata, 1.0, 1e-3);
+}
+
+}  // namespace skwr
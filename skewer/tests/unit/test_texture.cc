@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "core/half.h"
+#include "core/spectral/spectral_utils.h"
+#include "materials/texture.h"
+#include "materials/texture_cache.h"
+
+namespace skwr {
+
+// 8x8 black/white checkerboard with 1-texel squares
+static ImageTexture MakeChecker() {
+    std::vector<float> pixels;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            float c = ((x + y) % 2 == 0) ? 1.0f : 0.0f;
+            for (int k = 0; k < 3; ++k) pixels.push_back(c);
+        }
+    }
+    ImageTexture tex;
+    tex.Build(pixels, 8, 8, TexelFormat::RGBHalf);
+    return tex;
+}
+
+// Gradient with some high-frequency blue; at 300x200 the first levels span several tiles
+static std::vector<float> MakeGradient(int w, int h) {
+    std::vector<float> pixels;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            pixels.push_back(float(x) / w);
+            pixels.push_back(float(y) / h);
+            pixels.push_back(float((x * 7 + y * 3) % 11) / 10.0f);
+        }
+    }
+    return pixels;
+}
+
+TEST(TextureTest, MipChainHalvesDownToOneTexelAndKeepsTheMean) {
+    ImageTexture tex = MakeChecker();
+    ASSERT_EQ(tex.levels.size(), 4u);  // 8, 4, 2, 1
+    EXPECT_EQ(tex.levels[1].width, 4);
+    EXPECT_EQ(tex.levels[3].width, 1);
+    EXPECT_EQ(tex.levels[3].height, 1);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) EXPECT_FLOAT_EQ(tex.Texel(1, x, y).r(), 0.5f);
+    }
+    EXPECT_FLOAT_EQ(tex.Texel(3, 0, 0).b(), 0.5f);
+}
+
+TEST(TextureTest, OddSizesDownsampleEveryTexel) {
+    // 5x1: the next level is 2x1, and the last column must reach it with its full weight
+    std::vector<float> row;
+    for (float v : {0.0f, 0.0f, 0.0f, 0.0f, 1.0f}) row.insert(row.end(), {v, v, v});
+    ImageTexture strip;
+    strip.Build(row, 5, 1, TexelFormat::RGBHalf);
+    ASSERT_EQ(strip.levels[1].width, 2);
+    EXPECT_FLOAT_EQ(strip.Texel(1, 0, 0).r(), 0.0f);
+    EXPECT_NEAR(strip.Texel(1, 1, 0).r(), 0.4f, 1e-3f);  // Taps 2, 3, 4 weighted 1, 2, 2 (/5)
+
+    // 3x3 with only the bottom-right corner lit: the 1x1 level is the mean of all nine
+    std::vector<float> pixels(3 * 3 * 3, 0.0f);
+    for (int c = 0; c < 3; ++c) pixels[8 * 3 + c] = 0.9f;
+    ImageTexture tex;
+    tex.Build(pixels, 3, 3, TexelFormat::RGBHalf);
+    ASSERT_EQ(tex.levels.size(), 2u);
+    EXPECT_NEAR(tex.Texel(1, 0, 0).g(), 0.1f, 1e-3f);
+}
+
+TEST(TextureTest, FootprintSelectsLevel) {
+    ImageTexture tex = MakeChecker();
+
+    // No differentials: finest level, same as the plain lookup
+    EXPECT_FLOAT_EQ(tex.Sample(0.0f, 0.0f, UVDifferentials{}).r(), tex.Sample(0.0f, 0.0f).r());
+    EXPECT_FLOAT_EQ(tex.Sample(0.0f, 0.0f).r(), 1.0f);
+
+    // A footprint covering the whole texture averages the checker
+    UVDifferentials wide;
+    wide.dudx = 1.0f;
+    wide.dvdy = 1.0f;
+    EXPECT_FLOAT_EQ(tex.Sample(0.3f, 0.7f, wide).g(), 0.5f);
+}
+
+TEST(TextureTest, CachedTexturePagesUnderBudgetAndMatchesResident) {
+    const int w = 300, h = 200;
+    ImageTexture resident;
+    resident.Build(MakeGradient(w, h), w, h, TexelFormat::RGBA8);
+
+    // Room for two tiles per shard: far less than the 20 + 6 + 2 + ... tiles of the chain
+    TextureCache cache(2 * 16 * 4 * kTextureTileTexels);
+    ImageTexture cached;
+    cached.Build(MakeGradient(w, h), w, h, TexelFormat::RGBA8, &cache);
+    EXPECT_TRUE(cached.tiles.empty());
+    EXPECT_EQ(cache.TileCount(), 20u + 6u + 2u + 6u * 1u);
+
+    UVDifferentials wide;
+    wide.dudx = 0.02f;
+    wide.dvdy = 0.02f;
+    for (int i = 0; i < 500; ++i) {
+        float u = float(i % 37) / 37.0f;
+        float v = float(i % 23) / 23.0f;
+        EXPECT_EQ(cached.Sample(u, v).r(), resident.Sample(u, v).r());
+        EXPECT_EQ(cached.Sample(u, v).b(), resident.Sample(u, v).b());
+        EXPECT_EQ(cached.Sample(u, v, wide).g(), resident.Sample(u, v, wide).g());
+    }
+}
+
+TEST(TextureTest, ThreadTileTableFollowsTheCacheInUse) {
+    // Two caches whose tile 0 differs: the calling thread's table must not mix them up
+    std::vector<uint32_t> a(kTextureTileTexels, 0xAAAAAAAAu), b(kTextureTileTexels, 0xBBBBBBBBu);
+    TextureCache cache_a(16 * 4 * kTextureTileTexels), cache_b(16 * 4 * kTextureTileTexels);
+    ASSERT_EQ(cache_a.Store(a.data(), 4 * kTextureTileTexels, 1), 0u);
+    ASSERT_EQ(cache_b.Store(b.data(), 4 * kTextureTileTexels, 1), 0u);
+
+    auto first_word = [](const uint8_t* tile) { return *reinterpret_cast<const uint32_t*>(tile); };
+    EXPECT_EQ(first_word(cache_a.Fetch(0)), 0xAAAAAAAAu);
+    EXPECT_EQ(first_word(cache_b.Fetch(0)), 0xBBBBBBBBu);
+    EXPECT_EQ(first_word(cache_a.Fetch(0)), 0xAAAAAAAAu);
+
+    TextureCache::ReleaseThreadTiles();
+    EXPECT_EQ(first_word(cache_b.Fetch(0)), 0xBBBBBBBBu);
+    TextureCache::ReleaseThreadTiles();
+}
+
+TEST(TextureTest, HalfConversionRoundTripsEveryFiniteValue) {
+    for (uint32_t h = 0; h < 0x10000u; ++h) {
+        if ((h & 0x7C00u) == 0x7C00u) continue;  // Inf / NaN
+        ASSERT_EQ(FloatToHalf(HalfToFloat(static_cast<uint16_t>(h))), h) << h;
+    }
+    EXPECT_EQ(HalfToFloat(FloatToHalf(0.1f)), 0.0999755859375f);
+    EXPECT_EQ(FloatToHalf(1e6f), 0x7C00u);
+}
+
+TEST(TextureTest, CompactFormatsDecodeToTheFloatConvention) {
+    // 8-bit colour: every source byte survives the linear round trip exactly
+    std::vector<float> ramp;
+    for (int i = 0; i < 256; ++i) {
+        float linear = std::pow(float(i) / 255.0f, 2.2f);
+        ramp.insert(ramp.end(), {linear, linear, linear});
+    }
+    ImageTexture color;
+    color.Build(ramp, 256, 1, TexelFormat::RGBA8);
+    for (int i = 0; i < 256; ++i) EXPECT_EQ(color.Texel(0, i, 0).g(), ramp[i * 3]);
+    EXPECT_EQ(color.TileBytes(), 13u * 4 * kTextureTileTexels);  // 256x1 .. 1x1: 4 + 2 + 7 * 1
+
+    // Normal map: XY kept to 8 bits, Z rebuilt so the decoded normal stays unit length
+    std::vector<float> normal = {0.5f, 0.5f, 1.0f, 0.8f, 0.3f, 0.7f};
+    ImageTexture nmap;
+    nmap.Build(normal, 2, 1, TexelFormat::RG8Normal);
+    RGB n = nmap.Texel(0, 1, 0);
+    float x = 2.0f * n.r() - 1.0f, y = 2.0f * n.g() - 1.0f, z = 2.0f * n.b() - 1.0f;
+    EXPECT_NEAR(x, 0.6f, 2.0f / 255.0f);  // One 8-bit step of the [0,1] encoding
+    EXPECT_NEAR(y, -0.4f, 2.0f / 255.0f);
+    EXPECT_NEAR(x * x + y * y + z * z, 1.0f, 1e-5f);
+    EXPECT_NEAR(nmap.Texel(0, 0, 0).b(), 1.0f, 1e-5f);
+}
+
+TEST(TextureTest, SpectralCoefficientTextureMatchesPerHitConversion) {
+    InitSpectralModel();
+
+    // 3x3 so that uv (0.5, 0.5) lands exactly on the centre texel, which is brighter than white
+    std::vector<float> pixels;
+    for (int i = 0; i < 9; ++i) {
+        if (i == 4) {
+            pixels.insert(pixels.end(), {1.5f, 0.7f, 0.0f});
+        } else {
+            pixels.insert(pixels.end(), {0.1f * i, 0.5f, 0.9f - 0.1f * i});
+        }
+    }
+    ImageTexture tex;
+    tex.Build(pixels, 3, 3, TexelFormat::SpectralCoeffs);
+    ASSERT_TRUE(tex.IsSpectral());
+
+    // On a texel the filtered curve is exactly the one RGBToCurve gives for it, scale included
+    SpectralCurve expected = RGBToCurve(RGB(1.5f, 0.7f, 0.0f));
+    SpectralCurve curve = tex.SampleCurve(0.5f, 0.5f, UVDifferentials{});
+    for (int k = 0; k < 3; ++k) EXPECT_EQ(curve.coeff[k], expected.coeff[k]);
+    EXPECT_EQ(curve.scale, expected.scale);
+    EXPECT_GT(curve.scale, 1.0f);
+}
+
+}  // namespace skwr